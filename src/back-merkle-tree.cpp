@@ -15,7 +15,9 @@
 //
 
 #include "back-merkle-tree.h"
+#include "hash-sibling-pairs.h"
 #include <limits>
+#include <utility>
 
 /// \file
 /// \brief Back Merkle tree implementation.
@@ -68,6 +70,47 @@ void back_merkle_tree::push_back(const hash_type &leaf_hash) {
     ++m_leaf_count;
 }
 
+void back_merkle_tree::push_back_range(const std::vector<hash_type> &leaf_hashes) {
+    append_range(leaf_hashes, nullptr);
+}
+
+void back_merkle_tree::push_back_range(const std::vector<hash_type> &leaf_hashes, thread_pool &pool) {
+    append_range(leaf_hashes, &pool);
+}
+
+void back_merkle_tree::append_range(const std::vector<hash_type> &leaf_hashes, thread_pool *pool) {
+    if (leaf_hashes.size() > m_max_leaves - m_leaf_count) {
+        throw std::out_of_range{"too many leaves"};
+    }
+    hasher_type h;
+    const int depth = m_log2_root_size - m_log2_leaf_size;
+    // New nodes in the current level, and their parents in the level above
+    const hash_type *nodes = leaf_hashes.data();
+    uint64_t count = leaf_hashes.size();
+    std::vector<hash_type> level;
+    std::vector<hash_type> parents;
+    for (int i = 0; i <= depth && count > 0; ++i) {
+        // If bit i is set in leaf_count, the first new node is the right
+        // sibling of the complete subtree in context[i]
+        const uint64_t carry = (m_leaf_count >> i) & 1;
+        const hash_type *rest = nodes + carry;
+        const uint64_t rest_count = count - carry;
+        parents.resize(carry + rest_count / 2);
+        if (carry != 0) {
+            get_concat_hash(h, m_context[i], nodes[0], parents[0]);
+        }
+        hash_sibling_pairs(rest, rest_count / 2, parents.data() + carry, pool);
+        // A new node left without a sibling becomes the complete subtree for bit i
+        if (rest_count % 2 != 0) {
+            m_context[i] = rest[rest_count - 1];
+        }
+        std::swap(level, parents);
+        nodes = level.data();
+        count = level.size();
+    }
+    m_leaf_count += leaf_hashes.size();
+}
+
 back_merkle_tree::hash_type back_merkle_tree::get_root_hash(void) const {
     hasher_type h;
     assert(m_leaf_count <= m_max_leaves);
@@ -17,9 +17,12 @@
 #ifndef BACK_MERKLE_TREE_H
 #define BACK_MERKLE_TREE_H
 
+#include <vector>
+
 #include "keccak-256-hasher.h"
 #include "merkle-tree-proof.h"
 #include "pristine-merkle-tree.h"
+#include "thread-pool.h"
 
 /// \file
 /// \brief Back Merkle tree interface.
@@ -87,6 +90,20 @@ public:
     /// log time (log2_root_size-log2_leaf_size)
     void push_back(const hash_type &leaf_hash);
 
+    /// \brief Appends several new hashes to the tree
+    /// \param leaf_hashes Hashes of leaf data, in order
+    /// \details Has the same effect as calling push_back() for each hash,
+    /// but goes up the tree one level at a time, pairing all new nodes in
+    /// each level at once.
+    /// The hashes of all pairs in a level are independent, so they are
+    /// computed in batches.
+    void push_back_range(const std::vector<hash_type> &leaf_hashes);
+
+    /// \brief Appends several new hashes to the tree, using a thread pool
+    /// \param leaf_hashes Hashes of leaf data, in order
+    /// \param pool Thread pool used to hash independent pairs in parallel
+    void push_back_range(const std::vector<hash_type> &leaf_hashes, thread_pool &pool);
+
     /// \brief Returns the root tree hash
     /// \returns Root tree hash
     /// \details
@@ -117,6 +134,11 @@ public:
     proof_type get_next_leaf_proof(void) const;
 
 private:
+    /// \brief Appends several new hashes to the tree
+    /// \param leaf_hashes Hashes of leaf data, in order
+    /// \param pool Thread pool used to hash independent pairs in parallel, or nullptr
+    void append_range(const std::vector<hash_type> &leaf_hashes, thread_pool *pool);
+
     int m_log2_root_size;                   ///< Log<sub>2</sub> of tree size
     int m_log2_leaf_size;                   ///< Log<sub>2</sub> of leaf size
     address_type m_leaf_count;              ///< Number of leaves already added
@@ -0,0 +1,214 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "full-merkle-tree.h"
+#include "thread-pool.h"
+
+using namespace cartesi;
+using hash_type = full_merkle_tree::hash_type;
+
+/// \brief Checks if string matches prefix and captures int that follows
+/// \param pre Prefix to match in str.
+/// \param str Input string
+/// \param val If string matches prefix and conversion to int succeeds, points
+/// to converted int
+/// \returns True if string matches prefix and conversion succeeds,
+/// false otherwise
+static bool intval(const char *pre, const char *str, int *val) {
+    const size_t len = strlen(pre);
+    if (strncmp(pre, str, len) == 0) {
+        str += len;
+        int end = 0;
+        // NOLINTNEXTLINE(cert-err34-c): %n is used toverify conversion errors
+        return sscanf(str, "%d%n", val, &end) == 1 && !str[end];
+    }
+    return false;
+}
+
+/// \brief Checks if string matches prefix and captures uint64_t that follows
+/// \param pre Prefix to match in str.
+/// \param str Input string
+/// \param val If string matches prefix and conversion to uint64_t succeeds, points
+/// to converted uint64_t
+/// \returns True if string matches prefix and conversion succeeds,
+/// false otherwise
+static bool uint64val(const char *pre, const char *str, uint64_t *val) {
+    const size_t len = strlen(pre);
+    if (strncmp(pre, str, len) == 0) {
+        str += len;
+        int end = 0;
+        // NOLINTNEXTLINE(cert-err34-c): %n is used toverify conversion errors
+        return sscanf(str, "%" SCNu64 "%n", val, &end) == 1 && !str[end];
+    }
+    return false;
+}
+
+/// \brief Prints hash in hex to file
+/// \param hash Hash to be printed.
+/// \param f File to print to
+static void print_hash(const hash_type &hash, FILE *f) {
+    for (auto b : hash) {
+        (void) fprintf(f, "%02x", static_cast<int>(b));
+    }
+    (void) fprintf(f, "\n");
+}
+
+/// \brief Prints formatted message to stderr
+/// \param fmt Format string
+/// \param ... Arguments, if any
+// NOLINTNEXTLINE(cert-dcl50-cpp): this vararg is safe because the compiler can check the format
+__attribute__((format(printf, 1, 2))) static void error(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    (void) vfprintf(stderr, fmt, ap);
+    va_end(ap);
+    exit(1);
+}
+
+/// \brief Fills leaf hashes with arbitrary but reproducible contents
+/// \param leaves Leaf hashes to fill
+static void fill_leaves(std::vector<hash_type> &leaves) {
+    // splitmix64
+    uint64_t state = 0;
+    for (auto &leaf : leaves) {
+        for (size_t i = 0; i < leaf.size(); i += sizeof(uint64_t)) {
+            state += UINT64_C(0x9e3779b97f4a7c15);
+            uint64_t z = state;
+            z = (z ^ (z >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+            z = (z ^ (z >> 27)) * UINT64_C(0x94d049bb133111eb);
+            z ^= z >> 31;
+            memcpy(leaf.data() + i, &z, sizeof(z));
+        }
+    }
+}
+
+/// \brief Returns the number of seconds elapsed since a given time
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/// \brief Prints help message
+static void help(const char *name) {
+    (void) fprintf(stderr,
+        "Usage:\n  %s [--log2-word-size=<w>] [--log2-leaf-size=<p>] "
+        "[--log2-root-size=<t>] [--leaf-count=<n>] [--threads=<n>] [--repeat=<n>]\n\n"
+        "Builds full Merkle trees from <n> arbitrary leaf hashes (default: all leaves)\n"
+        "using one thread and using <n> threads (default: number of hardware threads),\n"
+        "and prints the best time of <n> repetitions (default: 3) for each.\n",
+        name);
+    exit(0);
+}
+
+int main(int argc, char *argv[]) try {
+    int log2_word_size = 5;
+    int log2_leaf_size = 5;
+    int log2_root_size = 25;
+    int repeat = 3;
+    uint64_t leaf_count = UINT64_MAX;
+    uint64_t threads = std::thread::hardware_concurrency();
+    // Process command line arguments
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--help") == 0) {
+            help(argv[0]);
+            return 1;
+        } else if (intval("--log2-word-size=", argv[i], &log2_word_size)) {
+            ;
+        } else if (intval("--log2-leaf-size=", argv[i], &log2_leaf_size)) {
+            ;
+        } else if (intval("--log2-root-size=", argv[i], &log2_root_size)) {
+            ;
+        } else if (uint64val("--leaf-count=", argv[i], &leaf_count)) {
+            ;
+        } else if (uint64val("--threads=", argv[i], &threads)) {
+            ;
+        } else if (intval("--repeat=", argv[i], &repeat)) {
+            ;
+        } else {
+            error("unrecognized option '%s'\n", argv[i]);
+            return 1;
+        }
+    }
+    if (log2_word_size < 0 || log2_word_size > 64 || log2_leaf_size < log2_word_size || log2_leaf_size >= 64 ||
+        log2_leaf_size > log2_root_size || log2_root_size >= 64) {
+        error("invalid word size (%d) / leaf size (%d) / root size (%d) combination\n", log2_word_size, log2_leaf_size,
+            log2_root_size);
+        return 1;
+    }
+    const uint64_t max_leaves = UINT64_C(1) << (log2_root_size - log2_leaf_size);
+    if (leaf_count == UINT64_MAX) {
+        leaf_count = max_leaves;
+    }
+    if (leaf_count > max_leaves) {
+        error("too many leaves for tree\n");
+        return 1;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
+    if (repeat < 1) {
+        error("invalid number of repetitions (%d)\n", repeat);
+        return 1;
+    }
+
+    std::vector<hash_type> leaves(leaf_count);
+    fill_leaves(leaves);
+
+    thread_pool pool{threads};
+    double serial_seconds = 0;
+    double parallel_seconds = 0;
+    hash_type serial_root_hash{};
+    hash_type parallel_root_hash{};
+    for (int i = 0; i < repeat; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        const full_merkle_tree serial_tree{log2_root_size, log2_leaf_size, log2_word_size, leaves};
+        const double serial_elapsed = seconds_since(start);
+        serial_root_hash = serial_tree.get_root_hash();
+        start = std::chrono::steady_clock::now();
+        const full_merkle_tree parallel_tree{log2_root_size, log2_leaf_size, log2_word_size, leaves, pool};
+        const double parallel_elapsed = seconds_since(start);
+        parallel_root_hash = parallel_tree.get_root_hash();
+        if (i == 0 || serial_elapsed < serial_seconds) {
+            serial_seconds = serial_elapsed;
+        }
+        if (i == 0 || parallel_elapsed < parallel_seconds) {
+            parallel_seconds = parallel_elapsed;
+        }
+    }
+    if (serial_root_hash != parallel_root_hash) {
+        error("mismatch in root hash for serial and parallel trees\n");
+        return 1;
+    }
+    const double nodes = static_cast<double>(2 * max_leaves - 1);
+    (void) fprintf(stderr, "leaves: %" PRIu64 " of %" PRIu64 "\n", leaf_count, max_leaves);
+    (void) fprintf(stderr, "1 thread: %.3fs (%.1f Mnodes/s)\n", serial_seconds, nodes / serial_seconds / 1e6);
+    (void) fprintf(stderr, "%" PRIu64 " threads: %.3fs (%.1f Mnodes/s, %.2fx)\n", threads, parallel_seconds,
+        nodes / parallel_seconds / 1e6, serial_seconds / parallel_seconds);
+    print_hash(parallel_root_hash, stdout);
+    return 0;
+} catch (std::exception &x) {
+    (void) fprintf(stderr, "Caught exception: %s\n", x.what());
+    exit(1);
+}
@@ -255,10 +255,91 @@ where options are:
         when omitted or defined as 0, the number of hardware threads is used if
         it can be identified or else a single thread is used.
 
+  --host-tlb=<key>:<value>[,<key>:<value>[,...]...]
+    configures the geometry of the host-side cache of page table walks
+    consulted on TLB misses. it does not affect the machine state.
+
+    <key>:<value> is one of
+        sets:<number>
+        ways:<number>
+
+        sets (optional)
+        number of sets, which must be a power of 2.
+        when omitted or defined as 0, a default value is used.
+
+        ways (optional)
+        number of entries in each set, which must be a power of 2.
+        when omitted or defined as 0, a default value is used.
+
+  --hasher-backend=<backend>
+    selects the Keccak-256 implementation this process uses to hash
+    Merkle trees. all implementations produce the same hashes.
+    remote machines are not affected.
+
+    <backend> is one of
+        auto
+        generic
+        simd
+        avx2
+
+        auto (default)
+        fastest implementation supported by the host.
+
+        generic
+        hashes one message at a time using only 64-bit integer instructions.
+
+        simd
+        hashes several messages at a time using the vector instructions
+        the emulator was compiled for.
+
+        avx2
+        hashes several messages at a time using AVX2 instructions
+        (x86-64 hosts that support them only).
+
+  --page-hash-cache=<number>
+    number of page hashes to cache by page contents, so pages identical to
+    pages hashed recently are not hashed again when updating the Merkle tree.
+    must be a power of 2. each entry keeps a copy of its page.
+    (default: 0, which disables the cache)
+
   --htif-no-console-putchar
     suppress any console output during machine run,
     this includes anything written to machine's stdout or stderr.
 
+  --merkle-cache
+    store the hashes of all memory pages next to the stored machine (see --store),
+    and use them when loading a stored machine (see --load), so pages are not hashed
+    again. like --skip-root-hash-check, this trusts the stored directory: images
+    modified after the machine was stored are not detected.
+
+  --store-direct-io
+    bypass the operating system page cache when storing the machine (see --store),
+    writing large aligned blocks directly to the device, if the file system supports it.
+
+  --store-compressed
+    store memory ranges as compressed images when storing the machine (see --store).
+    chunks of each range are compressed in parallel, and decompressed in parallel
+    when the machine is loaded.
+
+  --image-prefault=<policy>
+    selects how the pages of memory range images are brought into memory.
+    images are mapped copy-on-write, so machines loaded from the same images
+    share their unmodified pages.
+
+    <policy> is one of
+        none
+        willneed
+        populate
+
+        none (default)
+        each page is read from its image when first accessed.
+
+        willneed
+        pages are read ahead in the background while the machine starts.
+
+        populate
+        all pages are read before the machine is created.
+
   --skip-root-hash-check
     skip merkle tree root hash check when loading a stored machine,
     assuming the stored machine files are not corrupt,
@@ -295,6 +376,11 @@ where options are:
     store machine to <directory>, where "%%h" is substituted by the
     state hash in the directory name.
 
+  --store-delta
+    store only the memory pages changed since the machine was loaded
+    (see --load and --store). loading the stored machine also reads
+    the directory it was loaded from, so that directory must be kept.
+
   --load=<directory>
     load machine previously stored in <directory>.
 
@@ -409,6 +495,14 @@ local uarch
 local rollup_advance
 local rollup_inspect
 local concurrency_update_merkle_tree = 0
+local host_tlb_sets = 0
+local host_tlb_ways = 0
+local hasher_backend = "auto"
+local page_hash_cache_entries = 0
+local merkle_cache = false
+local store_direct_io = false
+local store_compressed = false
+local image_prefault = "none"
 local skip_root_hash_check = false
 local skip_version_check = false
 local append_rom_bootargs = ""
@@ -429,6 +523,7 @@ local max_uarch_cycle = 0
 local auto_reset_uarch_state = false
 local step_uarch = false
 local store_dir
+local store_delta = false
 local load_dir
 local cmdline_opts_finished = false
 local store_config = false
@@ -759,6 +854,39 @@ local options = {
             return true
         end,
     },
+    {
+        "^(%-%-host%-tlb%=(.+))$",
+        function(all, opts)
+            if not opts then return false end
+            local t = util.parse_options(opts, {
+                sets = true,
+                ways = true,
+            })
+            host_tlb_sets = assert(util.parse_number(t.sets or "0"), "invalid sets number in " .. all)
+            host_tlb_ways = assert(util.parse_number(t.ways or "0"), "invalid ways number in " .. all)
+            return true
+        end,
+    },
+    {
+        "^(%-%-hasher%-backend%=(.+))$",
+        function(all, backend)
+            if not backend then return false end
+            assert(
+                backend == "auto" or backend == "generic" or backend == "simd" or backend == "avx2",
+                "invalid hasher backend in " .. all
+            )
+            hasher_backend = backend
+            return true
+        end,
+    },
+    {
+        "^(%-%-page%-hash%-cache%=(.+))$",
+        function(all, entries)
+            if not entries then return false end
+            page_hash_cache_entries = assert(util.parse_number(entries), "invalid number of entries in " .. all)
+            return true
+        end,
+    },
     {
         "^%-%-htif%-no%-console%-putchar$",
         function(all)
@@ -767,6 +895,42 @@ local options = {
             return true
         end,
     },
+    {
+        "^%-%-merkle%-cache$",
+        function(all)
+            if not all then return false end
+            merkle_cache = true
+            return true
+        end,
+    },
+    {
+        "^%-%-store%-direct%-io$",
+        function(all)
+            if not all then return false end
+            store_direct_io = true
+            return true
+        end,
+    },
+    {
+        "^%-%-store%-compressed$",
+        function(all)
+            if not all then return false end
+            store_compressed = true
+            return true
+        end,
+    },
+    {
+        "^(%-%-image%-prefault%=(.+))$",
+        function(all, policy)
+            if not policy then return false end
+            assert(
+                policy == "none" or policy == "willneed" or policy == "populate",
+                "invalid image prefault policy in " .. all
+            )
+            image_prefault = policy
+            return true
+        end,
+    },
     {
         "^%-%-skip%-root%-hash%-check$",
         function(all)
@@ -904,6 +1068,14 @@ local options = {
             return true
         end,
     },
+    {
+        "^%-%-store%-delta$",
+        function(all)
+            if not all then return false end
+            store_delta = true
+            return true
+        end,
+    },
     {
         "^%-%-remote%-address%=(.*)$",
         function(o)
@@ -1322,10 +1494,26 @@ local runtime = {
     htif = {
         no_console_putchar = htif_no_console_putchar,
     },
+    tlb = {
+        sets = host_tlb_sets,
+        ways = host_tlb_ways,
+    },
+    hasher = {
+        page_cache_entries = page_hash_cache_entries,
+    },
+    merkle_cache = merkle_cache,
+    store_direct_io = store_direct_io,
+    store_compressed = store_compressed,
+    image_prefault = image_prefault,
     skip_root_hash_check = skip_root_hash_check,
     skip_version_check = skip_version_check,
 }
 
+-- The hasher backend is shared by all local machines in this process, so it is selected before any is created
+if hasher_backend ~= "auto" then cartesi.set_hasher_backend(hasher_backend) end
+
+assert(not store_delta or load_dir, "option --store-delta requires --load")
+
 local main_machine
 if remote and not remote_create then
     main_machine = remote.get_machine()
@@ -1598,7 +1786,11 @@ local function store_machine(machine, config, dir)
     stderr("Storing machine: please wait\n")
     local h = util.hexhash(machine:get_root_hash())
     local name = instantiate_filename(dir, { h = h })
-    machine:store(name)
+    if store_delta then
+        machine:store_delta(name, load_dir)
+    else
+        machine:store(name)
+    end
 end
 
 local machine = main_machine
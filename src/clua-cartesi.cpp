@@ -82,9 +82,20 @@ static int cartesi_mod_keccak(lua_State *L) {
     }
 }
 
+/// \brief This is the cartesi.set_hasher_backend() function implementation.
+/// \param L Lua state.
+static int cartesi_mod_set_hasher_backend(lua_State *L) {
+    // Names are listed in the order of CM_HASHER_BACKEND
+    static const std::array<const char *, 5> names{"auto", "generic", "simd", "avx2", nullptr};
+    const auto backend = static_cast<CM_HASHER_BACKEND>(luaL_checkoption(L, 1, nullptr, names.data()));
+    TRY_EXECUTE(cm_set_hasher_backend(backend, err_msg));
+    return 0;
+}
+
 /// \brief Contents of the cartesi module table.
 static const auto cartesi_mod = cartesi::clua_make_luaL_Reg_array({
     {"keccak", cartesi_mod_keccak},
+    {"set_hasher_backend", cartesi_mod_set_hasher_backend},
 });
 
 extern "C" {
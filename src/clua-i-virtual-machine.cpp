@@ -55,6 +55,22 @@ static int machine_obj_index_get_proof(lua_State *L) {
     return 1;
 }
 
+/// \brief This is the machine:get_proofs() method implementation.
+/// \param L Lua state.
+static int machine_obj_index_get_proofs(lua_State *L) {
+    lua_settop(L, 2);
+    auto &m = clua_check<clua_managed_cm_ptr<cm_machine>>(L, 1);
+    size_t count = 0;
+    auto &managed_targets =
+        clua_push_to(L, clua_managed_cm_ptr<cm_merkle_tree_target>(clua_check_cm_merkle_tree_targets(L, 2, &count)));
+    auto &managed_multiproof = clua_push_to(L, clua_managed_cm_ptr<cm_merkle_tree_multiproof>(nullptr));
+    TRY_EXECUTE(cm_get_proofs(m.get(), managed_targets.get(), count, &managed_multiproof.get(), err_msg));
+    clua_push_cm_multiproof(L, managed_multiproof.get());
+    managed_multiproof.reset();
+    managed_targets.reset();
+    return 1;
+}
+
 static int machine_obj_index_get_initial_config(lua_State *L) {
     auto &m = clua_check<clua_managed_cm_ptr<cm_machine>>(L, 1);
     auto &managed_config = clua_push_to(L, clua_managed_cm_ptr<const cm_machine_config>(nullptr));
@@ -395,6 +411,14 @@ static int machine_obj_index_store(lua_State *L) {
     return 0;
 }
 
+/// \brief This is the machine:store_delta() method implementation.
+/// \param L Lua state.
+static int machine_obj_index_store_delta(lua_State *L) {
+    auto &m = clua_check<clua_managed_cm_ptr<cm_machine>>(L, 1);
+    TRY_EXECUTE(cm_store_delta(m.get(), luaL_checkstring(L, 2), luaL_checkstring(L, 3), err_msg));
+    return 0;
+}
+
 /// \brief This is the machine:verify_dirty_page_maps() method implementation.
 /// \param L Lua state.
 static int machine_obj_index_verify_dirty_page_maps(lua_State *L) {
@@ -532,6 +556,7 @@ static int machine_obj_index_rollback(lua_State *L) {
 static const auto machine_obj_index = cartesi::clua_make_luaL_Reg_array({
     {"dump_pmas", machine_obj_index_dump_pmas},
     {"get_proof", machine_obj_index_get_proof},
+    {"get_proofs", machine_obj_index_get_proofs},
     {"get_initial_config", machine_obj_index_get_initial_config},
     {"get_root_hash", machine_obj_index_get_root_hash},
     {"read_clint_mtimecmp", machine_obj_index_read_clint_mtimecmp},
@@ -595,6 +620,7 @@ static const auto machine_obj_index = cartesi::clua_make_luaL_Reg_array({
     {"run_uarch", machine_obj_index_run_uarch},
     {"step_uarch", machine_obj_index_step_uarch},
     {"store", machine_obj_index_store},
+    {"store_delta", machine_obj_index_store_delta},
     {"verify_dirty_page_maps", machine_obj_index_verify_dirty_page_maps},
     {"verify_merkle_tree", machine_obj_index_verify_merkle_tree},
     {"write_clint_mtimecmp", machine_obj_index_write_clint_mtimecmp},
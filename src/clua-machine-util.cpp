@@ -75,6 +75,18 @@ void cm_delete(cm_merkle_tree_proof *ptr) {
     cm_delete_merkle_tree_proof(ptr);
 }
 
+/// \brief Deleter for C api merkle tree multiproof
+template <>
+void cm_delete(cm_merkle_tree_multiproof *ptr) {
+    cm_delete_merkle_tree_multiproof(ptr);
+}
+
+/// \brief Deleter for C api merkle tree target array
+template <>
+void cm_delete(cm_merkle_tree_target *ptr) {
+    delete[] ptr;
+}
+
 /// \brief Deleter for C api memory range config
 template <>
 void cm_delete(cm_memory_range_config *ptr) {
@@ -144,7 +156,6 @@ static uint64_t opt_uint_field(lua_State *L, int tabidx, const char *field, uint
     return static_cast<uint64_t>(val);
 }
 
-#if 0 // Unused
 /// \brief Returns an optional string field indexed by string in a table.
 /// \param L Lua state.
 /// \param tabidx Table stack index.
@@ -162,7 +173,6 @@ static std::string opt_string_field(lua_State *L, int tabidx, const char *field)
     lua_pop(L, 1);
     return str;
 }
-#endif
 
 /// \brief Returns an allocated optional c string field indexed by string in a table.
 /// \param L Lua state.
@@ -300,6 +310,25 @@ static CM_ACCESS_TYPE check_cm_access_type_field(lua_State *L, int tabidx, const
     }
 }
 
+/// \brief Returns an optional CM_IMAGE_PREFAULT table field indexed by string in a table
+/// \param L Lua state
+/// \param tabidx Table stack index
+/// \param field Field index
+/// \returns Corresponding CM_IMAGE_PREFAULT, or CM_IMAGE_PREFAULT_NONE if missing
+static CM_IMAGE_PREFAULT opt_cm_image_prefault_field(lua_State *L, int tabidx, const char *field) {
+    auto name = opt_string_field(L, tabidx, field);
+    if (name.empty() || name == "none") {
+        return CM_IMAGE_PREFAULT_NONE;
+    } else if (name == "willneed") {
+        return CM_IMAGE_PREFAULT_WILLNEED;
+    } else if (name == "populate") {
+        return CM_IMAGE_PREFAULT_POPULATE;
+    } else {
+        luaL_error(L, "invalid %s (expected image prefault policy)", field);
+        return CM_IMAGE_PREFAULT_NONE; // never reached
+    }
+}
+
 /// \brief Returns an CM_BRACKET_TYPE table field indexed by string in a table.
 /// \param L Lua state
 /// \param tabidx Table stack index
@@ -375,6 +404,28 @@ cm_merkle_tree_proof *clua_check_cm_merkle_tree_proof(lua_State *L, int tabidx,
     return proof;
 }
 
+cm_merkle_tree_target *clua_check_cm_merkle_tree_targets(lua_State *L, int tabidx, size_t *count, int ctxidx) {
+    tabidx = lua_absindex(L, tabidx);
+    luaL_checktype(L, tabidx, LUA_TTABLE);
+    const auto n = static_cast<size_t>(luaL_len(L, tabidx));
+    auto &managed =
+        clua_push_to(L, clua_managed_cm_ptr<cm_merkle_tree_target>(new cm_merkle_tree_target[n]{}), ctxidx);
+    cm_merkle_tree_target *targets = managed.get();
+    for (size_t i = 1; i <= n; ++i) {
+        lua_geti(L, tabidx, static_cast<lua_Integer>(i));
+        if (!lua_istable(L, -1)) {
+            luaL_error(L, "invalid target [%d] (expected table)", static_cast<int>(i));
+        }
+        targets[i - 1].address = check_uint_field(L, -1, "address");
+        targets[i - 1].log2_size = static_cast<int>(check_uint_field(L, -1, "log2_size"));
+        lua_pop(L, 1);
+    }
+    managed.release();
+    lua_pop(L, 1);
+    *count = n;
+    return targets;
+}
+
 /// \brief Returns an access data field indexed by string in a table
 /// \param L Lua state
 /// \param tabidx Table stack index
@@ -693,6 +744,31 @@ void clua_push_cm_proof(lua_State *L, const cm_merkle_tree_proof *proof) {
     lua_setfield(L, -2, "target_hash"); // proof
 }
 
+/// \brief Pushes an array of C api multiproof nodes as a table
+static void push_cm_merkle_tree_node_array(lua_State *L, const cm_merkle_tree_node_array *nodes) {
+    lua_createtable(L, static_cast<int>(nodes->count), 0); // nodes
+    for (size_t i = 0; i < nodes->count; ++i) {
+        const auto &node = nodes->entry[i];
+        lua_newtable(L);                                          // nodes node
+        clua_setintegerfield(L, node.address, "address", -1);     // nodes node
+        clua_setintegerfield(L, node.log2_size, "log2_size", -1); // nodes node
+        clua_push_cm_hash(L, &node.hash);                         // nodes node hash
+        lua_setfield(L, -2, "hash");                              // nodes node
+        lua_rawseti(L, -2, static_cast<lua_Integer>(i + 1));      // nodes
+    }
+}
+
+void clua_push_cm_multiproof(lua_State *L, const cm_merkle_tree_multiproof *multiproof) {
+    lua_newtable(L);                                                            // multiproof
+    clua_setintegerfield(L, multiproof->log2_root_size, "log2_root_size", -1); // multiproof
+    clua_push_cm_hash(L, &multiproof->root_hash);
+    lua_setfield(L, -2, "root_hash"); // multiproof
+    push_cm_merkle_tree_node_array(L, &multiproof->targets);
+    lua_setfield(L, -2, "targets"); // multiproof
+    push_cm_merkle_tree_node_array(L, &multiproof->siblings);
+    lua_setfield(L, -2, "siblings"); // multiproof
+}
+
 cm_access_log_type clua_check_cm_log_type(lua_State *L, int tabidx) {
     luaL_checktype(L, tabidx, LUA_TTABLE);
     return cm_access_log_type{opt_boolean_field(L, tabidx, "proofs"), opt_boolean_field(L, tabidx, "annotations")};
@@ -1242,6 +1318,31 @@ static void check_cm_htif_runtime_config(lua_State *L, int tabidx, cm_htif_runti
     lua_pop(L, 1);
 }
 
+/// \brief Loads C api TLB runtime config from Lua
+/// \param L Lua state
+/// \param tabidx Runtime config stack index
+/// \param c C api TLB runtime config structure to receive results
+static void check_cm_tlb_runtime_config(lua_State *L, int tabidx, cm_tlb_runtime_config *c) {
+    if (!opt_table_field(L, tabidx, "tlb")) {
+        return;
+    }
+    c->sets = opt_uint_field(L, -1, "sets");
+    c->ways = opt_uint_field(L, -1, "ways");
+    lua_pop(L, 1);
+}
+
+/// \brief Loads C api hasher runtime config from Lua
+/// \param L Lua state
+/// \param tabidx Runtime config stack index
+/// \param c C api hasher runtime config structure to receive results
+static void check_cm_hasher_runtime_config(lua_State *L, int tabidx, cm_hasher_runtime_config *c) {
+    if (!opt_table_field(L, tabidx, "hasher")) {
+        return;
+    }
+    c->page_cache_entries = opt_uint_field(L, -1, "page_cache_entries");
+    lua_pop(L, 1);
+}
+
 cm_machine_runtime_config *clua_check_cm_machine_runtime_config(lua_State *L, int tabidx, int ctxidx) {
     luaL_checktype(L, tabidx, LUA_TTABLE);
     auto &managed =
@@ -1249,6 +1350,12 @@ cm_machine_runtime_config *clua_check_cm_machine_runtime_config(lua_State *L, in
     cm_machine_runtime_config *config = managed.get();
     check_cm_concurrency_runtime_config(L, tabidx, &config->concurrency);
     check_cm_htif_runtime_config(L, tabidx, &config->htif);
+    check_cm_tlb_runtime_config(L, tabidx, &config->tlb);
+    check_cm_hasher_runtime_config(L, tabidx, &config->hasher);
+    config->merkle_cache = opt_boolean_field(L, tabidx, "merkle_cache");
+    config->store_direct_io = opt_boolean_field(L, tabidx, "store_direct_io");
+    config->store_compressed = opt_boolean_field(L, tabidx, "store_compressed");
+    config->image_prefault = opt_cm_image_prefault_field(L, tabidx, "image_prefault");
     config->skip_root_hash_check = opt_boolean_field(L, tabidx, "skip_root_hash_check");
     config->skip_version_check = opt_boolean_field(L, tabidx, "skip_version_check");
     managed.release();
@@ -88,6 +88,14 @@ void cm_delete(cm_access_log *ptr);
 template <>
 void cm_delete(cm_merkle_tree_proof *p);
 
+/// \brief Deleter for C api merkle tree multiproof
+template <>
+void cm_delete(cm_merkle_tree_multiproof *p);
+
+/// \brief Deleter for C api merkle tree target array
+template <>
+void cm_delete(cm_merkle_tree_target *p);
+
 /// \brief Deleter for C api flash drive config
 template <>
 void cm_delete(cm_memory_range_config *p);
@@ -160,6 +168,11 @@ private:
 /// \param proof Proof to be pushed
 void clua_push_cm_proof(lua_State *L, const cm_merkle_tree_proof *proof);
 
+/// \brief Pushes a C api multiproof to the Lua stack
+/// \param L Lua state
+/// \param multiproof Multiproof to be pushed
+void clua_push_cm_multiproof(lua_State *L, const cm_merkle_tree_multiproof *multiproof);
+
 /// \brief Pushes a cm_semantic_version to the Lua stack
 /// \param L Lua state
 /// \param v C api semantic version to be pushed
@@ -211,6 +224,15 @@ void clua_check_cm_hash(lua_State *L, int idx, cm_hash *c_hash);
 /// \returns The allocated proof object
 cm_merkle_tree_proof *clua_check_cm_merkle_tree_proof(lua_State *L, int tabidx);
 
+/// \brief Loads an array of cm_merkle_tree_target from Lua
+/// \param L Lua state
+/// \param tabidx Targets stack index
+/// \param count Receives the number of targets
+/// \param ctxidx Index of clua context
+/// \returns The allocated target array. Must be deleted by the user with delete[]
+cm_merkle_tree_target *clua_check_cm_merkle_tree_targets(lua_State *L, int tabidx, size_t *count,
+    int ctxidx = lua_upvalueindex(1));
+
 /// \brief Loads an cm_access_log from Lua.
 /// \param L Lua state
 /// \param tabidx Access_log stack index.
@@ -15,6 +15,7 @@
 //
 
 #include "complete-merkle-tree.h"
+#include "hash-sibling-pairs.h"
 
 /// \file
 /// \brief Complete Merkle tree implementation.
@@ -60,7 +61,24 @@ void complete_merkle_tree::push_back(const hash_type &hash) {
         throw std::out_of_range{"tree is full"};
     }
     leaves.push_back(hash);
-    bubble_up();
+    bubble_up(nullptr);
+}
+
+void complete_merkle_tree::push_back_range(const level_type &hashes) {
+    append_range(hashes, nullptr);
+}
+
+void complete_merkle_tree::push_back_range(const level_type &hashes, thread_pool &pool) {
+    append_range(hashes, &pool);
+}
+
+void complete_merkle_tree::append_range(const level_type &hashes, thread_pool *pool) {
+    auto &leaves = get_level(get_log2_leaf_size());
+    if (hashes.size() > (address_type{1} << (get_log2_root_size() - get_log2_leaf_size())) - leaves.size()) {
+        throw std::out_of_range{"tree is full"};
+    }
+    leaves.insert(leaves.end(), hashes.begin(), hashes.end());
+    bubble_up(pool);
 }
 
 void complete_merkle_tree::check_log2_sizes(int log2_root_size, int log2_leaf_size, int log2_word_size) {
@@ -97,7 +115,7 @@ const complete_merkle_tree::hash_type &complete_merkle_tree::get_node_hash(addre
     }
 }
 
-void complete_merkle_tree::bubble_up(void) {
+void complete_merkle_tree::bubble_up(thread_pool *pool) {
     hasher_type h;
     // Go bottom up, updating hashes
     for (int log2_next_size = get_log2_leaf_size() + 1; log2_next_size <= get_log2_root_size(); ++log2_next_size) {
@@ -114,8 +132,8 @@ void complete_merkle_tree::bubble_up(void) {
         // Last safe entry has two non-pristine leafs
         auto last_safe_entry = prev.size() / 2;
         // Do all entries for which we have two non-pristine children
-        for (; first_entry < last_safe_entry; ++first_entry) {
-            get_concat_hash(h, prev[2 * first_entry], prev[2 * first_entry + 1], next[first_entry]);
+        if (first_entry < last_safe_entry) {
+            hash_sibling_pairs(&prev[2 * first_entry], last_safe_entry - first_entry, &next[first_entry], pool);
         }
         // Maybe do last odd entry
         if (prev.size() > 2 * last_safe_entry) {
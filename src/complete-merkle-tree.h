@@ -21,6 +21,7 @@
 #include "merkle-tree-proof.h"
 #include "meta.h"
 #include "pristine-merkle-tree.h"
+#include "thread-pool.h"
 
 /// \file
 /// \brief Complete Merkle tree interface.
@@ -64,7 +65,7 @@ public:
         complete_merkle_tree{log2_root_size, log2_leaf_size, log2_word_size} {
         static_assert(std::is_same<level_type, typename remove_cvref<L>::type>::value, "not a leaves vector");
         get_level(get_log2_leaf_size()) = std::forward<L>(leaves);
-        bubble_up();
+        bubble_up(nullptr);
     }
 
     /// \brief Returns the tree's root hash
@@ -88,6 +89,17 @@ public:
     /// \param hash Hash to append
     void push_back(const hash_type &hash);
 
+    /// \brief Appends several new leaf hashes to the tree
+    /// \param hashes Hashes to append, in order
+    /// \details Each level is updated only once for all new hashes, so this
+    /// is much faster than calling push_back() for each hash.
+    void push_back_range(const level_type &hashes);
+
+    /// \brief Appends several new leaf hashes to the tree, using a thread pool
+    /// \param hashes Hashes to append, in order
+    /// \param pool Thread pool used to hash independent pairs in parallel
+    void push_back_range(const level_type &hashes, thread_pool &pool);
+
     /// \brief Returns number of leaves in tree
     address_type size(void) const {
         return get_level(get_log2_leaf_size()).size();
@@ -111,9 +123,15 @@ private:
         return m_log2_leaf_size;
     }
 
+    /// \brief Appends several new leaf hashes to the tree
+    /// \param hashes Hashes to append, in order
+    /// \param pool Thread pool used to hash independent pairs in parallel, or nullptr
+    void append_range(const level_type &hashes, thread_pool *pool);
+
     /// \brief Update node hashes when a new set of non-pristine nodes is added
     /// to the leaf level
-    void bubble_up(void);
+    /// \param pool Thread pool used to hash independent pairs in parallel, or nullptr
+    void bubble_up(thread_pool *pool);
 
     ///< \brief Returns hashes at a given level
     ///< \param log2_size Log<sub>2</sub> of size subintended by each
@@ -18,6 +18,7 @@
 #define CRYPTOPP_KECCAK_256_HASHER_H
 
 #include "i-hasher.h"
+#include "keccak-256-batch.h"
 #include <cryptopp/keccak.h>
 #include <type_traits>
 
@@ -42,6 +43,15 @@ class cryptopp_keccak_256_hasher final :
         return kc.Final(hash.data());
     }
 
+    void do_hash_batch(const unsigned char *data, size_t length, size_t count, hash_type *hashes) {
+        static_assert(sizeof(hash_type) == hash_size, "hashes must be contiguous");
+        // Messages that fit in a single block are hashed several at a time
+        if (length <= KECCAK_256_BATCH_MAX_LENGTH) {
+            return keccak_256_hash_batch(data, length, count, hashes->data());
+        }
+        return i_hasher::do_hash_batch(data, length, count, hashes);
+    }
+
 public:
     /// \brief Default constructor
     cryptopp_keccak_256_hasher(void) = default;
@@ -0,0 +1,54 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "decode-cache.h"
+
+#include <utility>
+
+namespace cartesi {
+
+void decode_cache::clear(void) {
+    m_pages.clear();
+    m_code_pages.fill(nullptr);
+    m_write_pages.fill(nullptr);
+}
+
+decoded_page *decode_cache::find_or_create_page(const shadow_tlb_state &tlb, uint64_t paddr_page) {
+    auto it = m_pages.find(paddr_page);
+    if (it != m_pages.end()) {
+        return it->second.get();
+    }
+    // Keep memory usage bounded by starting over when the cache is full
+    if (m_pages.size() >= max_pages) {
+        clear();
+    }
+    auto page = std::make_unique<decoded_page>();
+    page->paddr_page = paddr_page;
+    page->generation = m_generation;
+    page->write_refs = 0;
+    page->version = 1;
+    page->insns.fill(decoded_insn{});
+    // Account for write TLB entries that already map the page
+    for (uint64_t i = 0; i < PMA_TLB_SIZE; ++i) {
+        if (tlb.hot[TLB_WRITE][i].vaddr_page != TLB_INVALID_PAGE && tlb.cold[TLB_WRITE][i].paddr_page == paddr_page) {
+            ++page->write_refs;
+            m_write_pages[i] = page.get();
+        }
+    }
+    return m_pages.emplace(paddr_page, std::move(page)).first->second.get();
+}
+
+} // namespace cartesi
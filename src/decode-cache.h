@@ -0,0 +1,178 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef DECODE_CACHE_H
+#define DECODE_CACHE_H
+
+/// \file
+/// \brief Decoded instruction cache.
+/// \details The decoded instruction cache remembers, for each physical page the interpreter executes from,
+/// which handler executes the instruction starting at each 2-byte aligned offset.
+/// It lives outside of the machine state, so it does not affect the state hash.
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+#include "interpret.h"
+#include "pma-constants.h"
+#include "shadow-tlb.h"
+
+namespace cartesi {
+
+/// \brief Handler that executes a decoded instruction.
+/// \details Unlike execute_insn(), the handler takes pc and mcycle by value and returns the new pc,
+/// so the interpreter loop can keep them in registers across the indirect call.
+/// It also receives the offset from virtual addresses to host pointers of the page being executed,
+/// so handlers for fused pairs can read the instruction that follows.
+using decoded_insn_handler = std::pair<execute_status, uint64_t> (*)(state_access &a, uint64_t pc, uint64_t mcycle,
+    uint32_t insn, uint64_t vh_offset);
+
+/// \brief Decoded instruction slot.
+/// \details With computed goto dispatch, target selects the code that executes the instruction.
+/// Otherwise, target counts the instructions that follow this one and are executed by the same handler.
+struct decoded_insn final {
+    decoded_insn_handler handler; ///< Handler for instruction, or nullptr if it must go through execute_insn()
+    uint32_t insn;                ///< Instruction (2 most significant bytes cleared for compressed instructions)
+    uint16_t version;             ///< Slot is valid only when this matches the version of its page
+    uint16_t target;              ///< Dispatch target, or number of instructions fused into handler
+};
+
+/// \brief Decoded instructions of a physical page.
+struct decoded_page final {
+    uint64_t paddr_page; ///< Target physical address of page start
+    uint64_t generation; ///< Cache generation in which slots were decoded
+    uint64_t write_refs; ///< Number of write TLB entries currently mapping the page
+    uint16_t version;    ///< Current version of slots, bumped whenever slots are discarded
+    std::array<decoded_insn, PMA_PAGE_SIZE / 2> insns; ///< One slot per 2-byte aligned offset within the page
+};
+
+/// \class decode_cache
+/// \brief Cache of decoded instructions, indexed by physical page.
+/// \details Slots of a page are only filled while no write TLB entry maps the page.
+/// Every store that goes through the write TLB is therefore guaranteed to hit a page with no decoded slots.
+/// When a write TLB entry is replaced with a page that has decoded slots, its slots are discarded.
+/// Stores that bypass the TLB (e.g., from the host) must explicitly invalidate the affected pages.
+class decode_cache final {
+public:
+    /// \brief Maximum number of pages kept in cache before it is cleared
+    static constexpr size_t max_pages = 256;
+
+    decode_cache() = default;
+
+    /// \brief No copy constructor
+    decode_cache(const decode_cache &) = delete;
+    /// \brief No copy assignment
+    decode_cache &operator=(const decode_cache &) = delete;
+    /// \brief No move constructor
+    decode_cache(decode_cache &&) = delete;
+    /// \brief No move assignment
+    decode_cache &operator=(decode_cache &&) = delete;
+    /// \brief Default destructor
+    ~decode_cache() = default;
+
+    /// \brief Obtains the decoded page for a code TLB entry.
+    /// \param tlb TLB state.
+    /// \param eidx Index of code TLB entry.
+    /// \param vaddr_page Virtual address of page that must be mapped by the entry.
+    /// \returns Pointer to decoded page, or nullptr if the entry does not map \p vaddr_page.
+    /// \details The pointer remains valid until the next call to this function or to clear().
+    decoded_page *get_code_page(const shadow_tlb_state &tlb, uint64_t eidx, uint64_t vaddr_page) {
+        if (tlb.hot[TLB_CODE][eidx].vaddr_page != vaddr_page) {
+            return nullptr;
+        }
+        decoded_page *page = m_code_pages[eidx];
+        const uint64_t paddr_page = tlb.cold[TLB_CODE][eidx].paddr_page;
+        if (!page || page->paddr_page != paddr_page) {
+            page = find_or_create_page(tlb, paddr_page);
+            m_code_pages[eidx] = page;
+        }
+        if (page->generation != m_generation) {
+            wipe_page(*page);
+        }
+        return page;
+    }
+
+    /// \brief Updates cache after a write TLB entry is replaced.
+    /// \param eidx Index of write TLB entry.
+    /// \param paddr_page Target physical address of page now mapped by the entry.
+    void replace_write_tlb_entry(uint64_t eidx, uint64_t paddr_page) {
+        flush_write_tlb_entry(eidx);
+        if (m_pages.empty()) {
+            return;
+        }
+        auto it = m_pages.find(paddr_page);
+        if (it != m_pages.end()) {
+            decoded_page *page = it->second.get();
+            ++page->write_refs;
+            m_write_pages[eidx] = page;
+            wipe_page(*page);
+        }
+    }
+
+    /// \brief Updates cache after a write TLB entry is flushed.
+    /// \param eidx Index of write TLB entry.
+    void flush_write_tlb_entry(uint64_t eidx) {
+        decoded_page *page = m_write_pages[eidx];
+        if (page) {
+            --page->write_refs;
+            m_write_pages[eidx] = nullptr;
+        }
+    }
+
+    /// \brief Invalidates all decoded slots, keeping pages and write TLB bookkeeping.
+    void invalidate(void) {
+        ++m_generation;
+    }
+
+    /// \brief Invalidates decoded slots of a physical page, if it is in cache.
+    /// \param paddr_page Target physical address of page start.
+    void invalidate_page(uint64_t paddr_page) {
+        auto it = m_pages.find(paddr_page);
+        if (it != m_pages.end()) {
+            wipe_page(*it->second);
+        }
+    }
+
+    /// \brief Removes all pages from cache.
+    /// \details Must be called whenever the TLB or memory contents are modified without going through state_access.
+    void clear(void);
+
+private:
+    /// \brief Discards all decoded slots of a page.
+    void wipe_page(decoded_page &page) const {
+        // Bumping the version discards all slots at once, unless it wraps around
+        if (++page.version == 0) {
+            page.insns.fill(decoded_insn{});
+            page.version = 1;
+        }
+        page.generation = m_generation;
+    }
+
+    /// \brief Looks up a page, creating it if needed.
+    decoded_page *find_or_create_page(const shadow_tlb_state &tlb, uint64_t paddr_page);
+
+    std::unordered_map<uint64_t, std::unique_ptr<decoded_page>> m_pages; ///< Pages, indexed by physical address
+    std::array<decoded_page *, PMA_TLB_SIZE> m_code_pages{};  ///< Page mapped by each code TLB entry, if known
+    std::array<decoded_page *, PMA_TLB_SIZE> m_write_pages{}; ///< Page mapped by each write TLB entry, if in cache
+    uint64_t m_generation{0};                                 ///< Current generation
+};
+
+} // namespace cartesi
+
+#endif
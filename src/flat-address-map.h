@@ -0,0 +1,139 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef FLAT_ADDRESS_MAP_H
+#define FLAT_ADDRESS_MAP_H
+
+/// \file
+/// \brief Open-addressing hash map keyed by aligned addresses.
+/// \details Entries live in a single array and collisions are resolved by linear probing, so a lookup usually
+/// touches a single cache line and inserting does not allocate, except when the array grows.
+/// Entries are never removed individually, only all at once.
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace cartesi {
+
+/// \class flat_address_map
+/// \brief Map from addresses aligned to 2^LOG2_ALIGNMENT bytes to values of type T.
+template <typename T, int LOG2_ALIGNMENT>
+class flat_address_map final {
+    static_assert(LOG2_ALIGNMENT > 0, "addresses must be aligned, so an unaligned key can mark empty entries");
+
+public:
+    using address_type = uint64_t;
+
+    /// \brief Returns pointer to value associated to an address, or nullptr if there is none.
+    T *find(address_type address) {
+        if (m_entries.empty()) {
+            return nullptr;
+        }
+        for (uint64_t i = get_index(address);; i = (i + 1) & m_mask) {
+            entry &e = m_entries[i];
+            if (e.address == address) {
+                return &e.value;
+            }
+            if (e.address == empty_address) {
+                return nullptr;
+            }
+        }
+    }
+
+    /// \brief Returns pointer to value associated to an address, or nullptr if there is none.
+    const T *find(address_type address) const {
+        return const_cast<flat_address_map *>(this)->find(address);
+    }
+
+    /// \brief Associates a value to an address, replacing any previous value.
+    void insert_or_assign(address_type address, T value) {
+        // Keep load factor at or below 3/4, so probe sequences stay short
+        if (4 * (m_size + 1) > 3 * m_entries.size()) {
+            grow();
+        }
+        for (uint64_t i = get_index(address);; i = (i + 1) & m_mask) {
+            entry &e = m_entries[i];
+            if (e.address == empty_address) {
+                e.address = address;
+                e.value = std::move(value);
+                ++m_size;
+                return;
+            }
+            if (e.address == address) {
+                e.value = std::move(value);
+                return;
+            }
+        }
+    }
+
+    /// \brief Removes all entries.
+    void clear(void) {
+        m_entries.clear();
+        m_mask = 0;
+        m_log2_capacity = 0;
+        m_size = 0;
+    }
+
+    /// \brief Returns the number of entries.
+    uint64_t size(void) const {
+        return m_size;
+    }
+
+    /// \brief Returns the number of bytes held by the entry array.
+    uint64_t get_footprint(void) const {
+        return m_entries.size() * sizeof(entry);
+    }
+
+private:
+    /// \brief Key marking empty entries
+    static constexpr address_type empty_address = ~UINT64_C(0);
+
+    /// \brief Map entry.
+    struct entry {
+        address_type address{empty_address}; ///< Address, or empty_address if entry is empty
+        T value{};                           ///< Value
+    };
+
+    /// \brief Returns the first entry probed for an address.
+    uint64_t get_index(address_type address) const {
+        // Fibonacci hashing spreads consecutive aligned addresses over the whole array
+        return ((address >> LOG2_ALIGNMENT) * UINT64_C(0x9e3779b97f4a7c15)) >> (64 - m_log2_capacity);
+    }
+
+    /// \brief Doubles the capacity, reinserting all entries.
+    void grow(void) {
+        std::vector<entry> old = std::move(m_entries);
+        m_log2_capacity = old.empty() ? 4 : m_log2_capacity + 1;
+        m_entries = std::vector<entry>(UINT64_C(1) << m_log2_capacity);
+        m_mask = m_entries.size() - 1;
+        m_size = 0;
+        for (auto &e : old) {
+            if (e.address != empty_address) {
+                insert_or_assign(e.address, std::move(e.value));
+            }
+        }
+    }
+
+    std::vector<entry> m_entries; ///< Entries, a power of 2 of them
+    uint64_t m_mask{0};           ///< Number of entries minus 1
+    int m_log2_capacity{0};       ///< Log<sub>2</sub> of number of entries
+    uint64_t m_size{0};           ///< Number of non-empty entries
+};
+
+} // namespace cartesi
+
+#endif
@@ -16,6 +16,8 @@
 
 #include "full-merkle-tree.h"
 
+#include <algorithm>
+
 /// \file
 /// \brief Full Merkle tree implementation.
 
@@ -27,7 +29,12 @@ full_merkle_tree::full_merkle_tree(int log2_root_size, int log2_leaf_size, int l
     m_max_leaves{address_type{1} << std::max(0, log2_root_size - log2_leaf_size)} {
     check_log2_sizes(log2_root_size, log2_leaf_size, log2_word_size);
     m_tree.resize(2 * m_max_leaves);
-    init_pristine_subtree(pristine_merkle_tree{log2_root_size, log2_word_size}, 1, log2_root_size);
+    const pristine_merkle_tree pristine{log2_root_size, log2_word_size};
+    // Nodes of each size live in indices [base, 2*base)
+    for (int log2_size = log2_leaf_size; log2_size <= log2_root_size; ++log2_size) {
+        const address_type base = address_type{1} << (log2_root_size - log2_size);
+        std::fill_n(&m_tree[base], base, pristine.get_hash(log2_size));
+    }
 }
 
 full_merkle_tree::full_merkle_tree(int log2_root_size, int log2_leaf_size, int log2_word_size,
@@ -40,7 +47,20 @@ full_merkle_tree::full_merkle_tree(int log2_root_size, int log2_leaf_size, int l
         throw std::out_of_range{"too many leaves"};
     }
     m_tree.resize(2 * m_max_leaves);
-    init_tree(pristine_merkle_tree{log2_root_size, log2_word_size}, leaves);
+    init_tree(pristine_merkle_tree{log2_root_size, log2_word_size}, leaves, nullptr);
+}
+
+full_merkle_tree::full_merkle_tree(int log2_root_size, int log2_leaf_size, int log2_word_size,
+    const std::vector<hash_type> &leaves, thread_pool &pool) :
+    m_log2_root_size(log2_root_size),
+    m_log2_leaf_size(log2_leaf_size),
+    m_max_leaves{address_type{1} << std::max(0, log2_root_size - log2_leaf_size)} {
+    check_log2_sizes(log2_root_size, log2_leaf_size, log2_word_size);
+    if (leaves.size() > m_max_leaves) {
+        throw std::out_of_range{"too many leaves"};
+    }
+    m_tree.resize(2 * m_max_leaves);
+    init_tree(pristine_merkle_tree{log2_root_size, log2_word_size}, leaves, &pool);
 }
 
 full_merkle_tree::proof_type full_merkle_tree::get_proof(address_type address, int log2_size) const {
@@ -88,28 +108,47 @@ void full_merkle_tree::check_log2_sizes(int log2_root_size, int log2_leaf_size,
     }
 }
 
-void full_merkle_tree::init_pristine_subtree(const pristine_merkle_tree &pristine, int index, int log2_size) {
-    if (log2_size >= get_log2_leaf_size()) {
-        m_tree[index] = pristine.get_hash(log2_size);
-        init_pristine_subtree(pristine, left_child_index(index), log2_size - 1);
-        init_pristine_subtree(pristine, right_child_index(index), log2_size - 1);
+void full_merkle_tree::init_levels(hasher_type &h, const pristine_merkle_tree &pristine, address_type leaf_count,
+    address_type first_leaf, address_type last_leaf, int first_height, int last_height) {
+    for (int height = first_height; height <= last_height; ++height) {
+        // Nodes at this height live in indices [base, 2*base)
+        const address_type base = m_max_leaves >> height;
+        const address_type begin = first_leaf >> height;
+        const address_type end = last_leaf >> height;
+        // Nodes starting at this one cover only pristine leaves
+        const address_type pristine_begin =
+            std::clamp((leaf_count + (address_type{1} << height) - 1) >> height, begin, end);
+        if (pristine_begin > begin) {
+            // The children of consecutive nodes are consecutive in the level below
+            h.hash_batch(m_tree[2 * (base + begin)].data(), 2 * sizeof(hash_type), pristine_begin - begin,
+                &m_tree[base + begin]);
+        }
+        std::fill(&m_tree[base + pristine_begin], &m_tree[base + end],
+            pristine.get_hash(get_log2_leaf_size() + height));
     }
 }
 
-void full_merkle_tree::init_subtree(hasher_type &h, int index, int log2_size) {
-    if (log2_size > get_log2_leaf_size()) {
-        init_subtree(h, left_child_index(index), log2_size - 1);
-        init_subtree(h, right_child_index(index), log2_size - 1);
-        get_concat_hash(h, m_tree[left_child_index(index)], m_tree[right_child_index(index)], m_tree[index]);
-    }
-}
-
-void full_merkle_tree::init_tree(const pristine_merkle_tree &pristine, const std::vector<hash_type> &leaves) {
+void full_merkle_tree::init_tree(const pristine_merkle_tree &pristine, const std::vector<hash_type> &leaves,
+    thread_pool *pool) {
+    // Subtrees with this many leaves are built by a single worker (their hashes take 32KiB)
+    constexpr int log2_subtree_leaves = 10;
     std::copy(leaves.begin(), leaves.end(), &m_tree[m_max_leaves]);
     std::fill_n(&m_tree[m_max_leaves + leaves.size()], m_max_leaves - leaves.size(),
         pristine.get_hash(get_log2_leaf_size()));
+    const int height = get_log2_root_size() - get_log2_leaf_size();
+    const int subtree_height = std::min(height, log2_subtree_leaves);
+    const address_type subtree_count = m_max_leaves >> subtree_height;
     hasher_type h;
-    init_subtree(h, 1, get_log2_root_size());
+    if (pool != nullptr && subtree_count > 1) {
+        std::vector<hasher_type> hashers(pool->get_concurrency());
+        pool->parallel_for(subtree_count, 1, [&](uint64_t worker, uint64_t begin, uint64_t end) {
+            init_levels(hashers[worker], pristine, leaves.size(), begin << subtree_height, end << subtree_height, 1,
+                subtree_height);
+        });
+    } else {
+        init_levels(h, pristine, leaves.size(), 0, m_max_leaves, 1, subtree_height);
+    }
+    init_levels(h, pristine, leaves.size(), 0, m_max_leaves, subtree_height + 1, height);
 }
 
 full_merkle_tree::address_type full_merkle_tree::get_node_index(address_type address, int log2_size) const {
@@ -20,6 +20,7 @@
 #include "keccak-256-hasher.h"
 #include "merkle-tree-proof.h"
 #include "pristine-merkle-tree.h"
+#include "thread-pool.h"
 #include <limits>
 
 /// \file
@@ -56,6 +57,15 @@ public:
     /// \param leaves List of leaf hashes
     full_merkle_tree(int log2_root_size, int log2_leaf_size, int log2_word_size, const std::vector<hash_type> &leaves);
 
+    /// \brief Constructor for list of consecutive leaf hashes, using a thread pool
+    /// \param log2_root_size Log<sub>2</sub> of root node
+    /// \param log2_leaf_size Log<sub>2</sub> of leaf node
+    /// \param log2_word_size Log<sub>2</sub> of word
+    /// \param leaves List of leaf hashes
+    /// \param pool Thread pool used to build independent subtrees in parallel
+    full_merkle_tree(int log2_root_size, int log2_leaf_size, int log2_word_size, const std::vector<hash_type> &leaves,
+        thread_pool &pool);
+
     /// \brief Returns log<sub>2</sub> of size of tree
     int get_log2_root_size(void) const {
         return m_log2_root_size;
@@ -93,37 +103,32 @@ private:
     /// \param log2_word_size Log<sub>2</sub> of word
     static void check_log2_sizes(int log2_root_size, int log2_leaf_size, int log2_word_size);
 
-    /// \brief Returns the index of the left child of node at given index
-    static constexpr int left_child_index(int index) {
-        return 2 * index;
-    }
-
-    /// \brief Returns the index of the right child of node at given index
-    static constexpr int right_child_index(int index) {
-        return 2 * index + 1;
-    }
-
-    /// \brief Initialize all nodes for the pristine subtree with root
-    /// at a given index
-    /// \param pristine Hashes for pristine subtree nodes of all sizes
-    /// \param index Index of root for subtree to initialize
-    /// \param log2_size Log<sub>2</sub> size of root at index
-    void init_pristine_subtree(const pristine_merkle_tree &pristine, int index, int log2_size);
-
-    /// \brief Initialize all nodes for the subtree with root at a given index
+    /// \brief Initialize all nodes in a range of levels from the nodes in the level below
     /// \param h Hasher object
-    /// \param index Index of root for subtree to initialize
-    /// \param log2_size Log<sub>2</sub> size of root at index
-    /// \details The nodes corresponding to subtrees of size log2_leaf_size
-    /// are assumed to have already been set prior to calling this function
-    void init_subtree(hasher_type &h, int index, int log2_size);
+    /// \param pristine Hashes for pristine subtree nodes of all sizes
+    /// \param leaf_count Number of leaves that are not pristine
+    /// \param first_leaf Index of first leaf covered by the nodes to initialize
+    /// \param last_leaf One past the index of the last leaf covered by the nodes to initialize
+    /// \param first_height Height above the leaf level of the first level to initialize
+    /// \param last_height Height above the leaf level of the last level to initialize
+    /// \details Levels are processed bottom up. In each level, the children of consecutive
+    /// nodes are consecutive, so their hashes are computed in a single batch. Nodes that
+    /// cover only pristine leaves are filled with pristine hashes instead.
+    /// The leaf range must be aligned to 2<sup>last_height</sup> leaves.
+    void init_levels(hasher_type &h, const pristine_merkle_tree &pristine, address_type leaf_count,
+        address_type first_leaf, address_type last_leaf, int first_height, int last_height);
 
     /// \brief Initialize tree from a list of consecutive page hashes
+    /// \param pristine Hashes for pristine subtree nodes of all sizes
     /// \param leaves List of page hashes
+    /// \param pool Thread pool used to build independent subtrees in parallel, or nullptr
     /// \details The page hashes in leaves are copied to the appropriate
     /// subtree nodes, in order, and the rest are filled with pristine
-    /// page hashes
-    void init_tree(const pristine_merkle_tree &pristine, const std::vector<hash_type> &leaves);
+    /// page hashes.
+    /// Subtrees with a fixed number of leaves are then built independently,
+    /// so each one stays in cache while its levels are computed, before
+    /// the few levels above them are computed.
+    void init_tree(const pristine_merkle_tree &pristine, const std::vector<hash_type> &leaves, thread_pool *pool);
 
     /// \brief Returns index of a node in the tree array
     /// \param address Node address
@@ -133,7 +138,7 @@ private:
     int m_log2_root_size;          ///< Log<sub>2</sub> of tree size
     int m_log2_leaf_size;          ///< Log<sub>2</sub> of leaf size
     address_type m_max_leaves;     ///< Maximum number of leaves
-    std::vector<hash_type> m_tree; ///< Binary heap with tree node hashes
+    std::vector<hash_type> m_tree; ///< Binary heap with tree node hashes, stored level by level
 };
 
 } // namespace cartesi
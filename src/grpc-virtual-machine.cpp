@@ -327,6 +327,12 @@ void grpc_virtual_machine::do_store(const std::string &dir) {
     check_status(m_stub->get_stub()->Store(&context, request, &response));
 }
 
+void grpc_virtual_machine::do_store_delta(const std::string &dir, const std::string &base_dir) {
+    // The gRPC protocol has no delta store request, so store in full, which loads just the same
+    (void) base_dir;
+    do_store(dir);
+}
+
 uint64_t grpc_virtual_machine::do_read_csr(csr r) const {
     ReadCsrRequest request;
     static_assert(cartesi::machine::num_csr == Csr_ARRAYSIZE);
@@ -798,6 +804,20 @@ machine_merkle_tree::proof_type grpc_virtual_machine::do_get_proof(uint64_t addr
     return get_proto_merkle_tree_proof(response.proof());
 }
 
+machine_merkle_tree::multiproof_type grpc_virtual_machine::do_get_proofs(
+    const std::vector<machine_merkle_tree::multiproof_type::target_type> &targets) const {
+    // The gRPC protocol has no multiproof message, so the multiproof is assembled from individual proofs
+    if (targets.empty()) {
+        throw std::invalid_argument{"no proof targets"};
+    }
+    std::vector<machine_merkle_tree::proof_type> proofs;
+    proofs.reserve(targets.size());
+    for (const auto &target : targets) {
+        proofs.push_back(do_get_proof(target.address, target.log2_size));
+    }
+    return machine_merkle_tree::multiproof_type::from_proofs(proofs);
+}
+
 void grpc_virtual_machine::do_replace_memory_range(const memory_range_config &new_range) {
     ReplaceMemoryRangeRequest request;
     MemoryRangeConfig *range = request.mutable_config();
@@ -854,6 +874,10 @@ bool grpc_virtual_machine::do_verify_dirty_page_maps(void) const {
     return response.success();
 }
 
+void grpc_virtual_machine::do_get_page_hash_cache_stats(uint64_t & /*hits*/, uint64_t & /*misses*/) const {
+    throw std::runtime_error("page hash cache statistics are not supported");
+}
+
 void grpc_virtual_machine::do_dump_pmas(void) const {
     const Void request;
     Void response;
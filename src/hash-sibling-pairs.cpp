@@ -0,0 +1,44 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <vector>
+
+#include "hash-sibling-pairs.h"
+
+namespace cartesi {
+
+/// \brief Levels with fewer pairs than this are not worth splitting among threads
+constexpr uint64_t hash_sibling_pairs_chunk = 1024;
+
+void hash_sibling_pairs(const keccak_256_hasher::hash_type *children, uint64_t count,
+    keccak_256_hasher::hash_type *parents, thread_pool *pool) {
+    using hasher_type = keccak_256_hasher;
+    using hash_type = hasher_type::hash_type;
+    if (count == 0) {
+        return;
+    }
+    if (pool == nullptr || count <= hash_sibling_pairs_chunk) {
+        hasher_type h;
+        h.hash_batch(children->data(), 2 * sizeof(hash_type), count, parents);
+        return;
+    }
+    std::vector<hasher_type> hashers(pool->get_concurrency());
+    pool->parallel_for(count, hash_sibling_pairs_chunk, [&](uint64_t worker, uint64_t begin, uint64_t end) {
+        hashers[worker].hash_batch(children[2 * begin].data(), 2 * sizeof(hash_type), end - begin, parents + begin);
+    });
+}
+
+} // namespace cartesi
@@ -0,0 +1,42 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef HASH_SIBLING_PAIRS_H
+#define HASH_SIBLING_PAIRS_H
+
+/// \file
+/// \brief Hashing of one level of a Merkle tree from the level below.
+
+#include <cstdint>
+
+#include "keccak-256-hasher.h"
+#include "thread-pool.h"
+
+namespace cartesi {
+
+/// \brief Hashes pairs of sibling nodes that lie next to each other in memory
+/// \param children Pointer to left child of first pair
+/// \param count Number of pairs
+/// \param parents Receives the hash of each pair
+/// \param pool Thread pool used to hash pairs in parallel, or nullptr
+/// \details Levels with few pairs are hashed by the calling thread, since splitting them among workers costs
+/// more than it saves.
+void hash_sibling_pairs(const keccak_256_hasher::hash_type *children, uint64_t count,
+    keccak_256_hasher::hash_type *parents, thread_pool *pool);
+
+} // namespace cartesi
+
+#endif
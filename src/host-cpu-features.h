@@ -0,0 +1,41 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef HOST_CPU_FEATURES_H
+#define HOST_CPU_FEATURES_H
+
+/// \file
+/// \brief Detection of host CPU features, used to select among implementations compiled for different
+/// instruction sets.
+
+namespace cartesi {
+
+/// \brief Checks if the host supports AVX2 instructions.
+/// \returns True on x86-64 hosts where cpuid reports AVX2, false otherwise.
+/// \details Can be used to initialize static objects, even before main().
+static inline bool host_supports_avx2(void) {
+#ifdef __x86_64__
+    // Static initializers may run before CPU features have been detected
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#else
+    return false;
+#endif
+}
+
+} // namespace cartesi
+
+#endif
@@ -0,0 +1,71 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "host-tlb.h"
+
+#include <stdexcept>
+
+namespace cartesi {
+
+static bool is_power_of_2(uint64_t v) {
+    return v != 0 && (v & (v - 1)) == 0;
+}
+
+static uint64_t get_log2(uint64_t v) {
+    uint64_t log2 = 0;
+    while (v > 1) {
+        v >>= 1;
+        ++log2;
+    }
+    return log2;
+}
+
+host_tlb::host_tlb(const tlb_runtime_config &c) :
+    m_sets{c.sets != 0 ? c.sets : HOST_TLB_SETS_DEFAULT},
+    m_sets_log2{0},
+    m_ways{c.ways != 0 ? c.ways : HOST_TLB_WAYS_DEFAULT} {
+    if (!is_power_of_2(m_sets) || m_sets > HOST_TLB_SETS_MAX) {
+        throw std::invalid_argument{"number of TLB sets must be a power of 2 no greater than 65536"};
+    }
+    if (!is_power_of_2(m_ways) || m_ways > HOST_TLB_WAYS_MAX) {
+        throw std::invalid_argument{"number of TLB ways must be a power of 2 no greater than 16"};
+    }
+    m_sets_log2 = get_log2(m_sets);
+    for (auto &entries : m_entries) {
+        entries.resize(m_sets * m_ways);
+    }
+    for (auto &next_way : m_next_way) {
+        next_way.resize(m_sets);
+    }
+    clear();
+    mark_all_shadow_entries();
+}
+
+void host_tlb::clear(void) {
+    for (auto &entries : m_entries) {
+        for (auto &e : entries) {
+            e.vaddr_page = TLB_INVALID_PAGE;
+        }
+    }
+}
+
+void host_tlb::mark_all_shadow_entries(void) {
+    for (auto &marks : m_shadow_marks) {
+        marks.fill(UINT64_C(-1));
+    }
+}
+
+} // namespace cartesi
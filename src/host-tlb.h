@@ -0,0 +1,177 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef HOST_TLB_H
+#define HOST_TLB_H
+
+/// \file
+/// \brief Host TLB.
+/// \details The host TLB is a set-associative cache of page table walks consulted when the shadow TLB misses.
+/// The shadow TLB is part of the machine state, so its direct-mapped layout and replacement policy must be
+/// preserved for the microarchitecture to reach the same state. The host TLB only saves the page table walk:
+/// the shadow TLB entry is still replaced as usual.
+/// Each entry remembers the page table entries read by its walk, and is used only while they remain unchanged
+/// in memory. A hit therefore produces exactly the same translation, with no side effects, as walking the
+/// page table again would. It lives outside of the machine state, so it does not affect the state hash.
+/// Entries are tagged by satp, which includes the ASID, and by privilege level, so they survive the shadow TLB
+/// flushes caused by context switches, privilege changes, and SFENCE.VMA.
+/// The host TLB also tracks which shadow TLB entries may be valid, so flushes only need to visit those.
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "machine-runtime-config.h"
+#include "shadow-tlb.h"
+#include "strict-aliasing.h"
+
+namespace cartesi {
+
+/// \brief Host TLB constants.
+enum HOST_TLB_constants : uint64_t {
+    HOST_TLB_LEVELS_MAX = 5,     ///< Maximum number of page table entries read by a walk (Sv57)
+    HOST_TLB_SETS_DEFAULT = 128, ///< Number of sets used when runtime configuration leaves it unspecified
+    HOST_TLB_SETS_MAX = 65536,   ///< Maximum number of sets
+    HOST_TLB_WAYS_DEFAULT = 4,   ///< Number of ways used when runtime configuration leaves it unspecified
+    HOST_TLB_WAYS_MAX = 16,      ///< Maximum number of ways
+};
+
+/// \brief Host TLB entry.
+struct host_tlb_entry final {
+    uint64_t vaddr_page; ///< Target virtual address of page start, or TLB_INVALID_PAGE if entry is empty
+    uint64_t paddr_page; ///< Target physical address of page start
+    uint64_t satp;       ///< Value of satp used by the walk
+    uint64_t context;    ///< Effective privilege level and relevant mstatus bits used by the walk
+    uint64_t levels;     ///< Number of page table entries read by the walk
+    std::array<const unsigned char *, HOST_TLB_LEVELS_MAX> hpte; ///< Host pointers to page table entries
+    std::array<uint64_t, HOST_TLB_LEVELS_MAX> pte;               ///< Values of page table entries
+};
+
+/// \class host_tlb
+/// \brief Set-associative cache of page table walks, one for each TLB entry type.
+class host_tlb final {
+public:
+    /// \brief Constructor
+    /// \param c Runtime configuration with the geometry of the cache.
+    explicit host_tlb(const tlb_runtime_config &c);
+
+    /// \brief No copy constructor
+    host_tlb(const host_tlb &) = delete;
+    /// \brief No copy assignment
+    host_tlb &operator=(const host_tlb &) = delete;
+    /// \brief No move constructor
+    host_tlb(host_tlb &&) = delete;
+    /// \brief No move assignment
+    host_tlb &operator=(host_tlb &&) = delete;
+    /// \brief Default destructor
+    ~host_tlb() = default;
+
+    /// \brief Looks up the translation of a virtual page.
+    /// \param etype TLB entry type.
+    /// \param vaddr_page Target virtual address of page start.
+    /// \param satp Current value of satp.
+    /// \param context Current effective privilege level and relevant mstatus bits.
+    /// \returns Pointer to entry, or nullptr if there is no valid entry for the page.
+    const host_tlb_entry *find(TLB_entry_type etype, uint64_t vaddr_page, uint64_t satp, uint64_t context) const {
+        const host_tlb_entry *set = &m_entries[etype][get_set_index(vaddr_page) * m_ways];
+        for (uint64_t way = 0; way < m_ways; ++way) {
+            const host_tlb_entry &e = set[way];
+            if (e.vaddr_page == vaddr_page && e.satp == satp && e.context == context) {
+                // Walking the page table again would only differ if any of its entries changed
+                for (uint64_t i = 0; i < e.levels; ++i) {
+                    if (aliased_aligned_read<uint64_t>(e.hpte[i]) != e.pte[i]) {
+                        return nullptr;
+                    }
+                }
+                return &e;
+            }
+        }
+        return nullptr;
+    }
+
+    /// \brief Obtains the entry that should receive the translation of a virtual page.
+    /// \param etype TLB entry type.
+    /// \param vaddr_page Target virtual address of page start.
+    /// \returns Reference to entry, which may be overwritten by the caller.
+    host_tlb_entry &replace(TLB_entry_type etype, uint64_t vaddr_page) {
+        const uint64_t set_index = get_set_index(vaddr_page);
+        host_tlb_entry *set = &m_entries[etype][set_index * m_ways];
+        // Reuse the entry that already holds the page, if any, so a page never occupies two ways
+        for (uint64_t way = 0; way < m_ways; ++way) {
+            if (set[way].vaddr_page == vaddr_page) {
+                return set[way];
+            }
+        }
+        // Otherwise, evict ways in round-robin order
+        uint8_t &next = m_next_way[etype][set_index];
+        host_tlb_entry &e = set[next];
+        next = static_cast<uint8_t>((next + 1) & (m_ways - 1));
+        return e;
+    }
+
+    /// \brief Removes all entries.
+    /// \details Must be called whenever the host memory backing a PMA range changes.
+    void clear(void);
+
+    /// \brief Records that a shadow TLB entry may have become valid.
+    /// \param etype TLB entry type.
+    /// \param eidx Index of shadow TLB entry.
+    void mark_shadow_entry(TLB_entry_type etype, uint64_t eidx) {
+        m_shadow_marks[etype][eidx / 64] |= UINT64_C(1) << (eidx % 64);
+    }
+
+    /// \brief Records that any shadow TLB entry may be valid.
+    /// \details Must be called whenever the shadow TLB is modified without going through state_access.
+    void mark_all_shadow_entries(void);
+
+    /// \brief Visits, and then forgets, all shadow TLB entries of a type that may be valid.
+    /// \tparam F Type of function to call for each entry.
+    /// \param etype TLB entry type.
+    /// \param f Function called with the index of each entry.
+    /// \details This allows flushing the shadow TLB in time proportional to the number of entries in use.
+    template <typename F>
+    void flush_shadow_entries(TLB_entry_type etype, F &&f) {
+        for (uint64_t i = 0; i < m_shadow_marks[etype].size(); ++i) {
+            uint64_t marks = m_shadow_marks[etype][i];
+            m_shadow_marks[etype][i] = 0;
+            while (marks != 0) {
+                f(i * 64 + static_cast<uint64_t>(__builtin_ctzll(marks)));
+                marks &= marks - 1;
+            }
+        }
+    }
+
+private:
+    /// \brief Gets the index of the set that may hold a virtual page.
+    uint64_t get_set_index(uint64_t vaddr_page) const {
+        // Fold higher bits into the index, so pages that conflict in the shadow TLB spread over different sets
+        const uint64_t vpn = vaddr_page >> PMA_PAGE_SIZE_LOG2;
+        return (vpn ^ (vpn >> m_sets_log2)) & (m_sets - 1);
+    }
+
+    uint64_t m_sets;                                      ///< Number of sets
+    uint64_t m_sets_log2;                                 ///< Log2 of number of sets
+    uint64_t m_ways;                                      ///< Number of entries in each set
+    std::array<std::vector<host_tlb_entry>, 3> m_entries; ///< Entries of each type, grouped by set
+    std::array<std::vector<uint8_t>, 3> m_next_way;       ///< Next way to evict in each set of each type
+
+    /// \brief One bit for each shadow TLB entry of each type, set if the entry may be valid
+    std::array<std::array<uint64_t, PMA_TLB_SIZE / 64>, 3> m_shadow_marks{};
+};
+
+} // namespace cartesi
+
+#endif
@@ -60,6 +60,26 @@ public:
     void end(hash_type &hash) {
         return derived().do_end(hash);
     }
+
+    /// \brief Hashes a batch of messages with the same length
+    /// \param data Pointer to first message. Messages are laid out one after the other.
+    /// \param length Length of each message.
+    /// \param count Number of messages.
+    /// \param hashes Receives the hash of each message.
+    /// \details Hashers that can process several messages at once override do_hash_batch().
+    void hash_batch(const unsigned char *data, size_t length, size_t count, hash_type *hashes) {
+        return derived().do_hash_batch(data, length, count, hashes);
+    }
+
+protected:
+    /// \brief Default implementation of hash_batch(), hashing one message at a time
+    void do_hash_batch(const unsigned char *data, size_t length, size_t count, hash_type *hashes) {
+        for (size_t i = 0; i < count; ++i) {
+            begin();
+            add_data(data + i * length, length);
+            end(hashes[i]);
+        }
+    }
 };
 
 template <typename DERIVED>
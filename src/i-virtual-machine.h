@@ -61,6 +61,11 @@ public:
         do_store(dir);
     }
 
+    /// \brief Serialize state to directory, as a delta relative to the directory last stored to or loaded from
+    void store_delta(const std::string &dir, const std::string &base_dir) {
+        do_store_delta(dir, base_dir);
+    }
+
     /// \brief Runs the machine for one micro cycle logging all accesses to the state.
     access_log step_uarch(const access_log::type &log_type, bool one_based = false) {
         return do_step_uarch(log_type, one_based);
@@ -71,6 +76,12 @@ public:
         return do_get_proof(address, log2_size);
     }
 
+    /// \brief Obtains a single proof for several nodes in the Merkle tree.
+    machine_merkle_tree::multiproof_type get_proofs(
+        const std::vector<machine_merkle_tree::multiproof_type::target_type> &targets) const {
+        return do_get_proofs(targets);
+    }
+
     /// \brief Obtains the root hash of the Merkle tree.
     void get_root_hash(hash_type &hash) const {
         do_get_root_hash(hash);
@@ -151,6 +162,11 @@ public:
         return do_verify_dirty_page_maps();
     }
 
+    /// \brief Obtains the number of page hash cache lookups that hit and missed.
+    void get_page_hash_cache_stats(uint64_t &hits, uint64_t &misses) const {
+        do_get_page_hash_cache_stats(hits, misses);
+    }
+
     /// \brief Returns copy of initialization config.
     machine_config get_initial_config(void) const {
         return do_get_initial_config();
@@ -646,8 +662,11 @@ public:
 private:
     virtual interpreter_break_reason do_run(uint64_t mcycle_end) = 0;
     virtual void do_store(const std::string &dir) = 0;
+    virtual void do_store_delta(const std::string &dir, const std::string &base_dir) = 0;
     virtual access_log do_step_uarch(const access_log::type &log_type, bool one_based = false) = 0;
     virtual machine_merkle_tree::proof_type do_get_proof(uint64_t address, int log2_size) const = 0;
+    virtual machine_merkle_tree::multiproof_type do_get_proofs(
+        const std::vector<machine_merkle_tree::multiproof_type::target_type> &targets) const = 0;
     virtual void do_get_root_hash(hash_type &hash) const = 0;
     virtual bool do_verify_merkle_tree(void) const = 0;
     virtual uint64_t do_read_csr(csr r) const = 0;
@@ -745,6 +764,7 @@ private:
     virtual void do_dump_pmas(void) const = 0;
     virtual uint64_t do_read_word(uint64_t address) const = 0;
     virtual bool do_verify_dirty_page_maps(void) const = 0;
+    virtual void do_get_page_hash_cache_stats(uint64_t &hits, uint64_t &misses) const = 0;
     virtual machine_config do_get_initial_config(void) const = 0;
     virtual void do_snapshot() = 0;
     virtual void do_destroy() = 0;
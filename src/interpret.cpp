@@ -797,6 +797,71 @@ static FORCE_INLINE int32_t insn_get_C_SWSP_imm(uint32_t insn) {
     return static_cast<int32_t>(((insn >> (9 - 2)) & 0x3c) | ((insn >> (7 - 6)) & 0xc0));
 }
 
+/// \brief Translates a virtual address after a TLB miss, consulting the host TLB before walking the page table.
+/// \tparam ETYPE TLB entry type that missed.
+/// \tparam STATE_ACCESS Class of machine state accessor object.
+/// \param a Machine state accessor object.
+/// \param ppaddr Pointer to physical address.
+/// \param vaddr Virtual address.
+/// \param xwr_shift Encodes the access mode by the shift to the XWR triad.
+/// \returns True if succeeded, false otherwise.
+/// \details Produces exactly the same results and side effects as translate_virtual_address().
+#ifdef MICROARCHITECTURE
+template <TLB_entry_type ETYPE, typename STATE_ACCESS>
+static FORCE_INLINE bool translate_virtual_address_via_host_tlb(STATE_ACCESS &a, uint64_t *ppaddr, uint64_t vaddr,
+    int xwr_shift) {
+    return translate_virtual_address(a, ppaddr, vaddr, xwr_shift);
+}
+#else
+template <TLB_entry_type ETYPE, typename STATE_ACCESS>
+static NO_INLINE bool translate_virtual_address_via_host_tlb(STATE_ACCESS &a, uint64_t *ppaddr, uint64_t vaddr,
+    int xwr_shift) {
+    // The walk depends on the effective privilege level, SUM and MXR bits in mstatus, and satp
+    auto priv = a.read_iflags_PRV();
+    const uint64_t mstatus = a.read_mstatus();
+    if (xwr_shift != PTE_XWR_X_SHIFT && (mstatus & MSTATUS_MPRV_MASK)) {
+        priv = (mstatus & MSTATUS_MPP_MASK) >> MSTATUS_MPP_SHIFT;
+    }
+    const uint64_t satp = a.read_satp();
+    // There is nothing to save when there is no page table to walk
+    if (priv > PRV_S || (satp >> SATP_MODE_SHIFT) == SATP_MODE_BARE) {
+        return translate_virtual_address(a, ppaddr, vaddr, xwr_shift);
+    }
+    const uint64_t context = priv | (mstatus & (MSTATUS_SUM_MASK | MSTATUS_MXR_MASK));
+    const uint64_t vaddr_page = vaddr & ~PAGE_OFFSET_MASK;
+    host_tlb &htlb = a.get_naked_machine().get_host_tlb();
+    const host_tlb_entry *found = htlb.find(ETYPE, vaddr_page, satp, context);
+    if (found) {
+        INC_COUNTER(a.get_statistics(), tlb_hhit);
+        *ppaddr = found->paddr_page | (vaddr & PAGE_OFFSET_MASK);
+        return true;
+    }
+    INC_COUNTER(a.get_statistics(), tlb_hmiss);
+    // Walk the page table, recording the host pointer and value of every page table entry it reads
+    host_tlb_entry walk{};
+    pma_entry *pte_pma = nullptr;
+    const bool translated = walk_page_table<STATE_ACCESS, true>(a, ppaddr, vaddr, xwr_shift,
+        [&a, &walk, &pte_pma](uint64_t pte_addr, uint64_t pte) {
+            // Page tables usually all live in the same range
+            if (!pte_pma || pte_addr < pte_pma->get_start() ||
+                pte_addr - pte_pma->get_start() >= pte_pma->get_length()) {
+                pte_pma = &a.template find_pma_entry<uint64_t>(pte_addr);
+            }
+            walk.hpte[walk.levels] = a.get_host_memory(*pte_pma) + (pte_addr - pte_pma->get_start());
+            walk.pte[walk.levels] = pte;
+            ++walk.levels;
+        });
+    if (translated) {
+        walk.vaddr_page = vaddr_page;
+        walk.paddr_page = *ppaddr & ~PAGE_OFFSET_MASK;
+        walk.satp = satp;
+        walk.context = context;
+        htlb.replace(ETYPE, vaddr_page) = walk;
+    }
+    return translated;
+}
+#endif
+
 /// \brief Read an aligned word from virtual memory (slow path that goes through virtual address translation).
 /// \tparam T uint8_t, uint16_t, uint32_t, or uint64_t.
 /// \tparam STATE_ACCESS Class of machine state accessor object.
@@ -824,7 +889,7 @@ static NO_INLINE std::pair<bool, uint64_t> read_virtual_memory_slow(STATE_ACCESS
     }
     // Deal with aligned accesses
     uint64_t paddr{};
-    if (unlikely(!translate_virtual_address(a, &paddr, vaddr, PTE_XWR_R_SHIFT))) {
+    if (unlikely(!translate_virtual_address_via_host_tlb<TLB_READ>(a, &paddr, vaddr, PTE_XWR_R_SHIFT))) {
         pc = raise_exception(a, pc, RAISE_STORE_EXCEPTIONS ? MCAUSE_STORE_AMO_PAGE_FAULT : MCAUSE_LOAD_PAGE_FAULT,
             vaddr);
         return {false, pc};
@@ -900,7 +965,7 @@ static NO_INLINE std::pair<execute_status, uint64_t> write_virtual_memory_slow(S
     }
     // Deal with aligned accesses
     uint64_t paddr{};
-    if (unlikely(!translate_virtual_address(a, &paddr, vaddr, PTE_XWR_W_SHIFT))) {
+    if (unlikely(!translate_virtual_address_via_host_tlb<TLB_WRITE>(a, &paddr, vaddr, PTE_XWR_W_SHIFT))) {
         pc = raise_exception(a, pc, MCAUSE_STORE_AMO_PAGE_FAULT, vaddr);
         return {execute_status::failure, pc};
     }
@@ -2639,8 +2704,12 @@ static FORCE_INLINE execute_status execute_FENCE_I(STATE_ACCESS &a, uint64_t &pc
     (void) insn;
     INC_COUNTER(a.get_statistics(), fence_i);
     dump_insn(a, pc, insn, "fence.i");
-    // Really do nothing
-    return advance_to_next_insn(a, pc);
+#ifndef MICROARCHITECTURE
+    // Discard all decoded instructions
+    a.get_naked_machine().get_decode_cache().invalidate();
+#endif
+    // Flush the fetch cache, so the interpreter loop does not keep executing stale decoded instructions
+    return advance_to_next_insn(a, pc, execute_status::success_and_flush_fetch);
 }
 
 template <typename STATE_ACCESS, typename F>
@@ -5104,6 +5173,293 @@ static FORCE_INLINE execute_status execute_C_SDSP(STATE_ACCESS &a, uint64_t &pc,
     return execute_C_S<uint64_t>(a, pc, mcycle, rs2, 0x2, imm);
 }
 
+/// \brief Executes a compressed instruction, given its decoded funct3 and opcode fields.
+/// \tparam STATE_ACCESS Class of machine state accessor object.
+/// \param a Machine state accessor object.
+/// \param pc Current pc.
+/// \param mcycle Current mcycle.
+/// \param insn Instruction, with its 2 most significant bytes cleared.
+/// \param c_funct3 Instruction funct3 and opcode fields, as extracted by insn_get_c_funct3().
+/// \return execute_status::failure if an exception was raised, or
+///  execute_status::success otherwise.
+template <typename STATE_ACCESS>
+static FORCE_INLINE execute_status execute_insn_c(STATE_ACCESS &a, uint64_t &pc, uint64_t &mcycle, uint32_t insn,
+    insn_c_funct3 c_funct3) {
+    switch (c_funct3) {
+        case insn_c_funct3::C_ADDI4SPN:
+            return execute_C_ADDI4SPN(a, pc, insn);
+        case insn_c_funct3::C_LW:
+            return execute_C_LW(a, pc, mcycle, insn);
+        case insn_c_funct3::C_LD:
+            return execute_C_LD(a, pc, mcycle, insn);
+        case insn_c_funct3::C_SW:
+            return execute_C_SW(a, pc, mcycle, insn);
+        case insn_c_funct3::C_SD:
+            return execute_C_SD(a, pc, mcycle, insn);
+        case insn_c_funct3::C_Q1_SET0:
+            return execute_C_Q1_SET0(a, pc, insn);
+        case insn_c_funct3::C_ADDIW:
+            return execute_C_ADDIW(a, pc, insn);
+        case insn_c_funct3::C_LI:
+            return execute_C_LI(a, pc, insn);
+        case insn_c_funct3::C_Q1_SET1:
+            return execute_C_Q1_SET1(a, pc, insn);
+        case insn_c_funct3::C_Q1_SET2:
+            return execute_C_Q1_SET2(a, pc, insn);
+        case insn_c_funct3::C_J:
+            return execute_C_J(a, pc, insn);
+        case insn_c_funct3::C_BEQZ:
+            return execute_C_BEQZ(a, pc, insn);
+        case insn_c_funct3::C_BNEZ:
+            return execute_C_BNEZ(a, pc, insn);
+        case insn_c_funct3::C_SLLI:
+            return execute_C_SLLI(a, pc, insn);
+        case insn_c_funct3::C_LWSP:
+            return execute_C_LWSP(a, pc, mcycle, insn);
+        case insn_c_funct3::C_LDSP:
+            return execute_C_LDSP(a, pc, mcycle, insn);
+        case insn_c_funct3::C_Q2_SET0:
+            return execute_C_Q2_SET0(a, pc, insn);
+        case insn_c_funct3::C_SWSP:
+            return execute_C_SWSP(a, pc, mcycle, insn);
+        case insn_c_funct3::C_SDSP:
+            return execute_C_SDSP(a, pc, mcycle, insn);
+        default: {
+            // Here we are sure that the next instruction, at best, can only be a floating point instruction,
+            // or, at worst, an illegal instruction.
+            // Since all float instructions try to read the float state,
+            // we can put the next check before all of them.
+            // If FS is OFF, attempts to read or write the float state will cause an illegal instruction
+            // exception.
+            if (unlikely((a.read_mstatus() & MSTATUS_FS_MASK) == MSTATUS_FS_OFF)) {
+                return raise_illegal_insn_exception(a, pc, insn);
+            }
+            switch (c_funct3) {
+                case insn_c_funct3::C_FLD:
+                    return execute_C_FLD(a, pc, mcycle, insn);
+                case insn_c_funct3::C_FSD:
+                    return execute_C_FSD(a, pc, mcycle, insn);
+                case insn_c_funct3::C_FLDSP:
+                    return execute_C_FLDSP(a, pc, mcycle, insn);
+                case insn_c_funct3::C_FSDSP:
+                    return execute_C_FSDSP(a, pc, mcycle, insn);
+                default:
+                    return raise_illegal_insn_exception(a, pc, insn);
+            }
+        }
+    }
+}
+
+/// \brief Executes an uncompressed instruction, given its decoded funct3 and opcode fields.
+/// \tparam STATE_ACCESS Class of machine state accessor object.
+/// \param a Machine state accessor object.
+/// \param pc Current pc.
+/// \param mcycle Current mcycle.
+/// \param insn Instruction.
+/// \param funct3_00000_opcode Instruction funct3 and opcode fields, as extracted by insn_get_funct3_00000_opcode().
+/// \return execute_status::failure if an exception was raised, or
+///  execute_status::success otherwise.
+template <typename STATE_ACCESS>
+static FORCE_INLINE execute_status execute_insn_32(STATE_ACCESS &a, uint64_t &pc, uint64_t &mcycle, uint32_t insn,
+    insn_funct3_00000_opcode funct3_00000_opcode) {
+    //??D We should probably try doing the first branch on the combined opcode, funct3, and funct7.
+    //    Maybe it reduces the number of levels needed to decode most instructions.
+    switch (funct3_00000_opcode) {
+        case insn_funct3_00000_opcode::LB:
+            return execute_LB(a, pc, mcycle, insn);
+        case insn_funct3_00000_opcode::LH:
+            return execute_LH(a, pc, mcycle, insn);
+        case insn_funct3_00000_opcode::LW:
+            return execute_LW(a, pc, mcycle, insn);
+        case insn_funct3_00000_opcode::LD:
+            return execute_LD(a, pc, mcycle, insn);
+        case insn_funct3_00000_opcode::LBU:
+            return execute_LBU(a, pc, mcycle, insn);
+        case insn_funct3_00000_opcode::LHU:
+            return execute_LHU(a, pc, mcycle, insn);
+        case insn_funct3_00000_opcode::LWU:
+            return execute_LWU(a, pc, mcycle, insn);
+        case insn_funct3_00000_opcode::SB:
+            return execute_SB(a, pc, mcycle, insn);
+        case insn_funct3_00000_opcode::SH:
+            return execute_SH(a, pc, mcycle, insn);
+        case insn_funct3_00000_opcode::SW:
+            return execute_SW(a, pc, mcycle, insn);
+        case insn_funct3_00000_opcode::SD:
+            return execute_SD(a, pc, mcycle, insn);
+        case insn_funct3_00000_opcode::FENCE:
+            return execute_FENCE(a, pc, insn);
+        case insn_funct3_00000_opcode::FENCE_I:
+            return execute_FENCE_I(a, pc, insn);
+        case insn_funct3_00000_opcode::ADDI:
+            return execute_ADDI(a, pc, insn);
+        case insn_funct3_00000_opcode::SLLI:
+            return execute_SLLI(a, pc, insn);
+        case insn_funct3_00000_opcode::SLTI:
+            return execute_SLTI(a, pc, insn);
+        case insn_funct3_00000_opcode::SLTIU:
+            return execute_SLTIU(a, pc, insn);
+        case insn_funct3_00000_opcode::XORI:
+            return execute_XORI(a, pc, insn);
+        case insn_funct3_00000_opcode::ORI:
+            return execute_ORI(a, pc, insn);
+        case insn_funct3_00000_opcode::ANDI:
+            return execute_ANDI(a, pc, insn);
+        case insn_funct3_00000_opcode::ADDIW:
+            return execute_ADDIW(a, pc, insn);
+        case insn_funct3_00000_opcode::SLLIW:
+            return execute_SLLIW(a, pc, insn);
+        case insn_funct3_00000_opcode::SLLW:
+            return execute_SLLW(a, pc, insn);
+        case insn_funct3_00000_opcode::DIVW:
+            return execute_DIVW(a, pc, insn);
+        case insn_funct3_00000_opcode::REMW:
+            return execute_REMW(a, pc, insn);
+        case insn_funct3_00000_opcode::REMUW:
+            return execute_REMUW(a, pc, insn);
+        case insn_funct3_00000_opcode::BEQ:
+            return execute_BEQ(a, pc, insn);
+        case insn_funct3_00000_opcode::BNE:
+            return execute_BNE(a, pc, insn);
+        case insn_funct3_00000_opcode::BLT:
+            return execute_BLT(a, pc, insn);
+        case insn_funct3_00000_opcode::BGE:
+            return execute_BGE(a, pc, insn);
+        case insn_funct3_00000_opcode::BLTU:
+            return execute_BLTU(a, pc, insn);
+        case insn_funct3_00000_opcode::BGEU:
+            return execute_BGEU(a, pc, insn);
+        case insn_funct3_00000_opcode::JALR:
+            return execute_JALR(a, pc, insn);
+        case insn_funct3_00000_opcode::CSRRW:
+            return execute_CSRRW(a, pc, mcycle, insn);
+        case insn_funct3_00000_opcode::CSRRS:
+            return execute_CSRRS(a, pc, mcycle, insn);
+        case insn_funct3_00000_opcode::CSRRC:
+            return execute_CSRRC(a, pc, mcycle, insn);
+        case insn_funct3_00000_opcode::CSRRWI:
+            return execute_CSRRWI(a, pc, mcycle, insn);
+        case insn_funct3_00000_opcode::CSRRSI:
+            return execute_CSRRSI(a, pc, mcycle, insn);
+        case insn_funct3_00000_opcode::CSRRCI:
+            return execute_CSRRCI(a, pc, mcycle, insn);
+        case insn_funct3_00000_opcode::AUIPC_000:
+        case insn_funct3_00000_opcode::AUIPC_001:
+        case insn_funct3_00000_opcode::AUIPC_010:
+        case insn_funct3_00000_opcode::AUIPC_011:
+        case insn_funct3_00000_opcode::AUIPC_100:
+        case insn_funct3_00000_opcode::AUIPC_101:
+        case insn_funct3_00000_opcode::AUIPC_110:
+        case insn_funct3_00000_opcode::AUIPC_111:
+            return execute_AUIPC(a, pc, insn);
+        case insn_funct3_00000_opcode::LUI_000:
+        case insn_funct3_00000_opcode::LUI_001:
+        case insn_funct3_00000_opcode::LUI_010:
+        case insn_funct3_00000_opcode::LUI_011:
+        case insn_funct3_00000_opcode::LUI_100:
+        case insn_funct3_00000_opcode::LUI_101:
+        case insn_funct3_00000_opcode::LUI_110:
+        case insn_funct3_00000_opcode::LUI_111:
+            return execute_LUI(a, pc, insn);
+        case insn_funct3_00000_opcode::JAL_000:
+        case insn_funct3_00000_opcode::JAL_001:
+        case insn_funct3_00000_opcode::JAL_010:
+        case insn_funct3_00000_opcode::JAL_011:
+        case insn_funct3_00000_opcode::JAL_100:
+        case insn_funct3_00000_opcode::JAL_101:
+        case insn_funct3_00000_opcode::JAL_110:
+        case insn_funct3_00000_opcode::JAL_111:
+            return execute_JAL(a, pc, insn);
+        case insn_funct3_00000_opcode::SRLI_SRAI:
+            return execute_SRLI_SRAI(a, pc, insn);
+        case insn_funct3_00000_opcode::SRLIW_SRAIW:
+            return execute_SRLIW_SRAIW(a, pc, insn);
+        case insn_funct3_00000_opcode::AMO_W:
+            return execute_AMO_W(a, pc, mcycle, insn);
+        case insn_funct3_00000_opcode::AMO_D:
+            return execute_AMO_D(a, pc, mcycle, insn);
+        case insn_funct3_00000_opcode::ADD_MUL_SUB:
+            return execute_ADD_MUL_SUB(a, pc, insn);
+        case insn_funct3_00000_opcode::SLL_MULH:
+            return execute_SLL_MULH(a, pc, insn);
+        case insn_funct3_00000_opcode::SLT_MULHSU:
+            return execute_SLT_MULHSU(a, pc, insn);
+        case insn_funct3_00000_opcode::SLTU_MULHU:
+            return execute_SLTU_MULHU(a, pc, insn);
+        case insn_funct3_00000_opcode::XOR_DIV:
+            return execute_XOR_DIV(a, pc, insn);
+        case insn_funct3_00000_opcode::SRL_DIVU_SRA:
+            return execute_SRL_DIVU_SRA(a, pc, insn);
+        case insn_funct3_00000_opcode::OR_REM:
+            return execute_OR_REM(a, pc, insn);
+        case insn_funct3_00000_opcode::AND_REMU:
+            return execute_AND_REMU(a, pc, insn);
+        case insn_funct3_00000_opcode::ADDW_MULW_SUBW:
+            return execute_ADDW_MULW_SUBW(a, pc, insn);
+        case insn_funct3_00000_opcode::SRLW_DIVUW_SRAW:
+            return execute_SRLW_DIVUW_SRAW(a, pc, insn);
+        case insn_funct3_00000_opcode::privileged:
+            return execute_privileged(a, pc, mcycle, insn);
+        default: {
+            // Here we are sure that the next instruction, at best, can only be a floating point instruction,
+            // or, at worst, an illegal instruction.
+            // Since all float instructions try to read the float state,
+            // we can put the next check before all of them.
+            // If FS is OFF, attempts to read or write the float state will cause an illegal instruction exception.
+            if (unlikely((a.read_mstatus() & MSTATUS_FS_MASK) == MSTATUS_FS_OFF)) {
+                return raise_illegal_insn_exception(a, pc, insn);
+            }
+            switch (funct3_00000_opcode) {
+                case insn_funct3_00000_opcode::FSW:
+                    return execute_FSW(a, pc, mcycle, insn);
+                case insn_funct3_00000_opcode::FSD:
+                    return execute_FSD(a, pc, mcycle, insn);
+                case insn_funct3_00000_opcode::FLW:
+                    return execute_FLW(a, pc, mcycle, insn);
+                case insn_funct3_00000_opcode::FLD:
+                    return execute_FLD(a, pc, mcycle, insn);
+                case insn_funct3_00000_opcode::FMADD_RNE:
+                case insn_funct3_00000_opcode::FMADD_RTZ:
+                case insn_funct3_00000_opcode::FMADD_RDN:
+                case insn_funct3_00000_opcode::FMADD_RUP:
+                case insn_funct3_00000_opcode::FMADD_RMM:
+                case insn_funct3_00000_opcode::FMADD_DYN:
+                    return execute_FMADD(a, pc, insn);
+                case insn_funct3_00000_opcode::FMSUB_RNE:
+                case insn_funct3_00000_opcode::FMSUB_RTZ:
+                case insn_funct3_00000_opcode::FMSUB_RDN:
+                case insn_funct3_00000_opcode::FMSUB_RUP:
+                case insn_funct3_00000_opcode::FMSUB_RMM:
+                case insn_funct3_00000_opcode::FMSUB_DYN:
+                    return execute_FMSUB(a, pc, insn);
+                case insn_funct3_00000_opcode::FNMSUB_RNE:
+                case insn_funct3_00000_opcode::FNMSUB_RTZ:
+                case insn_funct3_00000_opcode::FNMSUB_RDN:
+                case insn_funct3_00000_opcode::FNMSUB_RUP:
+                case insn_funct3_00000_opcode::FNMSUB_RMM:
+                case insn_funct3_00000_opcode::FNMSUB_DYN:
+                    return execute_FNMSUB(a, pc, insn);
+                case insn_funct3_00000_opcode::FNMADD_RNE:
+                case insn_funct3_00000_opcode::FNMADD_RTZ:
+                case insn_funct3_00000_opcode::FNMADD_RDN:
+                case insn_funct3_00000_opcode::FNMADD_RUP:
+                case insn_funct3_00000_opcode::FNMADD_RMM:
+                case insn_funct3_00000_opcode::FNMADD_DYN:
+                    return execute_FNMADD(a, pc, insn);
+                case insn_funct3_00000_opcode::FD_000:
+                case insn_funct3_00000_opcode::FD_001:
+                case insn_funct3_00000_opcode::FD_010:
+                case insn_funct3_00000_opcode::FD_011:
+                case insn_funct3_00000_opcode::FD_100:
+                case insn_funct3_00000_opcode::FD_111:
+                    return execute_FD(a, pc, insn);
+                default:
+                    return raise_illegal_insn_exception(a, pc, insn);
+            }
+        }
+    }
+}
+
 /// \brief Decodes and executes an instruction.
 /// \tparam STATE_ACCESS Class of machine state accessor object.
 /// \param a Machine state accessor object.
@@ -5123,271 +5479,322 @@ static FORCE_INLINE execute_status execute_insn(STATE_ACCESS &a, uint64_t &pc, u
         // The fetch may read 4 bytes as an optimization,
         // but the compressed instruction uses only the 2 less significant bytes
         insn = static_cast<uint16_t>(insn);
-        auto c_funct3 = static_cast<insn_c_funct3>(insn_get_c_funct3(insn));
-        switch (c_funct3) {
-            case insn_c_funct3::C_ADDI4SPN:
-                return execute_C_ADDI4SPN(a, pc, insn);
-            case insn_c_funct3::C_LW:
-                return execute_C_LW(a, pc, mcycle, insn);
-            case insn_c_funct3::C_LD:
-                return execute_C_LD(a, pc, mcycle, insn);
-            case insn_c_funct3::C_SW:
-                return execute_C_SW(a, pc, mcycle, insn);
-            case insn_c_funct3::C_SD:
-                return execute_C_SD(a, pc, mcycle, insn);
-            case insn_c_funct3::C_Q1_SET0:
-                return execute_C_Q1_SET0(a, pc, insn);
-            case insn_c_funct3::C_ADDIW:
-                return execute_C_ADDIW(a, pc, insn);
-            case insn_c_funct3::C_LI:
-                return execute_C_LI(a, pc, insn);
-            case insn_c_funct3::C_Q1_SET1:
-                return execute_C_Q1_SET1(a, pc, insn);
-            case insn_c_funct3::C_Q1_SET2:
-                return execute_C_Q1_SET2(a, pc, insn);
-            case insn_c_funct3::C_J:
-                return execute_C_J(a, pc, insn);
-            case insn_c_funct3::C_BEQZ:
-                return execute_C_BEQZ(a, pc, insn);
-            case insn_c_funct3::C_BNEZ:
-                return execute_C_BNEZ(a, pc, insn);
-            case insn_c_funct3::C_SLLI:
-                return execute_C_SLLI(a, pc, insn);
-            case insn_c_funct3::C_LWSP:
-                return execute_C_LWSP(a, pc, mcycle, insn);
-            case insn_c_funct3::C_LDSP:
-                return execute_C_LDSP(a, pc, mcycle, insn);
-            case insn_c_funct3::C_Q2_SET0:
-                return execute_C_Q2_SET0(a, pc, insn);
-            case insn_c_funct3::C_SWSP:
-                return execute_C_SWSP(a, pc, mcycle, insn);
-            case insn_c_funct3::C_SDSP:
-                return execute_C_SDSP(a, pc, mcycle, insn);
-            default: {
-                // Here we are sure that the next instruction, at best, can only be a floating point instruction,
-                // or, at worst, an illegal instruction.
-                // Since all float instructions try to read the float state,
-                // we can put the next check before all of them.
-                // If FS is OFF, attempts to read or write the float state will cause an illegal instruction
-                // exception.
-                if (unlikely((a.read_mstatus() & MSTATUS_FS_MASK) == MSTATUS_FS_OFF)) {
-                    return raise_illegal_insn_exception(a, pc, insn);
-                }
-                switch (c_funct3) {
-                    case insn_c_funct3::C_FLD:
-                        return execute_C_FLD(a, pc, mcycle, insn);
-                    case insn_c_funct3::C_FSD:
-                        return execute_C_FSD(a, pc, mcycle, insn);
-                    case insn_c_funct3::C_FLDSP:
-                        return execute_C_FLDSP(a, pc, mcycle, insn);
-                    case insn_c_funct3::C_FSDSP:
-                        return execute_C_FSDSP(a, pc, mcycle, insn);
-                    default:
-                        return raise_illegal_insn_exception(a, pc, insn);
-                }
-            }
-        }
+        return execute_insn_c(a, pc, mcycle, insn, static_cast<insn_c_funct3>(insn_get_c_funct3(insn)));
+    }
+    return execute_insn_32(a, pc, mcycle, insn,
+        static_cast<insn_funct3_00000_opcode>(insn_get_funct3_00000_opcode(insn)));
+}
+
+#ifndef MICROARCHITECTURE
+
+#ifndef COMPUTED_GOTO_DISPATCH
+
+/// \brief Executes a compressed instruction whose funct3 and opcode fields were decoded ahead of time.
+/// \tparam STATE_ACCESS Class of machine state accessor object.
+/// \tparam INDEX Instruction funct3 and opcode fields, packed as in decoded_insn_c_index().
+/// \details Unlike other functions in this file, this function does not take pc and mcycle by reference,
+/// instead it returns the new pc. This is because it is called through a pointer from the interpreter loop,
+/// and taking them by reference would force the loop to keep them in stack variables.
+template <typename STATE_ACCESS, uint32_t INDEX>
+static std::pair<execute_status, uint64_t> execute_decoded_insn_c(STATE_ACCESS &a, uint64_t pc, uint64_t mcycle,
+    uint32_t insn, uint64_t /*vh_offset*/) {
+    constexpr auto c_funct3 = static_cast<insn_c_funct3>(((INDEX & 0b11100) << 11) | (INDEX & 0b11));
+    const execute_status status = execute_insn_c(a, pc, mcycle, insn, c_funct3);
+    return {status, pc};
+}
+
+/// \brief Executes an uncompressed instruction whose funct3 and opcode fields were decoded ahead of time.
+/// \tparam STATE_ACCESS Class of machine state accessor object.
+/// \tparam INDEX Instruction funct3 and opcode fields, packed as in decoded_insn_32_index().
+/// \details See execute_decoded_insn_c().
+template <typename STATE_ACCESS, uint32_t INDEX>
+static std::pair<execute_status, uint64_t> execute_decoded_insn_32(STATE_ACCESS &a, uint64_t pc, uint64_t mcycle,
+    uint32_t insn, uint64_t /*vh_offset*/) {
+    constexpr auto funct3_00000_opcode =
+        static_cast<insn_funct3_00000_opcode>(((INDEX & 0b11100000) << 7) | ((INDEX & 0b11111) << 2) | 0b11);
+    const execute_status status = execute_insn_32(a, pc, mcycle, insn, funct3_00000_opcode);
+    return {status, pc};
+}
+
+/// \brief Packs the funct3 and opcode fields of a compressed instruction into a 5-bit index.
+static constexpr uint32_t decoded_insn_c_index(uint32_t insn) {
+    return ((insn >> 11) & 0b11100) | (insn & 0b11);
+}
+
+/// \brief Packs the funct3 and opcode fields of an uncompressed instruction into an 8-bit index.
+/// \details The 2 least significant opcode bits are always set in uncompressed instructions, so they are dropped.
+static constexpr uint32_t decoded_insn_32_index(uint32_t insn) {
+    return ((insn >> 7) & 0b11100000) | ((insn >> 2) & 0b11111);
+}
+
+/// \brief Builds a table with the handlers for every compressed instruction index.
+template <typename STATE_ACCESS, uint32_t... INDEX>
+static constexpr auto make_decoded_insn_c_handlers(std::integer_sequence<uint32_t, INDEX...>) {
+    return std::array<decoded_insn_handler, sizeof...(INDEX)>{{&execute_decoded_insn_c<STATE_ACCESS, INDEX>...}};
+}
+
+/// \brief Returns the handler for an uncompressed instruction index.
+/// \details Privileged instructions have no handler, because WFI may advance mcycle.
+template <typename STATE_ACCESS, uint32_t INDEX>
+static constexpr decoded_insn_handler get_decoded_insn_32_handler() {
+    if constexpr (INDEX == decoded_insn_32_index(to_underlying(insn_funct3_00000_opcode::privileged))) {
+        return nullptr;
     } else {
-        //??D We should probably try doing the first branch on the combined opcode, funct3, and funct7.
-        //    Maybe it reduces the number of levels needed to decode most instructions.
-        auto funct3_00000_opcode = static_cast<insn_funct3_00000_opcode>(insn_get_funct3_00000_opcode(insn));
-        switch (funct3_00000_opcode) {
-            case insn_funct3_00000_opcode::LB:
-                return execute_LB(a, pc, mcycle, insn);
-            case insn_funct3_00000_opcode::LH:
-                return execute_LH(a, pc, mcycle, insn);
-            case insn_funct3_00000_opcode::LW:
-                return execute_LW(a, pc, mcycle, insn);
-            case insn_funct3_00000_opcode::LD:
-                return execute_LD(a, pc, mcycle, insn);
-            case insn_funct3_00000_opcode::LBU:
-                return execute_LBU(a, pc, mcycle, insn);
-            case insn_funct3_00000_opcode::LHU:
-                return execute_LHU(a, pc, mcycle, insn);
-            case insn_funct3_00000_opcode::LWU:
-                return execute_LWU(a, pc, mcycle, insn);
-            case insn_funct3_00000_opcode::SB:
-                return execute_SB(a, pc, mcycle, insn);
-            case insn_funct3_00000_opcode::SH:
-                return execute_SH(a, pc, mcycle, insn);
-            case insn_funct3_00000_opcode::SW:
-                return execute_SW(a, pc, mcycle, insn);
-            case insn_funct3_00000_opcode::SD:
-                return execute_SD(a, pc, mcycle, insn);
-            case insn_funct3_00000_opcode::FENCE:
-                return execute_FENCE(a, pc, insn);
-            case insn_funct3_00000_opcode::FENCE_I:
-                return execute_FENCE_I(a, pc, insn);
-            case insn_funct3_00000_opcode::ADDI:
-                return execute_ADDI(a, pc, insn);
-            case insn_funct3_00000_opcode::SLLI:
-                return execute_SLLI(a, pc, insn);
-            case insn_funct3_00000_opcode::SLTI:
-                return execute_SLTI(a, pc, insn);
-            case insn_funct3_00000_opcode::SLTIU:
-                return execute_SLTIU(a, pc, insn);
-            case insn_funct3_00000_opcode::XORI:
-                return execute_XORI(a, pc, insn);
-            case insn_funct3_00000_opcode::ORI:
-                return execute_ORI(a, pc, insn);
-            case insn_funct3_00000_opcode::ANDI:
-                return execute_ANDI(a, pc, insn);
-            case insn_funct3_00000_opcode::ADDIW:
-                return execute_ADDIW(a, pc, insn);
-            case insn_funct3_00000_opcode::SLLIW:
-                return execute_SLLIW(a, pc, insn);
-            case insn_funct3_00000_opcode::SLLW:
-                return execute_SLLW(a, pc, insn);
-            case insn_funct3_00000_opcode::DIVW:
-                return execute_DIVW(a, pc, insn);
-            case insn_funct3_00000_opcode::REMW:
-                return execute_REMW(a, pc, insn);
-            case insn_funct3_00000_opcode::REMUW:
-                return execute_REMUW(a, pc, insn);
-            case insn_funct3_00000_opcode::BEQ:
-                return execute_BEQ(a, pc, insn);
-            case insn_funct3_00000_opcode::BNE:
-                return execute_BNE(a, pc, insn);
-            case insn_funct3_00000_opcode::BLT:
-                return execute_BLT(a, pc, insn);
-            case insn_funct3_00000_opcode::BGE:
-                return execute_BGE(a, pc, insn);
-            case insn_funct3_00000_opcode::BLTU:
-                return execute_BLTU(a, pc, insn);
-            case insn_funct3_00000_opcode::BGEU:
-                return execute_BGEU(a, pc, insn);
-            case insn_funct3_00000_opcode::JALR:
-                return execute_JALR(a, pc, insn);
-            case insn_funct3_00000_opcode::CSRRW:
-                return execute_CSRRW(a, pc, mcycle, insn);
-            case insn_funct3_00000_opcode::CSRRS:
-                return execute_CSRRS(a, pc, mcycle, insn);
-            case insn_funct3_00000_opcode::CSRRC:
-                return execute_CSRRC(a, pc, mcycle, insn);
-            case insn_funct3_00000_opcode::CSRRWI:
-                return execute_CSRRWI(a, pc, mcycle, insn);
-            case insn_funct3_00000_opcode::CSRRSI:
-                return execute_CSRRSI(a, pc, mcycle, insn);
-            case insn_funct3_00000_opcode::CSRRCI:
-                return execute_CSRRCI(a, pc, mcycle, insn);
-            case insn_funct3_00000_opcode::AUIPC_000:
-            case insn_funct3_00000_opcode::AUIPC_001:
-            case insn_funct3_00000_opcode::AUIPC_010:
-            case insn_funct3_00000_opcode::AUIPC_011:
-            case insn_funct3_00000_opcode::AUIPC_100:
-            case insn_funct3_00000_opcode::AUIPC_101:
-            case insn_funct3_00000_opcode::AUIPC_110:
-            case insn_funct3_00000_opcode::AUIPC_111:
-                return execute_AUIPC(a, pc, insn);
-            case insn_funct3_00000_opcode::LUI_000:
-            case insn_funct3_00000_opcode::LUI_001:
-            case insn_funct3_00000_opcode::LUI_010:
-            case insn_funct3_00000_opcode::LUI_011:
-            case insn_funct3_00000_opcode::LUI_100:
-            case insn_funct3_00000_opcode::LUI_101:
-            case insn_funct3_00000_opcode::LUI_110:
-            case insn_funct3_00000_opcode::LUI_111:
-                return execute_LUI(a, pc, insn);
-            case insn_funct3_00000_opcode::JAL_000:
-            case insn_funct3_00000_opcode::JAL_001:
-            case insn_funct3_00000_opcode::JAL_010:
-            case insn_funct3_00000_opcode::JAL_011:
-            case insn_funct3_00000_opcode::JAL_100:
-            case insn_funct3_00000_opcode::JAL_101:
-            case insn_funct3_00000_opcode::JAL_110:
-            case insn_funct3_00000_opcode::JAL_111:
-                return execute_JAL(a, pc, insn);
-            case insn_funct3_00000_opcode::SRLI_SRAI:
-                return execute_SRLI_SRAI(a, pc, insn);
-            case insn_funct3_00000_opcode::SRLIW_SRAIW:
-                return execute_SRLIW_SRAIW(a, pc, insn);
-            case insn_funct3_00000_opcode::AMO_W:
-                return execute_AMO_W(a, pc, mcycle, insn);
-            case insn_funct3_00000_opcode::AMO_D:
-                return execute_AMO_D(a, pc, mcycle, insn);
-            case insn_funct3_00000_opcode::ADD_MUL_SUB:
-                return execute_ADD_MUL_SUB(a, pc, insn);
-            case insn_funct3_00000_opcode::SLL_MULH:
-                return execute_SLL_MULH(a, pc, insn);
-            case insn_funct3_00000_opcode::SLT_MULHSU:
-                return execute_SLT_MULHSU(a, pc, insn);
-            case insn_funct3_00000_opcode::SLTU_MULHU:
-                return execute_SLTU_MULHU(a, pc, insn);
-            case insn_funct3_00000_opcode::XOR_DIV:
-                return execute_XOR_DIV(a, pc, insn);
-            case insn_funct3_00000_opcode::SRL_DIVU_SRA:
-                return execute_SRL_DIVU_SRA(a, pc, insn);
-            case insn_funct3_00000_opcode::OR_REM:
-                return execute_OR_REM(a, pc, insn);
-            case insn_funct3_00000_opcode::AND_REMU:
-                return execute_AND_REMU(a, pc, insn);
-            case insn_funct3_00000_opcode::ADDW_MULW_SUBW:
-                return execute_ADDW_MULW_SUBW(a, pc, insn);
-            case insn_funct3_00000_opcode::SRLW_DIVUW_SRAW:
-                return execute_SRLW_DIVUW_SRAW(a, pc, insn);
-            case insn_funct3_00000_opcode::privileged:
-                return execute_privileged(a, pc, mcycle, insn);
-            default: {
-                // Here we are sure that the next instruction, at best, can only be a floating point instruction,
-                // or, at worst, an illegal instruction.
-                // Since all float instructions try to read the float state,
-                // we can put the next check before all of them.
-                // If FS is OFF, attempts to read or write the float state will cause an illegal instruction exception.
-                if (unlikely((a.read_mstatus() & MSTATUS_FS_MASK) == MSTATUS_FS_OFF)) {
-                    return raise_illegal_insn_exception(a, pc, insn);
-                }
-                switch (funct3_00000_opcode) {
-                    case insn_funct3_00000_opcode::FSW:
-                        return execute_FSW(a, pc, mcycle, insn);
-                    case insn_funct3_00000_opcode::FSD:
-                        return execute_FSD(a, pc, mcycle, insn);
-                    case insn_funct3_00000_opcode::FLW:
-                        return execute_FLW(a, pc, mcycle, insn);
-                    case insn_funct3_00000_opcode::FLD:
-                        return execute_FLD(a, pc, mcycle, insn);
-                    case insn_funct3_00000_opcode::FMADD_RNE:
-                    case insn_funct3_00000_opcode::FMADD_RTZ:
-                    case insn_funct3_00000_opcode::FMADD_RDN:
-                    case insn_funct3_00000_opcode::FMADD_RUP:
-                    case insn_funct3_00000_opcode::FMADD_RMM:
-                    case insn_funct3_00000_opcode::FMADD_DYN:
-                        return execute_FMADD(a, pc, insn);
-                    case insn_funct3_00000_opcode::FMSUB_RNE:
-                    case insn_funct3_00000_opcode::FMSUB_RTZ:
-                    case insn_funct3_00000_opcode::FMSUB_RDN:
-                    case insn_funct3_00000_opcode::FMSUB_RUP:
-                    case insn_funct3_00000_opcode::FMSUB_RMM:
-                    case insn_funct3_00000_opcode::FMSUB_DYN:
-                        return execute_FMSUB(a, pc, insn);
-                    case insn_funct3_00000_opcode::FNMSUB_RNE:
-                    case insn_funct3_00000_opcode::FNMSUB_RTZ:
-                    case insn_funct3_00000_opcode::FNMSUB_RDN:
-                    case insn_funct3_00000_opcode::FNMSUB_RUP:
-                    case insn_funct3_00000_opcode::FNMSUB_RMM:
-                    case insn_funct3_00000_opcode::FNMSUB_DYN:
-                        return execute_FNMSUB(a, pc, insn);
-                    case insn_funct3_00000_opcode::FNMADD_RNE:
-                    case insn_funct3_00000_opcode::FNMADD_RTZ:
-                    case insn_funct3_00000_opcode::FNMADD_RDN:
-                    case insn_funct3_00000_opcode::FNMADD_RUP:
-                    case insn_funct3_00000_opcode::FNMADD_RMM:
-                    case insn_funct3_00000_opcode::FNMADD_DYN:
-                        return execute_FNMADD(a, pc, insn);
-                    case insn_funct3_00000_opcode::FD_000:
-                    case insn_funct3_00000_opcode::FD_001:
-                    case insn_funct3_00000_opcode::FD_010:
-                    case insn_funct3_00000_opcode::FD_011:
-                    case insn_funct3_00000_opcode::FD_100:
-                    case insn_funct3_00000_opcode::FD_111:
-                        return execute_FD(a, pc, insn);
-                    default:
-                        return raise_illegal_insn_exception(a, pc, insn);
-                }
+        return &execute_decoded_insn_32<STATE_ACCESS, INDEX>;
+    }
+}
+
+/// \brief Builds a table with the handlers for every uncompressed instruction index.
+template <typename STATE_ACCESS, uint32_t... INDEX>
+static constexpr auto make_decoded_insn_32_handlers(std::integer_sequence<uint32_t, INDEX...>) {
+    return std::array<decoded_insn_handler, sizeof...(INDEX)>{{get_decoded_insn_32_handler<STATE_ACCESS, INDEX>()...}};
+}
+
+/// \brief Handlers for compressed instructions, indexed by decoded_insn_c_index()
+static constexpr auto decoded_insn_c_handlers =
+    make_decoded_insn_c_handlers<state_access>(std::make_integer_sequence<uint32_t, 32>{});
+
+/// \brief Handlers for uncompressed instructions, indexed by decoded_insn_32_index()
+static constexpr auto decoded_insn_32_handlers =
+    make_decoded_insn_32_handlers<state_access>(std::make_integer_sequence<uint32_t, 256>{});
+
+/// \brief Executes an instruction whose funct3 and opcode fields are known at compile time.
+/// \tparam KEY Instruction funct3 and opcode fields, as in insn_c_funct3 or insn_funct3_00000_opcode.
+template <uint32_t KEY, typename STATE_ACCESS>
+static FORCE_INLINE execute_status execute_insn_key(STATE_ACCESS &a, uint64_t &pc, uint64_t &mcycle, uint32_t insn) {
+    if constexpr ((KEY & 3) != 3) {
+        return execute_insn_c(a, pc, mcycle, insn, static_cast<insn_c_funct3>(KEY));
+    } else {
+        return execute_insn_32(a, pc, mcycle, insn, static_cast<insn_funct3_00000_opcode>(KEY));
+    }
+}
+
+/// \brief Executes a fused pair of instructions.
+/// \tparam STATE_ACCESS Class of machine state accessor object.
+/// \tparam FIRST Funct3 and opcode fields of first instruction.
+/// \tparam SECOND Funct3 and opcode fields of second instruction.
+/// \details The first instruction of a pair can never fail, so both instructions always retire,
+/// and the second one sees mcycle already incremented, exactly as if they were executed one at a time.
+/// The second instruction is read again from the page, which cannot have changed while the slot is valid.
+template <typename STATE_ACCESS, uint32_t FIRST, uint32_t SECOND>
+static std::pair<execute_status, uint64_t> execute_fused_insn_pair(STATE_ACCESS &a, uint64_t pc, uint64_t mcycle,
+    uint32_t insn, uint64_t vh_offset) {
+    constexpr uint64_t first_size = ((FIRST & 3) != 3) ? 2 : 4;
+    const auto *next_hptr = cast_addr_to_ptr<unsigned char *>(pc + first_size + vh_offset);
+    uint32_t next_insn = aliased_unaligned_read<uint32_t, uint16_t>(next_hptr);
+    if constexpr ((SECOND & 3) != 3) {
+        next_insn = static_cast<uint16_t>(next_insn);
+    }
+    [[maybe_unused]] const execute_status first_status = execute_insn_key<FIRST>(a, pc, mcycle, insn);
+    assert(first_status == execute_status::success);
+    ++mcycle;
+    const execute_status status = execute_insn_key<SECOND>(a, pc, mcycle, next_insn);
+    return {status, pc};
+}
+
+/// \brief Pair of instructions that can be fused into a single handler.
+struct fused_insn_pair final {
+    uint32_t first_mask;          ///< Bits identifying first instruction
+    uint32_t first_match;         ///< Value of identifying bits in first instruction
+    uint32_t second_mask;         ///< Bits identifying second instruction
+    uint32_t second_match;        ///< Value of identifying bits in second instruction
+    decoded_insn_handler handler; ///< Handler executing both instructions
+};
+
+/// \brief Bits identifying compressed instructions by funct3 and opcode
+static constexpr uint32_t fused_c_funct3_mask = 0b1110000000000011;
+
+/// \brief Bits identifying uncompressed instructions that ignore funct3
+static constexpr uint32_t fused_opcode_mask = 0b1111111;
+
+/// \brief Bits identifying uncompressed instructions by funct3 and opcode
+static constexpr uint32_t fused_funct3_opcode_mask = 0b111000001111111;
+
+/// \brief Bits identifying uncompressed instructions by funct7, funct3 and opcode
+static constexpr uint32_t fused_funct7_funct3_opcode_mask = 0b11111110000000000111000001111111;
+
+/// \brief Returns the bits identifying an instruction by funct3 and opcode
+static constexpr uint32_t get_fused_key_mask(uint32_t key) {
+    return ((key & 3) != 3) ? fused_c_funct3_mask : fused_funct3_opcode_mask;
+}
+
+/// \brief Describes a fused pair.
+/// \tparam FIRST Funct3 and opcode fields of first instruction.
+/// \tparam SECOND Funct3 and opcode fields of second instruction.
+/// \param first_mask Bits identifying first instruction.
+template <auto FIRST, auto SECOND>
+static constexpr fused_insn_pair make_fused_insn_pair(uint32_t first_mask = get_fused_key_mask(to_underlying(FIRST))) {
+    return fused_insn_pair{first_mask, to_underlying(FIRST) & first_mask, get_fused_key_mask(to_underlying(SECOND)),
+        to_underlying(SECOND), &execute_fused_insn_pair<state_access, to_underlying(FIRST), to_underlying(SECOND)>};
+}
+
+/// \brief Common idioms that are fused into a single handler.
+/// \details Only instructions that can never raise an exception appear first in a pair,
+/// which is why SLT and SLTU must be told apart from MULHSU and MULHU by funct7.
+static constexpr fused_insn_pair fused_insn_pairs[] = {
+    // lui rd, %hi(x); addi(w) rd, rd, %lo(x)
+    make_fused_insn_pair<insn_funct3_00000_opcode::LUI_000, insn_funct3_00000_opcode::ADDI>(fused_opcode_mask),
+    make_fused_insn_pair<insn_funct3_00000_opcode::LUI_000, insn_funct3_00000_opcode::ADDIW>(fused_opcode_mask),
+    make_fused_insn_pair<insn_funct3_00000_opcode::LUI_000, insn_c_funct3::C_ADDIW>(fused_opcode_mask),
+    // auipc rd, %pcrel_hi(x); addi rd, rd, %pcrel_lo(x)
+    make_fused_insn_pair<insn_funct3_00000_opcode::AUIPC_000, insn_funct3_00000_opcode::ADDI>(fused_opcode_mask),
+    // auipc rd, %pcrel_hi(x); jalr ra, %pcrel_lo(x)(rd)
+    make_fused_insn_pair<insn_funct3_00000_opcode::AUIPC_000, insn_funct3_00000_opcode::JALR>(fused_opcode_mask),
+    // auipc rd, %pcrel_hi(x); ld rd, %pcrel_lo(x)(rd)
+    make_fused_insn_pair<insn_funct3_00000_opcode::AUIPC_000, insn_funct3_00000_opcode::LD>(fused_opcode_mask),
+    // addi rd, rd, imm; bne/beq rd, rs, label
+    make_fused_insn_pair<insn_funct3_00000_opcode::ADDI, insn_funct3_00000_opcode::BNE>(),
+    make_fused_insn_pair<insn_funct3_00000_opcode::ADDI, insn_funct3_00000_opcode::BEQ>(),
+    make_fused_insn_pair<insn_c_funct3::C_Q1_SET0, insn_funct3_00000_opcode::BNE>(),
+    make_fused_insn_pair<insn_c_funct3::C_Q1_SET0, insn_funct3_00000_opcode::BEQ>(),
+    // slt(u) rd, rs1, rs2; bnez/beqz rd, label
+    make_fused_insn_pair<insn_funct3_00000_opcode::SLT_MULHSU, insn_funct3_00000_opcode::BNE>(
+        fused_funct7_funct3_opcode_mask),
+    make_fused_insn_pair<insn_funct3_00000_opcode::SLT_MULHSU, insn_funct3_00000_opcode::BEQ>(
+        fused_funct7_funct3_opcode_mask),
+    make_fused_insn_pair<insn_funct3_00000_opcode::SLT_MULHSU, insn_c_funct3::C_BNEZ>(
+        fused_funct7_funct3_opcode_mask),
+    make_fused_insn_pair<insn_funct3_00000_opcode::SLT_MULHSU, insn_c_funct3::C_BEQZ>(
+        fused_funct7_funct3_opcode_mask),
+    make_fused_insn_pair<insn_funct3_00000_opcode::SLTU_MULHU, insn_funct3_00000_opcode::BNE>(
+        fused_funct7_funct3_opcode_mask),
+    make_fused_insn_pair<insn_funct3_00000_opcode::SLTU_MULHU, insn_funct3_00000_opcode::BEQ>(
+        fused_funct7_funct3_opcode_mask),
+    make_fused_insn_pair<insn_funct3_00000_opcode::SLTU_MULHU, insn_c_funct3::C_BNEZ>(
+        fused_funct7_funct3_opcode_mask),
+    make_fused_insn_pair<insn_funct3_00000_opcode::SLTU_MULHU, insn_c_funct3::C_BEQZ>(
+        fused_funct7_funct3_opcode_mask),
+    // slti(u) rd, rs1, imm; bnez/beqz rd, label
+    make_fused_insn_pair<insn_funct3_00000_opcode::SLTI, insn_funct3_00000_opcode::BNE>(),
+    make_fused_insn_pair<insn_funct3_00000_opcode::SLTI, insn_c_funct3::C_BNEZ>(),
+    make_fused_insn_pair<insn_funct3_00000_opcode::SLTIU, insn_funct3_00000_opcode::BNE>(),
+    make_fused_insn_pair<insn_funct3_00000_opcode::SLTIU, insn_c_funct3::C_BNEZ>(),
+};
+
+/// \brief Returns the handler for a pair of instructions, or nullptr if they cannot be fused.
+static decoded_insn_handler get_fused_insn_pair_handler(uint32_t insn, uint32_t next_insn) {
+    for (const auto &pair : fused_insn_pairs) {
+        if ((insn & pair.first_mask) == pair.first_match && (next_insn & pair.second_mask) == pair.second_match) {
+            return pair.handler;
+        }
+    }
+    return nullptr;
+}
+
+#else // COMPUTED_GOTO_DISPATCH
+
+// The following lists name the targets of the flat dispatch table, in order.
+// Instructions that ignore funct3, or use it as a rounding mode, share the target of their first variant.
+// NOLINTBEGIN(cppcoreguidelines-macro-usage)
+#define INSN_C_DISPATCH_TARGETS(X)                                                                                     \
+    X(C_ADDI4SPN) X(C_FLD) X(C_LW) X(C_LD) X(C_FSD) X(C_SW) X(C_SD) X(C_Q1_SET0) X(C_ADDIW) X(C_LI) X(C_Q1_SET1)       \
+        X(C_Q1_SET2) X(C_J) X(C_BEQZ) X(C_BNEZ) X(C_SLLI) X(C_FLDSP) X(C_LWSP) X(C_LDSP) X(C_Q2_SET0) X(C_FSDSP)       \
+            X(C_SWSP) X(C_SDSP)
+#define INSN_32_DISPATCH_TARGETS(X)                                                                                    \
+    X(LB) X(LH) X(LW) X(LD) X(LBU) X(LHU) X(LWU) X(SB) X(SH) X(SW) X(SD) X(FENCE) X(FENCE_I) X(ADDI) X(SLLI) X(SLTI)   \
+        X(SLTIU) X(XORI) X(ORI) X(ANDI) X(ADDIW) X(SLLIW) X(SLLW) X(DIVW) X(REMW) X(REMUW) X(BEQ) X(BNE) X(BLT)        \
+            X(BGE) X(BLTU) X(BGEU) X(JALR) X(CSRRW) X(CSRRS) X(CSRRC) X(CSRRWI) X(CSRRSI) X(CSRRCI) X(AUIPC_000)      \
+                X(LUI_000) X(JAL_000) X(FSW) X(FSD) X(FLW) X(FLD) X(FMADD_RNE) X(FMSUB_RNE) X(FNMSUB_RNE)             \
+                    X(FNMADD_RNE) X(FD_000) X(SRLI_SRAI) X(SRLIW_SRAIW) X(AMO_W) X(AMO_D) X(ADD_MUL_SUB) X(SLL_MULH)  \
+                        X(SLT_MULHSU) X(SLTU_MULHU) X(XOR_DIV) X(SRL_DIVU_SRA) X(OR_REM) X(AND_REMU)                  \
+                            X(ADDW_MULW_SUBW) X(SRLW_DIVUW_SRAW) X(privileged)
+#define INSN_C_DISPATCH_KEY(name) insn_c_funct3::name,
+#define INSN_32_DISPATCH_KEY(name) insn_funct3_00000_opcode::name,
+// NOLINTEND(cppcoreguidelines-macro-usage)
+
+/// \brief Compressed instruction keys, in the same order as their dispatch targets
+static constexpr insn_c_funct3 insn_c_dispatch_keys[] = {INSN_C_DISPATCH_TARGETS(INSN_C_DISPATCH_KEY)};
+
+/// \brief Uncompressed instruction keys, in the same order as their dispatch targets
+static constexpr insn_funct3_00000_opcode insn_32_dispatch_keys[] = {INSN_32_DISPATCH_TARGETS(INSN_32_DISPATCH_KEY)};
+
+#undef INSN_C_DISPATCH_KEY
+#undef INSN_32_DISPATCH_KEY
+
+/// \brief Packs all fields needed to identify the dispatch target of an instruction into an 11-bit index.
+/// \details The index holds bits 0 to 6 (opcode) and 12 to 15 (funct3) of the instruction,
+/// which covers both compressed and uncompressed encodings, so no branch is needed before the table lookup.
+static constexpr uint32_t insn_dispatch_index(uint32_t insn) {
+    return ((insn >> 5) & 0b11110000000) | (insn & 0b1111111);
+}
+
+/// \brief Returns the dispatch target for an index, or 0 for illegal instructions.
+/// \details Mirrors the first decoding level of execute_insn().
+static constexpr uint16_t get_insn_dispatch_target(uint32_t index) {
+    const uint32_t insn = ((index & 0b11110000000) << 5) | (index & 0b1111111);
+    const uint32_t num_c_targets = std::size(insn_c_dispatch_keys);
+    if ((insn & 3) != 3) {
+        const auto key = static_cast<insn_c_funct3>(insn & 0b1110000000000011);
+        for (uint32_t i = 0; i < num_c_targets; ++i) {
+            if (insn_c_dispatch_keys[i] == key) {
+                return static_cast<uint16_t>(1 + i);
             }
         }
+        return 0;
     }
+    const uint32_t opcode = insn & 0b1111111;
+    const uint32_t funct3 = (insn >> 12) & 0b111;
+    uint32_t key = insn & 0b111000001111111;
+    // These instructions do not use funct3 for decoding
+    if (opcode == (to_underlying(insn_funct3_00000_opcode::AUIPC_000) & 0b1111111) ||
+        opcode == (to_underlying(insn_funct3_00000_opcode::LUI_000) & 0b1111111) ||
+        opcode == (to_underlying(insn_funct3_00000_opcode::JAL_000) & 0b1111111)) {
+        key = opcode;
+    }
+    // These instructions use funct3 as rounding mode, where 0b101 and 0b110 are invalid
+    if ((opcode == (to_underlying(insn_funct3_00000_opcode::FMADD_RNE) & 0b1111111) ||
+            opcode == (to_underlying(insn_funct3_00000_opcode::FMSUB_RNE) & 0b1111111) ||
+            opcode == (to_underlying(insn_funct3_00000_opcode::FNMSUB_RNE) & 0b1111111) ||
+            opcode == (to_underlying(insn_funct3_00000_opcode::FNMADD_RNE) & 0b1111111) ||
+            opcode == (to_underlying(insn_funct3_00000_opcode::FD_000) & 0b1111111)) &&
+        funct3 != 0b101 && funct3 != 0b110) {
+        key = opcode;
+    }
+    for (uint32_t i = 0; i < std::size(insn_32_dispatch_keys); ++i) {
+        if (to_underlying(insn_32_dispatch_keys[i]) == key) {
+            return static_cast<uint16_t>(1 + num_c_targets + i);
+        }
+    }
+    return 0;
 }
 
+/// \brief Builds the flat dispatch table.
+static constexpr auto make_insn_dispatch_table() {
+    std::array<uint16_t, 2048> table{};
+    for (uint32_t index = 0; index < table.size(); ++index) {
+        table[index] = get_insn_dispatch_target(index);
+    }
+    return table;
+}
+
+/// \brief Dispatch targets, indexed by insn_dispatch_index()
+static constexpr auto insn_dispatch_table = make_insn_dispatch_table();
+
+#endif // COMPUTED_GOTO_DISPATCH
+
+/// \brief Decodes an instruction into a slot for the decoded instruction cache.
+/// \param insn Instruction, as returned by fetch_insn().
+/// \param version Version of the page containing the instruction.
+/// \returns Decoded instruction.
+/// \details The handler (or dispatch target) performs the same decoding as execute_insn(), except for the first level.
+static inline decoded_insn decode_insn(uint32_t insn, uint16_t version) {
+#ifdef COMPUTED_GOTO_DISPATCH
+    const uint16_t target = insn_dispatch_table[insn_dispatch_index(insn)];
+    if ((insn & 3) != 3) {
+        insn = static_cast<uint16_t>(insn);
+    }
+    return decoded_insn{nullptr, insn, version, target};
+#else
+    if ((insn & 3) != 3) {
+        insn = static_cast<uint16_t>(insn);
+        return decoded_insn{decoded_insn_c_handlers[decoded_insn_c_index(insn)], insn, version, 0};
+    }
+    return decoded_insn{decoded_insn_32_handlers[decoded_insn_32_index(insn)], insn, version, 0};
+#endif
+}
+
+#endif // MICROARCHITECTURE
+
 /// \brief Instruction fetch status code
 enum class fetch_status : int {
     exception, ///< Instruction fetch failed: exception raised
@@ -5407,7 +5814,7 @@ static FORCE_INLINE fetch_status fetch_translate_pc_slow(STATE_ACCESS &a, uint64
     unsigned char **phptr) {
     uint64_t paddr{};
     // Walk page table and obtain the physical address
-    if (unlikely(!translate_virtual_address(a, &paddr, vaddr, PTE_XWR_X_SHIFT))) {
+    if (unlikely(!translate_virtual_address_via_host_tlb<TLB_CODE>(a, &paddr, vaddr, PTE_XWR_X_SHIFT))) {
         pc = raise_exception(a, pc, MCAUSE_FETCH_PAGE_FAULT, vaddr);
         return fetch_status::exception;
     }
@@ -5502,6 +5909,120 @@ static FORCE_INLINE fetch_status fetch_insn(STATE_ACCESS &a, uint64_t &pc, uint3
     return fetch_status::success;
 }
 
+#ifndef MICROARCHITECTURE
+
+/// \brief Loads and decodes the next instruction, when it is not in the decoded instruction cache.
+/// \tparam STATE_ACCESS Class of machine state accessor object.
+/// \param a Machine state accessor object.
+/// \param pc Virtual address for the current instruction being executed.
+/// \param dinsn Receives the decoded instruction.
+/// \param fetch_vaddr_page Fetch virtual address translation page cache.
+/// \param fetch_vh_offset Fetch virtual address host pointer offset cache.
+/// \param fetch_dpage Decoded page cache for the fetch translation.
+/// \return Returns fetch_status::success if load succeeded, fetch_status::exception if it caused an exception.
+//          In that case, raise the exception.
+/// \details This function is outlined to minimize host CPU code cache pressure.
+template <typename STATE_ACCESS>
+static NO_INLINE fetch_status fetch_decoded_insn_slow(STATE_ACCESS &a, uint64_t &pc, decoded_insn &dinsn,
+    uint64_t &fetch_vaddr_page, uint64_t &fetch_vh_offset, decoded_page *&fetch_dpage) {
+    const uint64_t vaddr_page = pc & ~PAGE_OFFSET_MASK;
+    const bool same_page = vaddr_page == fetch_vaddr_page;
+    uint32_t insn = 0;
+    if (unlikely(fetch_insn(a, pc, insn, fetch_vaddr_page, fetch_vh_offset) == fetch_status::exception)) {
+        return fetch_status::exception;
+    }
+    // If the fetch performed an address translation, look up the decoded page again
+    if (!same_page || vaddr_page != fetch_vaddr_page) {
+        machine &m = a.get_naked_machine();
+        fetch_dpage = m.get_decode_cache().get_code_page(m.get_state().tlb, tlb_get_entry_index(fetch_vaddr_page),
+            fetch_vaddr_page);
+    }
+    // Instructions from pages that can be written through the TLB are never cached,
+    // so stop looking them up until the next address translation
+    if (fetch_dpage && fetch_dpage->write_refs != 0) {
+        fetch_dpage = nullptr;
+    }
+#ifdef COMPUTED_GOTO_DISPATCH
+    if (!fetch_dpage) {
+        dinsn = decode_insn(insn, 0);
+        return fetch_status::success;
+    }
+    dinsn = decode_insn(insn, fetch_dpage->version);
+    // Instructions crossing a page boundary are not cached either
+    if (vaddr_page == fetch_vaddr_page) {
+#else
+    if (!fetch_dpage) {
+        dinsn = decoded_insn{nullptr, insn, 0, 0};
+        return fetch_status::success;
+    }
+    dinsn = decode_insn(insn, fetch_dpage->version);
+    // Instructions without a handler or crossing a page boundary are not cached either
+    if (dinsn.handler && vaddr_page == fetch_vaddr_page) {
+        // Fuse the instruction with the next one, if it is in the same page and they form a known idiom
+        const uint64_t next_pc = pc + (((insn & 3) == 3) ? 4 : 2);
+        if ((next_pc & PAGE_OFFSET_MASK) <= PMA_PAGE_SIZE - 4) {
+            const auto *next_hptr = cast_addr_to_ptr<unsigned char *>(next_pc + fetch_vh_offset);
+            const auto next_insn = aliased_unaligned_read<uint32_t, uint16_t>(next_hptr);
+            const decoded_insn_handler handler = get_fused_insn_pair_handler(insn, next_insn);
+            if (handler) {
+                dinsn.handler = handler;
+                dinsn.target = 1;
+            }
+        }
+#endif
+        fetch_dpage->insns[(pc & PAGE_OFFSET_MASK) >> 1] = dinsn;
+    }
+    return fetch_status::success;
+}
+
+/// \brief Loads the next instruction, already decoded.
+/// \tparam STATE_ACCESS Class of machine state accessor object.
+/// \param a Machine state accessor object.
+/// \param pc Virtual address for the current instruction being executed.
+/// \param dinsn Receives the decoded instruction.
+/// \param fetch_vaddr_page Fetch virtual address translation page cache.
+/// \param fetch_vh_offset Fetch virtual address host pointer offset cache.
+/// \param fetch_dpage Decoded page cache for the fetch translation.
+/// \return Returns fetch_status::success if load succeeded, fetch_status::exception if it caused an exception.
+//          In that case, raise the exception.
+template <typename STATE_ACCESS>
+static FORCE_INLINE fetch_status fetch_decoded_insn(STATE_ACCESS &a, uint64_t &pc, decoded_insn &dinsn,
+    uint64_t &fetch_vaddr_page, uint64_t &fetch_vh_offset, decoded_page *&fetch_dpage) {
+    if (likely((pc & ~PAGE_OFFSET_MASK) == fetch_vaddr_page)) {
+        // If pc is in the same page as the last pc fetch and was already decoded,
+        // we can skip fetching and decoding altogether.
+        if (likely(fetch_dpage != nullptr)) {
+            dinsn = fetch_dpage->insns[(pc & PAGE_OFFSET_MASK) >> 1];
+            if (likely(dinsn.version == fetch_dpage->version)) {
+                return fetch_status::success;
+            }
+        } else {
+            // The page is not cached, so just fetch the instruction reusing the last fetch translation
+            dinsn = decoded_insn{nullptr, 0, 0, 0};
+#ifdef COMPUTED_GOTO_DISPATCH
+            if (unlikely(fetch_insn(a, pc, dinsn.insn, fetch_vaddr_page, fetch_vh_offset) ==
+                    fetch_status::exception)) {
+                return fetch_status::exception;
+            }
+            dinsn = decode_insn(dinsn.insn, 0);
+            return fetch_status::success;
+#else
+            return fetch_insn(a, pc, dinsn.insn, fetch_vaddr_page, fetch_vh_offset);
+#endif
+        }
+    }
+    // Work on copies, so taking their addresses does not force pc and dinsn out of registers in the interpreter loop
+    uint64_t slow_pc = pc;
+    decoded_insn slow_dinsn{};
+    const fetch_status status =
+        fetch_decoded_insn_slow(a, slow_pc, slow_dinsn, fetch_vaddr_page, fetch_vh_offset, fetch_dpage);
+    pc = slow_pc;
+    dinsn = slow_dinsn;
+    return status;
+}
+
+#endif // MICROARCHITECTURE
+
 /// \brief Checks that false brk is consistent with rest of state
 template <typename STATE_ACCESS>
 static void assert_no_brk(STATE_ACCESS &a) {
@@ -5529,6 +6050,9 @@ NO_INLINE void interpret_loop(STATE_ACCESS &a, uint64_t mcycle_end, uint64_t mcy
     // Initialize fetch address translation cache invalidated
     uint64_t fetch_vaddr_page = PAGE_OFFSET_MASK;
     uint64_t fetch_vh_offset = 0;
+#ifndef MICROARCHITECTURE
+    decoded_page *fetch_dpage = nullptr;
+#endif
 
     // The outer loop continues until there is an interruption that should be handled
     // externally, or mcycle reaches mcycle_end
@@ -5554,12 +6078,64 @@ NO_INLINE void interpret_loop(STATE_ACCESS &a, uint64_t mcycle_end, uint64_t mcy
         while (mcycle < mcycle_tick_end) {
             INC_COUNTER(a.get_statistics(), inner_loop);
 
+#ifdef MICROARCHITECTURE
             uint32_t insn = 0;
 
             // Try to fetch the next instruction
             if (likely(fetch_insn(a, pc, insn, fetch_vaddr_page, fetch_vh_offset) == fetch_status::success)) {
                 // Try to execute it
                 const execute_status status = execute_insn(a, pc, mcycle, insn);
+#else
+            decoded_insn dinsn{};
+
+            // Try to fetch the next instruction, going through the decoded instruction cache
+            if (likely(fetch_decoded_insn(a, pc, dinsn, fetch_vaddr_page, fetch_vh_offset, fetch_dpage) ==
+                    fetch_status::success)) {
+                execute_status status = execute_status::success;
+#ifdef COMPUTED_GOTO_DISPATCH
+                // Jump straight to the code executing its first decoding level
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+// NOLINTBEGIN(cppcoreguidelines-macro-usage)
+#define INSN_C_DISPATCH_LABEL(name) &&dispatch_##name,
+#define INSN_32_DISPATCH_LABEL(name) &&dispatch_##name,
+                static void *const insn_dispatch_labels[] = {&&dispatch_illegal,
+                    INSN_C_DISPATCH_TARGETS(INSN_C_DISPATCH_LABEL) INSN_32_DISPATCH_TARGETS(INSN_32_DISPATCH_LABEL)};
+#define INSN_C_DISPATCH_CASE(name)                                                                                     \
+    dispatch_##name : status = execute_insn_c(a, pc, mcycle, insn, insn_c_funct3::name);                               \
+    goto dispatched;
+#define INSN_32_DISPATCH_CASE(name)                                                                                    \
+    dispatch_##name : status = execute_insn_32(a, pc, mcycle, insn, insn_funct3_00000_opcode::name);                   \
+    goto dispatched;
+                // NOLINTEND(cppcoreguidelines-macro-usage)
+                const uint32_t insn = dinsn.insn;
+                goto *insn_dispatch_labels[dinsn.target];
+                INSN_C_DISPATCH_TARGETS(INSN_C_DISPATCH_CASE)
+                INSN_32_DISPATCH_TARGETS(INSN_32_DISPATCH_CASE)
+            dispatch_illegal:
+                status = raise_illegal_insn_exception(a, pc, insn);
+            dispatched:
+#undef INSN_C_DISPATCH_LABEL
+#undef INSN_32_DISPATCH_LABEL
+#undef INSN_C_DISPATCH_CASE
+#undef INSN_32_DISPATCH_CASE
+#pragma GCC diagnostic pop
+#else
+                // Try to execute it, preferably through its handler
+                if (likely(dinsn.handler != nullptr)) {
+                    // Fused instructions must retire one at a time if they do not all fit before mcycle_tick_end
+                    if (unlikely(mcycle + dinsn.target >= mcycle_tick_end)) {
+                        dinsn = decode_insn(dinsn.insn, 0);
+                    }
+                    const auto result = dinsn.handler(a, pc, mcycle, dinsn.insn, fetch_vh_offset);
+                    status = result.first;
+                    pc = result.second;
+                    mcycle += dinsn.target;
+                } else {
+                    status = execute_insn(a, pc, mcycle, dinsn.insn);
+                }
+#endif
+#endif
 
                 // When execute status is above success, we have to deal with special loop conditions,
                 // this is very unlikely to happen most of the time
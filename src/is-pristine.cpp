@@ -0,0 +1,89 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <cstdint>
+#include <cstring>
+
+#include "host-cpu-features.h"
+#include "is-pristine.h"
+
+namespace cartesi {
+
+/// \brief Number of bytes ORed together before checking for non-zero bytes
+constexpr size_t pristine_block_size = 64;
+
+/// \brief Bytes ORed together by a single vector operation
+using pristine_vector = uint64_t __attribute__((vector_size(32)));
+
+/// \brief Checks blocks of memory, one vector at a time.
+static inline __attribute__((always_inline)) bool is_pristine_blocks(const unsigned char *data, size_t length) {
+    constexpr size_t vectors_per_block = pristine_block_size / sizeof(pristine_vector);
+    size_t offset = 0;
+    for (; offset + pristine_block_size <= length; offset += pristine_block_size) {
+        pristine_vector acc{};
+#pragma GCC unroll 2
+        for (size_t i = 0; i < vectors_per_block; ++i) {
+            pristine_vector v{};
+            memcpy(&v, data + offset + i * sizeof(v), sizeof(v));
+            acc |= v;
+        }
+        uint64_t any = 0;
+#pragma GCC unroll 4
+        for (size_t i = 0; i < sizeof(acc) / sizeof(uint64_t); ++i) {
+            any |= acc[i];
+        }
+        if (any != 0) {
+            return false;
+        }
+    }
+    // Remaining bytes, if length is not a multiple of the block size
+    unsigned char any = 0;
+    for (; offset < length; ++offset) {
+        any |= data[offset];
+    }
+    return any == 0;
+}
+
+static bool is_pristine_generic(const unsigned char *data, size_t length) {
+    return is_pristine_blocks(data, length);
+}
+
+#ifdef __x86_64__
+__attribute__((target("avx2"))) static bool is_pristine_avx2(const unsigned char *data, size_t length) {
+    return is_pristine_blocks(data, length);
+}
+#endif
+
+using is_pristine_function = bool (*)(const unsigned char *data, size_t length);
+
+/// \brief Returns the fastest implementation supported by the host.
+static is_pristine_function select_is_pristine(void) {
+#ifdef __x86_64__
+    if (host_supports_avx2()) {
+        return is_pristine_avx2;
+    }
+#endif
+    return is_pristine_generic;
+}
+
+/// \brief Implementation used by is_pristine()
+static const is_pristine_function g_is_pristine = select_is_pristine();
+
+bool is_pristine(const unsigned char *data, size_t length) {
+    return g_is_pristine(data, length);
+}
+
+} // namespace cartesi
@@ -0,0 +1,37 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef IS_PRISTINE_H
+#define IS_PRISTINE_H
+
+/// \file
+/// \brief Detection of pristine (i.e., all-zero) memory.
+
+#include <cstddef>
+
+namespace cartesi {
+
+/// \brief Checks if a range of memory is pristine, i.e., filled with zeros.
+/// \param data Pointer to start of range.
+/// \param length Length of range in bytes.
+/// \returns True if all bytes in range are zero.
+/// \details Bytes are ORed together 64 at a time, using AVX2 instructions on x86-64 hosts that support them,
+/// and returns as soon as a block is found to be non-zero.
+bool is_pristine(const unsigned char *data, size_t length);
+
+} // namespace cartesi
+
+#endif
@@ -426,6 +426,66 @@ template void ju_get_opt_field<bool>(const nlohmann::json &j, const bool &key, h
 template void ju_get_opt_field<std::string>(const nlohmann::json &j, const std::string &key, htif_runtime_config &value,
     const std::string &path);
 
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key, tlb_runtime_config &value, const std::string &path) {
+    if (!contains(j, key)) {
+        return;
+    }
+    ju_get_opt_field(j[key], "sets"s, value.sets, path + to_string(key) + "/");
+    ju_get_opt_field(j[key], "ways"s, value.ways, path + to_string(key) + "/");
+}
+
+template void ju_get_opt_field<uint64_t>(const nlohmann::json &j, const uint64_t &key, tlb_runtime_config &value,
+    const std::string &path);
+
+template void ju_get_opt_field<std::string>(const nlohmann::json &j, const std::string &key, tlb_runtime_config &value,
+    const std::string &path);
+
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key, hasher_runtime_config &value, const std::string &path) {
+    if (!contains(j, key)) {
+        return;
+    }
+    ju_get_opt_field(j[key], "page_cache_entries"s, value.page_cache_entries, path + to_string(key) + "/");
+}
+
+template void ju_get_opt_field<uint64_t>(const nlohmann::json &j, const uint64_t &key, hasher_runtime_config &value,
+    const std::string &path);
+
+template void ju_get_opt_field<std::string>(const nlohmann::json &j, const std::string &key,
+    hasher_runtime_config &value, const std::string &path);
+
+/// \brief Converts between an image prefault policy name and an image prefault policy
+/// \param name Image prefault policy name
+/// \param path Path to field holding the name, used in error messages
+/// \returns The image prefault policy
+static image_prefault_policy image_prefault_from_name(const std::string &name, const std::string &path) {
+    if (name == "none") {
+        return image_prefault_policy::none;
+    }
+    if (name == "willneed") {
+        return image_prefault_policy::willneed;
+    }
+    if (name == "populate") {
+        return image_prefault_policy::populate;
+    }
+    throw std::invalid_argument("field \""s + path + "\" not a valid image prefault policy");
+}
+
+/// \brief Converts between an image prefault policy and an image prefault policy name
+/// \param policy Image prefault policy
+/// \returns The image prefault policy name
+static const char *image_prefault_to_name(image_prefault_policy policy) {
+    switch (policy) {
+        case image_prefault_policy::willneed:
+            return "willneed";
+        case image_prefault_policy::populate:
+            return "populate";
+        default:
+            return "none";
+    }
+}
+
 template <typename K>
 void ju_get_opt_field(const nlohmann::json &j, const K &key, machine_runtime_config &value, const std::string &path) {
     if (!contains(j, key)) {
@@ -433,6 +493,19 @@ void ju_get_opt_field(const nlohmann::json &j, const K &key, machine_runtime_con
     }
     ju_get_field(j[key], "concurrency"s, value.concurrency, path + to_string(key) + "/");
     ju_get_field(j[key], "htif"s, value.htif, path + to_string(key) + "/");
+    ju_get_opt_field(j[key], "tlb"s, value.tlb, path + to_string(key) + "/");
+    ju_get_opt_field(j[key], "hasher"s, value.hasher, path + to_string(key) + "/");
+    ju_get_opt_field(j[key], "merkle_cache"s, value.merkle_cache, path + to_string(key) + "/");
+    ju_get_opt_field(j[key], "store_direct_io"s, value.store_direct_io, path + to_string(key) + "/");
+    ju_get_opt_field(j[key], "store_compressed"s, value.store_compressed, path + to_string(key) + "/");
+    if (contains(j[key], "image_prefault"s)) {
+        const auto &jp = j[key]["image_prefault"];
+        const auto prefault_path = path + to_string(key) + "/image_prefault";
+        if (!jp.is_string()) {
+            throw std::invalid_argument("field \""s + prefault_path + "\" not a string");
+        }
+        value.image_prefault = image_prefault_from_name(jp.template get<std::string>(), prefault_path);
+    }
     ju_get_opt_field(j[key], "skip_root_hash_check"s, value.skip_root_hash_check, path + to_string(key) + "/");
     ju_get_opt_field(j[key], "skip_version_check"s, value.skip_version_check, path + to_string(key) + "/");
 }
@@ -518,6 +591,98 @@ template void ju_get_opt_field<uint64_t>(const nlohmann::json &j, const uint64_t
 template void ju_get_opt_field<std::string>(const nlohmann::json &j, const std::string &key,
     not_default_constructible<machine_merkle_tree::proof_type> &value, const std::string &path);
 
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key, machine_merkle_tree::multiproof_type::target_type &value,
+    const std::string &path) {
+    if (!contains(j, key)) {
+        return;
+    }
+    const auto &jk = j[key];
+    if (!jk.is_object()) {
+        throw std::invalid_argument("field \""s + path + to_string(key) + "\" not an object");
+    }
+    const auto new_path = path + to_string(key) + "/";
+    ju_get_field(jk, "address"s, value.address, new_path);
+    uint64_t log2_size = 0;
+    ju_get_field(jk, "log2_size"s, log2_size, new_path);
+    if (log2_size > INT_MAX) {
+        throw std::domain_error("field \""s + new_path + "log2_size\" is out of bounds");
+    }
+    value.log2_size = static_cast<int>(log2_size);
+}
+
+template void ju_get_opt_field<uint64_t>(const nlohmann::json &j, const uint64_t &key,
+    machine_merkle_tree::multiproof_type::target_type &value, const std::string &path);
+
+template void ju_get_opt_field<std::string>(const nlohmann::json &j, const std::string &key,
+    machine_merkle_tree::multiproof_type::target_type &value, const std::string &path);
+
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key,
+    std::vector<machine_merkle_tree::multiproof_type::target_type> &value, const std::string &path) {
+    ju_get_opt_vector_like_field(j, key, value, path);
+}
+
+template void ju_get_opt_field<uint64_t>(const nlohmann::json &j, const uint64_t &key,
+    std::vector<machine_merkle_tree::multiproof_type::target_type> &value, const std::string &path);
+
+template void ju_get_opt_field<std::string>(const nlohmann::json &j, const std::string &key,
+    std::vector<machine_merkle_tree::multiproof_type::target_type> &value, const std::string &path);
+
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key, machine_merkle_tree::multiproof_type::node_type &value,
+    const std::string &path) {
+    if (!contains(j, key)) {
+        return;
+    }
+    const auto &jk = j[key];
+    if (!jk.is_object()) {
+        throw std::invalid_argument("field \""s + path + to_string(key) + "\" not an object");
+    }
+    const auto new_path = path + to_string(key) + "/";
+    ju_get_field(jk, "address"s, value.address, new_path);
+    uint64_t log2_size = 0;
+    ju_get_field(jk, "log2_size"s, log2_size, new_path);
+    if (log2_size > INT_MAX) {
+        throw std::domain_error("field \""s + new_path + "log2_size\" is out of bounds");
+    }
+    value.log2_size = static_cast<int>(log2_size);
+    ju_get_field(jk, "hash"s, value.hash, new_path);
+}
+
+template void ju_get_opt_field<uint64_t>(const nlohmann::json &j, const uint64_t &key,
+    machine_merkle_tree::multiproof_type::node_type &value, const std::string &path);
+
+template void ju_get_opt_field<std::string>(const nlohmann::json &j, const std::string &key,
+    machine_merkle_tree::multiproof_type::node_type &value, const std::string &path);
+
+template <typename K>
+void ju_get_opt_field(const nlohmann::json &j, const K &key,
+    not_default_constructible<machine_merkle_tree::multiproof_type> &value, const std::string &path) {
+    value = {};
+    if (!contains(j, key)) {
+        return;
+    }
+    const auto &jk = j[key];
+    const auto new_path = path + to_string(key) + "/";
+    uint64_t log2_root_size = 0;
+    ju_get_field(jk, "log2_root_size"s, log2_root_size, new_path);
+    if (log2_root_size > INT_MAX) {
+        throw std::domain_error("field \""s + new_path + "log2_root_size\" is out of bounds");
+    }
+    value.emplace(static_cast<int>(log2_root_size));
+    auto &multiproof = value.value();
+    ju_get_field(jk, "root_hash"s, multiproof.get_root_hash(), new_path);
+    ju_get_vector_like_field(jk, "targets"s, multiproof.get_targets(), new_path);
+    ju_get_vector_like_field(jk, "siblings"s, multiproof.get_siblings(), new_path);
+}
+
+template void ju_get_opt_field<uint64_t>(const nlohmann::json &j, const uint64_t &key,
+    not_default_constructible<machine_merkle_tree::multiproof_type> &value, const std::string &path);
+
+template void ju_get_opt_field<std::string>(const nlohmann::json &j, const std::string &key,
+    not_default_constructible<machine_merkle_tree::multiproof_type> &value, const std::string &path);
+
 template <typename K>
 void ju_get_opt_field(const nlohmann::json &j, const K &key, access_type &value, const std::string &path) {
     if (!contains(j, key)) {
@@ -1051,6 +1216,19 @@ void to_json(nlohmann::json &j, const machine_merkle_tree::proof_type &p) {
         {"root_hash", encode_base64(p.get_root_hash())}, {"sibling_hashes", s}};
 }
 
+void to_json(nlohmann::json &j, const machine_merkle_tree::multiproof_type::target_type &t) {
+    j = nlohmann::json{{"address", t.address}, {"log2_size", t.log2_size}};
+}
+
+void to_json(nlohmann::json &j, const machine_merkle_tree::multiproof_type::node_type &n) {
+    j = nlohmann::json{{"address", n.address}, {"log2_size", n.log2_size}, {"hash", encode_base64(n.hash)}};
+}
+
+void to_json(nlohmann::json &j, const machine_merkle_tree::multiproof_type &p) {
+    j = nlohmann::json{{"log2_root_size", p.get_log2_root_size()}, {"root_hash", encode_base64(p.get_root_hash())},
+        {"targets", p.get_targets()}, {"siblings", p.get_siblings()}};
+}
+
 void to_json(nlohmann::json &j, const access &a) {
     j = nlohmann::json{
         {"type", access_type_name(a.get_type())},
@@ -1215,10 +1393,29 @@ void to_json(nlohmann::json &j, const htif_runtime_config &config) {
     };
 }
 
+void to_json(nlohmann::json &j, const tlb_runtime_config &config) {
+    j = nlohmann::json{
+        {"sets", config.sets},
+        {"ways", config.ways},
+    };
+}
+
+void to_json(nlohmann::json &j, const hasher_runtime_config &config) {
+    j = nlohmann::json{
+        {"page_cache_entries", config.page_cache_entries},
+    };
+}
+
 void to_json(nlohmann::json &j, const machine_runtime_config &runtime) {
     j = nlohmann::json{
         {"concurrency", runtime.concurrency},
         {"htif", runtime.htif},
+        {"tlb", runtime.tlb},
+        {"hasher", runtime.hasher},
+        {"merkle_cache", runtime.merkle_cache},
+        {"store_direct_io", runtime.store_direct_io},
+        {"store_compressed", runtime.store_compressed},
+        {"image_prefault", image_prefault_to_name(runtime.image_prefault)},
         {"skip_root_hash_check", runtime.skip_root_hash_check},
         {"skip_version_check", runtime.skip_version_check},
     };
@@ -743,6 +743,22 @@ static json jsonrpc_machine_store_handler(const json &j, mg_connection *con, htt
     return jsonrpc_response_ok(j);
 }
 
+/// \brief JSONRPC handler for the machine.store_delta method
+/// \param j JSON request object
+/// \param con Mongoose connection
+/// \param h Handler data
+/// \returns JSON response object
+static json jsonrpc_machine_store_delta_handler(const json &j, mg_connection *con, http_handler_data *h) {
+    (void) con;
+    if (!h->machine) {
+        return jsonrpc_response_invalid_request(j, "no machine");
+    }
+    static const char *param_name[] = {"directory", "base_directory"};
+    auto args = parse_args<std::string, std::string>(j, param_name);
+    h->machine->store_delta(std::get<0>(args), std::get<1>(args));
+    return jsonrpc_response_ok(j);
+}
+
 /// \brief Translate an interpret_break_reason value to string
 /// \param reason interpret_break_reason value to translate
 /// \returns String representation of value
@@ -924,6 +940,21 @@ static json jsonrpc_machine_get_proof_handler(const json &j, mg_connection *con,
     return jsonrpc_response_ok(j, h->machine->get_proof(std::get<0>(args), static_cast<int>(std::get<1>(args))));
 }
 
+/// \brief JSONRPC handler for the machine.get_proofs method
+/// \param j JSON request object
+/// \param con Mongoose connection
+/// \param h Handler data
+/// \returns JSON response object
+static json jsonrpc_machine_get_proofs_handler(const json &j, mg_connection *con, http_handler_data *h) {
+    (void) con;
+    if (!h->machine) {
+        return jsonrpc_response_invalid_request(j, "no machine");
+    }
+    static const char *param_name[] = {"targets"};
+    auto args = parse_args<std::vector<cartesi::machine_merkle_tree::multiproof_type::target_type>>(j, param_name);
+    return jsonrpc_response_ok(j, h->machine->get_proofs(std::get<0>(args)));
+}
+
 /// \brief JSONRPC handler for the machine.verify_merkle_tree method
 /// \param j JSON request object
 /// \param con Mongoose connection
@@ -1538,12 +1569,14 @@ static json jsonrpc_dispatch_method(const json &j, mg_connection *con, http_hand
         {"machine.machine.directory", jsonrpc_machine_machine_directory_handler},
         {"machine.destroy", jsonrpc_machine_destroy_handler},
         {"machine.store", jsonrpc_machine_store_handler},
+        {"machine.store_delta", jsonrpc_machine_store_delta_handler},
         {"machine.run", jsonrpc_machine_run_handler},
         {"machine.run_uarch", jsonrpc_machine_run_uarch_handler},
         {"machine.step_uarch", jsonrpc_machine_step_uarch_handler},
         {"machine.verify_access_log", jsonrpc_machine_verify_access_log_handler},
         {"machine.verify_state_transition", jsonrpc_machine_verify_state_transition_handler},
         {"machine.get_proof", jsonrpc_machine_get_proof_handler},
+        {"machine.get_proofs", jsonrpc_machine_get_proofs_handler},
         {"machine.get_root_hash", jsonrpc_machine_get_root_hash_handler},
         {"machine.read_word", jsonrpc_machine_read_word_handler},
         {"machine.read_memory", jsonrpc_machine_read_memory_handler},
@@ -313,6 +313,12 @@ void jsonrpc_virtual_machine::do_store(const std::string &directory) {
     jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.store", std::tie(directory), result);
 }
 
+void jsonrpc_virtual_machine::do_store_delta(const std::string &directory, const std::string &base_directory) {
+    bool result = false;
+    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.store_delta",
+        std::tie(directory, base_directory), result);
+}
+
 uint64_t jsonrpc_virtual_machine::do_read_csr(csr r) const {
     uint64_t result = 0;
     jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.read_csr", std::tie(r), result);
@@ -777,6 +783,16 @@ machine_merkle_tree::proof_type jsonrpc_virtual_machine::do_get_proof(uint64_t a
     return std::move(result).value();
 }
 
+machine_merkle_tree::multiproof_type jsonrpc_virtual_machine::do_get_proofs(
+    const std::vector<machine_merkle_tree::multiproof_type::target_type> &targets) const {
+    not_default_constructible<machine_merkle_tree::multiproof_type> result;
+    jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.get_proofs", std::tie(targets), result);
+    if (!result.has_value()) {
+        throw std::runtime_error("jsonrpc server error: missing result");
+    }
+    return std::move(result).value();
+}
+
 void jsonrpc_virtual_machine::do_replace_memory_range(const memory_range_config &new_range) {
     bool result = false;
     jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.replace_memory_range", std::tie(new_range),
@@ -805,6 +821,10 @@ bool jsonrpc_virtual_machine::do_verify_dirty_page_maps(void) const {
     return result;
 }
 
+void jsonrpc_virtual_machine::do_get_page_hash_cache_stats(uint64_t & /*hits*/, uint64_t & /*misses*/) const {
+    throw std::runtime_error("page hash cache statistics are not supported");
+}
+
 void jsonrpc_virtual_machine::do_dump_pmas(void) const {
     bool result = false;
     jsonrpc_request(m_mgr->get_mgr(), m_mgr->get_remote_address(), "machine.dump_pmas", std::tie(), result);
@@ -0,0 +1,221 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include "host-cpu-features.h"
+#include "keccak-256-batch.h"
+
+namespace cartesi {
+
+// Keccak lanes are little-endian, so blocks and hashes can be copied directly to and from the state
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "multi-buffer Keccak-256 requires a little-endian host");
+
+// The vector type holds the same 64-bit lane of the state of each message being hashed.
+// Compilers map operations on it to whatever SIMD instructions the target supports
+// (e.g., two SSE2 or one AVX2 instruction on x86-64, two NEON instructions on AArch64).
+// With a single message, it degenerates into plain 64-bit integer operations.
+// GCC drops vector attributes from alias templates, so the type is declared inside a class template instead.
+template <size_t LANES>
+struct keccak_vector {
+    typedef uint64_t type __attribute__((vector_size(LANES * sizeof(uint64_t)))); // NOLINT(modernize-use-using)
+};
+
+template <size_t LANES>
+using keccak_lanes = typename keccak_vector<LANES>::type;
+
+template <size_t LANES>
+using keccak_state = std::array<keccak_lanes<LANES>, 25>;
+
+/// \brief Keccak-256 rate in bytes
+constexpr size_t keccak_256_rate = 136;
+
+/// \brief Keccak-256 hash size in bytes
+constexpr size_t keccak_256_hash_size = 32;
+
+static constexpr std::array<uint64_t, 24> keccak_round_constants{UINT64_C(0x0000000000000001),
+    UINT64_C(0x0000000000008082), UINT64_C(0x800000000000808a), UINT64_C(0x8000000080008000),
+    UINT64_C(0x000000000000808b), UINT64_C(0x0000000080000001), UINT64_C(0x8000000080008081),
+    UINT64_C(0x8000000000008009), UINT64_C(0x000000000000008a), UINT64_C(0x0000000000000088),
+    UINT64_C(0x0000000080008009), UINT64_C(0x000000008000000a), UINT64_C(0x000000008000808b),
+    UINT64_C(0x800000000000008b), UINT64_C(0x8000000000008089), UINT64_C(0x8000000000008003),
+    UINT64_C(0x8000000000008002), UINT64_C(0x8000000000000080), UINT64_C(0x000000000000800a),
+    UINT64_C(0x800000008000000a), UINT64_C(0x8000000080008081), UINT64_C(0x8000000000008080),
+    UINT64_C(0x0000000080000001), UINT64_C(0x8000000080008008)};
+
+// Lanes are rotated inline, since passing vectors to functions by value changes ABI with the target instruction set
+// Rotation offsets and destinations of the combined rho and pi steps, following the lane at index 1
+static constexpr std::array<int, 24> keccak_rho_offsets{1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14, 27, 41, 56, 8,
+    25, 43, 62, 18, 39, 61, 20, 44};
+static constexpr std::array<int, 24> keccak_pi_lanes{10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4, 15, 23, 19, 13, 12,
+    2, 20, 14, 22, 9, 6, 1};
+
+/// \brief Applies the Keccak-f[1600] permutation to the states of all messages at once.
+/// \details Always inlined, so it is compiled for the instruction set of each backend that uses it.
+/// Steps within a round are fully unrolled, so lane indices are constant and lanes can stay in registers.
+template <size_t LANES>
+static inline __attribute__((always_inline)) void keccak_f1600(keccak_state<LANES> &a) {
+    using lanes = keccak_lanes<LANES>;
+    for (const uint64_t round_constant : keccak_round_constants) {
+        std::array<lanes, 5> c{};
+        // Theta
+#pragma GCC unroll 5
+        for (int x = 0; x < 5; ++x) {
+            c[x] = a[x] ^ a[x + 5] ^ a[x + 10] ^ a[x + 15] ^ a[x + 20];
+        }
+#pragma GCC unroll 5
+        for (int x = 0; x < 5; ++x) {
+            const lanes r = c[(x + 1) % 5];
+            const lanes d = c[(x + 4) % 5] ^ ((r << 1) | (r >> 63));
+#pragma GCC unroll 5
+            for (int y = 0; y < 25; y += 5) {
+                a[y + x] ^= d;
+            }
+        }
+        // Rho and pi
+        lanes t = a[1];
+#pragma GCC unroll 24
+        for (int i = 0; i < 24; ++i) {
+            const int j = keccak_pi_lanes[i];
+            const lanes next = a[j];
+            const int n = keccak_rho_offsets[i];
+            a[j] = (t << n) | (t >> (64 - n));
+            t = next;
+        }
+        // Chi
+#pragma GCC unroll 5
+        for (int y = 0; y < 25; y += 5) {
+#pragma GCC unroll 5
+            for (int x = 0; x < 5; ++x) {
+                c[x] = a[y + x];
+            }
+#pragma GCC unroll 5
+            for (int x = 0; x < 5; ++x) {
+                a[y + x] = c[x] ^ (~c[(x + 1) % 5] & c[(x + 2) % 5]);
+            }
+        }
+        // Iota
+        a[0] ^= round_constant;
+    }
+}
+
+/// \brief Hashes a batch of messages, LANES messages per permutation.
+template <size_t LANES>
+static inline __attribute__((always_inline)) void keccak_256_hash_lanes(const unsigned char *data, size_t length,
+    size_t count, unsigned char *hashes) {
+    for (size_t first = 0; first < count; first += LANES) {
+        const size_t lanes = count - first < LANES ? count - first : LANES;
+        // Pad each message into its own block, leaving unused lanes zeroed
+        std::array<std::array<uint64_t, keccak_256_rate / sizeof(uint64_t)>, LANES> blocks{};
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            auto *block = reinterpret_cast<unsigned char *>(blocks[lane].data());
+            memcpy(block, data + (first + lane) * length, length);
+            block[length] ^= 0x01;
+            block[keccak_256_rate - 1] ^= 0x80;
+        }
+        // Interleave blocks into the states, which start zeroed, so absorbing is just a copy
+        keccak_state<LANES> a{};
+        for (size_t i = 0; i < blocks[0].size(); ++i) {
+            for (size_t lane = 0; lane < LANES; ++lane) {
+                a[i][lane] = blocks[lane][i];
+            }
+        }
+        keccak_f1600<LANES>(a);
+        // Squeeze the hash of each message from the first lanes of its state
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            std::array<uint64_t, keccak_256_hash_size / sizeof(uint64_t)> hash{};
+            for (size_t i = 0; i < hash.size(); ++i) {
+                hash[i] = a[i][lane];
+            }
+            memcpy(hashes + (first + lane) * keccak_256_hash_size, hash.data(), keccak_256_hash_size);
+        }
+    }
+}
+
+static void keccak_256_hash_batch_generic(const unsigned char *data, size_t length, size_t count,
+    unsigned char *hashes) {
+    keccak_256_hash_lanes<1>(data, length, count, hashes);
+}
+
+static void keccak_256_hash_batch_simd(const unsigned char *data, size_t length, size_t count,
+    unsigned char *hashes) {
+    keccak_256_hash_lanes<KECCAK_256_BATCH_LANES>(data, length, count, hashes);
+}
+
+#ifdef __x86_64__
+__attribute__((target("avx2"))) static void keccak_256_hash_batch_avx2(const unsigned char *data, size_t length,
+    size_t count, unsigned char *hashes) {
+    keccak_256_hash_lanes<KECCAK_256_BATCH_LANES>(data, length, count, hashes);
+}
+#endif
+
+using keccak_256_hash_batch_function = void (*)(const unsigned char *data, size_t length, size_t count,
+    unsigned char *hashes);
+
+/// \brief Returns the implementation of a backend, or nullptr if the host does not support it.
+static keccak_256_hash_batch_function get_backend_function(keccak_256_batch_backend backend) {
+    switch (backend) {
+        case keccak_256_batch_backend::automatic:
+            for (auto preferred : {keccak_256_batch_backend::avx2, keccak_256_batch_backend::simd}) {
+                if (auto *f = get_backend_function(preferred)) {
+                    return f;
+                }
+            }
+            return keccak_256_hash_batch_generic;
+        case keccak_256_batch_backend::generic:
+            return keccak_256_hash_batch_generic;
+        case keccak_256_batch_backend::simd:
+            return keccak_256_hash_batch_simd;
+        case keccak_256_batch_backend::avx2:
+#ifdef __x86_64__
+            if (host_supports_avx2()) {
+                return keccak_256_hash_batch_avx2;
+            }
+#endif
+            return nullptr;
+        default:
+            return nullptr;
+    }
+}
+
+/// \brief Implementation currently used by keccak_256_hash_batch(), selected when the program starts
+static std::atomic<keccak_256_hash_batch_function> g_hash_batch{
+    get_backend_function(keccak_256_batch_backend::automatic)};
+
+bool keccak_256_batch_backend_is_supported(keccak_256_batch_backend backend) {
+    return get_backend_function(backend) != nullptr;
+}
+
+void keccak_256_set_batch_backend(keccak_256_batch_backend backend) {
+    if (backend > keccak_256_batch_backend::avx2) {
+        throw std::invalid_argument{"invalid hasher backend"};
+    }
+    auto *f = get_backend_function(backend);
+    if (f == nullptr) {
+        throw std::invalid_argument{"hasher backend is not supported by host"};
+    }
+    g_hash_batch.store(f, std::memory_order_relaxed);
+}
+
+void keccak_256_hash_batch(const unsigned char *data, size_t length, size_t count, unsigned char *hashes) {
+    g_hash_batch.load(std::memory_order_relaxed)(data, length, count, hashes);
+}
+
+} // namespace cartesi
@@ -0,0 +1,67 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef KECCAK_256_BATCH_H
+#define KECCAK_256_BATCH_H
+
+/// \file
+/// \brief Multi-buffer Keccak-256.
+/// \details Hashes several short messages at once, running one Keccak-f[1600] permutation over the states of
+/// all messages interleaved in SIMD registers. Merkle trees hash mostly 8-byte words and 64-byte concatenations
+/// of hashes, all of which fit in a single block, so each message costs a fraction of a permutation.
+
+#include <cstddef>
+#include <cstdint>
+
+namespace cartesi {
+
+/// \brief Multi-buffer Keccak-256 constants.
+enum KECCAK_256_BATCH_constants : size_t {
+    KECCAK_256_BATCH_LANES = 4,        ///< Number of messages processed by each permutation
+    KECCAK_256_BATCH_MAX_LENGTH = 135, ///< Maximum length of messages, so they fit in a single block
+};
+
+/// \brief Implementations of multi-buffer Keccak-256.
+/// \details All implementations produce the same hashes. They differ only in speed and in host requirements.
+enum class keccak_256_batch_backend : uint64_t {
+    automatic, ///< Fastest implementation supported by the host
+    generic,   ///< One message at a time, using only 64-bit integer instructions
+    simd,      ///< KECCAK_256_BATCH_LANES messages at a time, using the vector instructions the binary targets
+    avx2,      ///< KECCAK_256_BATCH_LANES messages at a time, using AVX2 instructions (x86-64 only)
+};
+
+/// \brief Checks if the host supports a multi-buffer Keccak-256 implementation.
+/// \param backend Implementation to check.
+/// \returns True if the implementation can be selected.
+bool keccak_256_batch_backend_is_supported(keccak_256_batch_backend backend);
+
+/// \brief Selects the multi-buffer Keccak-256 implementation used by the whole process.
+/// \param backend Implementation to select.
+/// \details When the program starts, the automatic implementation is selected.
+/// Throws std::invalid_argument if the implementation is unknown or the host does not support it.
+void keccak_256_set_batch_backend(keccak_256_batch_backend backend);
+
+/// \brief Computes the Keccak-256 hashes of a batch of messages with the same length.
+/// \param data Pointer to first message. Messages are laid out one after the other.
+/// \param length Length of each message. Must not exceed KECCAK_256_BATCH_MAX_LENGTH.
+/// \param count Number of messages.
+/// \param hashes Receives the 32-byte hash of each message, one after the other.
+/// \details Results are identical to hashing each message separately with Keccak-256.
+void keccak_256_hash_batch(const unsigned char *data, size_t length, size_t count, unsigned char *hashes);
+
+} // namespace cartesi
+
+#endif
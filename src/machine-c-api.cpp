@@ -27,6 +27,7 @@
 #include <string>
 
 #include "i-virtual-machine.h"
+#include "keccak-256-batch.h"
 #include "machine-c-api-internal.h"
 #include "machine-c-api.h"
 #include "machine-config.h"
@@ -368,6 +369,13 @@ cartesi::machine_runtime_config convert_from_c(const cm_machine_runtime_config *
     new_cpp_machine_runtime_config.concurrency =
         cartesi::concurrency_runtime_config{c_config->concurrency.update_merkle_tree};
     new_cpp_machine_runtime_config.htif = cartesi::htif_runtime_config{c_config->htif.no_console_putchar};
+    new_cpp_machine_runtime_config.tlb = cartesi::tlb_runtime_config{c_config->tlb.sets, c_config->tlb.ways};
+    new_cpp_machine_runtime_config.hasher = cartesi::hasher_runtime_config{c_config->hasher.page_cache_entries};
+    new_cpp_machine_runtime_config.merkle_cache = c_config->merkle_cache;
+    new_cpp_machine_runtime_config.store_direct_io = c_config->store_direct_io;
+    new_cpp_machine_runtime_config.store_compressed = c_config->store_compressed;
+    new_cpp_machine_runtime_config.image_prefault =
+        static_cast<cartesi::image_prefault_policy>(c_config->image_prefault);
     new_cpp_machine_runtime_config.skip_root_hash_check = c_config->skip_root_hash_check;
     new_cpp_machine_runtime_config.skip_version_check = c_config->skip_version_check;
     return new_cpp_machine_runtime_config;
@@ -509,6 +517,26 @@ static cartesi::machine_merkle_tree::proof_type convert_from_c(const cm_merkle_t
     return cpp_proof;
 }
 
+static void convert_to_c(const cartesi::machine_merkle_tree::multiproof_type::nodes_type &nodes,
+    cm_merkle_tree_node_array *c_nodes) {
+    c_nodes->count = nodes.size();
+    c_nodes->entry = new cm_merkle_tree_node[nodes.size()]{};
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        c_nodes->entry[i].address = nodes[i].address;
+        c_nodes->entry[i].log2_size = nodes[i].log2_size;
+        memcpy(&c_nodes->entry[i].hash, nodes[i].hash.data(), sizeof(cm_hash));
+    }
+}
+
+static cm_merkle_tree_multiproof *convert_to_c(const cartesi::machine_merkle_tree::multiproof_type &multiproof) {
+    auto *new_multiproof = new cm_merkle_tree_multiproof{};
+    new_multiproof->log2_root_size = multiproof.get_log2_root_size();
+    memcpy(&new_multiproof->root_hash, multiproof.get_root_hash().data(), sizeof(cm_hash));
+    convert_to_c(multiproof.get_targets(), &new_multiproof->targets);
+    convert_to_c(multiproof.get_siblings(), &new_multiproof->siblings);
+    return new_multiproof;
+}
+
 // ----------------------------------------------
 // Access log conversion functions
 // ----------------------------------------------
@@ -716,6 +744,13 @@ void cm_delete_machine_config(const cm_machine_config *config) {
     delete config;
 }
 
+int cm_set_hasher_backend(CM_HASHER_BACKEND backend, char **err_msg) try {
+    cartesi::keccak_256_set_batch_backend(static_cast<cartesi::keccak_256_batch_backend>(backend));
+    return cm_result_success(err_msg);
+} catch (...) {
+    return cm_result_failure(err_msg);
+}
+
 static inline cartesi::i_virtual_machine *create_virtual_machine(const cartesi::machine_config &c,
     const cartesi::machine_runtime_config &r) {
     return new cartesi::virtual_machine(c, r);
@@ -769,6 +804,14 @@ int cm_store(cm_machine *m, const char *dir, char **err_msg) try {
     return cm_result_failure(err_msg);
 }
 
+int cm_store_delta(cm_machine *m, const char *dir, const char *base_dir, char **err_msg) try {
+    auto *cpp_machine = convert_from_c(m);
+    cpp_machine->store_delta(null_to_empty(dir), null_to_empty(base_dir));
+    return cm_result_success(err_msg);
+} catch (...) {
+    return cm_result_failure(err_msg);
+}
+
 int cm_machine_run(cm_machine *m, uint64_t mcycle_end, CM_BREAK_REASON *break_reason_result, char **err_msg) try {
     auto *cpp_machine = convert_from_c(m);
     cartesi::interpreter_break_reason break_reason = cpp_machine->run(mcycle_end);
@@ -917,6 +960,35 @@ void cm_delete_merkle_tree_proof(cm_merkle_tree_proof *proof) {
     delete proof;
 }
 
+int cm_get_proofs(const cm_machine *m, const cm_merkle_tree_target *targets, size_t count,
+    cm_merkle_tree_multiproof **multiproof, char **err_msg) try {
+    if (targets == nullptr && count > 0) {
+        throw std::invalid_argument("invalid targets");
+    }
+    if (multiproof == nullptr) {
+        throw std::invalid_argument("invalid multiproof output");
+    }
+    const auto *cpp_machine = convert_from_c(m);
+    std::vector<cartesi::machine_merkle_tree::multiproof_type::target_type> cpp_targets;
+    cpp_targets.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        cpp_targets.push_back({targets[i].address, targets[i].log2_size});
+    }
+    *multiproof = convert_to_c(cpp_machine->get_proofs(cpp_targets));
+    return cm_result_success(err_msg);
+} catch (...) {
+    return cm_result_failure(err_msg);
+}
+
+void cm_delete_merkle_tree_multiproof(cm_merkle_tree_multiproof *multiproof) {
+    if (multiproof == nullptr) {
+        return;
+    }
+    delete[] multiproof->targets.entry;
+    delete[] multiproof->siblings.entry;
+    delete multiproof;
+}
+
 void cm_delete_semantic_version(const cm_semantic_version *version) {
     if (version == nullptr) {
         return;
@@ -1257,6 +1329,17 @@ int cm_verify_dirty_page_maps(const cm_machine *m, bool *result, char **err_msg)
     return cm_result_failure(err_msg);
 }
 
+int cm_get_page_hash_cache_stats(const cm_machine *m, uint64_t *hits, uint64_t *misses, char **err_msg) try {
+    if (hits == nullptr || misses == nullptr) {
+        throw std::invalid_argument("invalid stats output");
+    }
+    const auto *cpp_machine = convert_from_c(m);
+    cpp_machine->get_page_hash_cache_stats(*hits, *misses);
+    return cm_result_success(err_msg);
+} catch (...) {
+    return cm_result_failure(err_msg);
+}
+
 int cm_get_initial_config(const cm_machine *m, const cm_machine_config **config, char **err_msg) try {
     if (config == nullptr) {
         throw std::invalid_argument("invalid config output");
@@ -286,6 +286,37 @@ typedef struct { // NOLINT(modernize-use-using)
     cm_hash_array sibling_hashes;
 } cm_merkle_tree_proof;
 
+/// \brief Location of a node in the Merkle tree
+typedef struct { // NOLINT(modernize-use-using)
+    uint64_t address;
+    int log2_size;
+} cm_merkle_tree_target;
+
+/// \brief Location and hash of a node in the Merkle tree
+typedef struct { // NOLINT(modernize-use-using)
+    uint64_t address;
+    int log2_size;
+    cm_hash hash;
+} cm_merkle_tree_node;
+
+/// \brief Array of Merkle tree nodes
+typedef struct { // NOLINT(modernize-use-using)
+    cm_merkle_tree_node *entry;
+    size_t count;
+} cm_merkle_tree_node_array;
+
+/// \brief Merkle tree multiproof structure
+/// \details
+/// This structure holds a proof that several target nodes in the tree have certain hashes.
+/// Each sibling hash needed to verify the targets is listed once, and siblings that can be
+/// computed from the targets themselves are omitted.
+typedef struct { // NOLINT(modernize-use-using)
+    size_t log2_root_size;
+    cm_hash root_hash;
+    cm_merkle_tree_node_array targets;
+    cm_merkle_tree_node_array siblings;
+} cm_merkle_tree_multiproof;
+
 /// \brief Type of state access
 typedef enum {       // NOLINT(modernize-use-using)
     CM_ACCESS_READ,  ///< Read operation
@@ -359,10 +390,42 @@ typedef struct { // NOLINT(modernize-use-using)
     bool no_console_putchar;
 } cm_htif_runtime_config;
 
+/// \brief TLB runtime configuration
+typedef struct { // NOLINT(modernize-use-using)
+    uint64_t sets; ///< Number of sets in host TLB (power of 2, or 0 for default)
+    uint64_t ways; ///< Number of entries in each set of host TLB (power of 2, or 0 for default)
+} cm_tlb_runtime_config;
+
+/// \brief Implementations of multi-buffer Keccak-256
+typedef enum {                 // NOLINT(modernize-use-using)
+    CM_HASHER_BACKEND_AUTO,    ///< Fastest implementation supported by the host
+    CM_HASHER_BACKEND_GENERIC, ///< One message at a time, using only 64-bit integer instructions
+    CM_HASHER_BACKEND_SIMD,    ///< Several messages at a time, using the vector instructions the library targets
+    CM_HASHER_BACKEND_AVX2,    ///< Several messages at a time, using AVX2 instructions (x86-64 only)
+} CM_HASHER_BACKEND;
+
+/// \brief Hasher runtime configuration
+typedef struct {                 // NOLINT(modernize-use-using)
+    uint64_t page_cache_entries; ///< Number of page hashes cached by content (power of 2, or 0 to disable)
+} cm_hasher_runtime_config;
+
+/// \brief How the pages of memory range images are brought into host memory
+typedef enum {                  // NOLINT(modernize-use-using)
+    CM_IMAGE_PREFAULT_NONE,     ///< Pages are read when first accessed
+    CM_IMAGE_PREFAULT_WILLNEED, ///< Pages are read ahead in the background, while the machine starts
+    CM_IMAGE_PREFAULT_POPULATE, ///< All pages are read before the machine is created
+} CM_IMAGE_PREFAULT;
+
 /// \brief Machine runtime configuration
 typedef struct { // NOLINT(modernize-use-using)
     cm_concurrency_runtime_config concurrency;
     cm_htif_runtime_config htif;
+    cm_tlb_runtime_config tlb;
+    cm_hasher_runtime_config hasher;
+    bool merkle_cache;
+    bool store_direct_io;
+    bool store_compressed;
+    CM_IMAGE_PREFAULT image_prefault;
     bool skip_root_hash_check;
     bool skip_version_check;
 } cm_machine_runtime_config;
@@ -400,6 +463,18 @@ CM_API const cm_machine_config *cm_new_default_machine_config(void);
 /// \returns void
 CM_API void cm_delete_machine_config(const cm_machine_config *config);
 
+/// \brief Selects the multi-buffer Keccak-256 implementation used by the whole process
+/// \param backend Implementation to select
+/// \param err_msg Receives the error message if function execution fails
+/// or NULL in case of successful function execution. In case of failure error_msg
+/// must be deleted by the function caller using cm_delete_cstring.
+/// err_msg can be NULL, meaning the error message won't be received.
+/// \returns 0 for success, non zero code for error
+/// \details All implementations produce the same hashes. When the library is loaded, CM_HASHER_BACKEND_AUTO is
+/// selected. The implementation is shared by all local machines in the process, so it should be selected before
+/// any of them is created. Remote machines are not affected.
+CM_API int cm_set_hasher_backend(CM_HASHER_BACKEND backend, char **err_msg);
+
 /// \brief Create new machine instance from configuration
 /// \param config Machine configuration. Must be pointer to valid object
 /// \param runtime_config Machine runtime configuration. Must be pointer to valid object
@@ -435,6 +510,19 @@ CM_API int cm_load_machine(const char *dir, const cm_machine_runtime_config *run
 /// \returns 0 for success, non zero code for error
 CM_API int cm_store(cm_machine *m, const char *dir, char **err_msg);
 
+/// \brief Serialize state to directory, as a delta relative to a previously stored directory
+/// \param m Pointer to valid machine instance
+/// \param dir Directory where the machine will be serialized
+/// \param base_dir Directory the machine was last stored to or loaded from
+/// \param err_msg Receives the error message if function execution fails
+/// or NULL in case of successful function execution. In case of failure error_msg
+/// must be deleted by the function caller using cm_delete_cstring.
+/// err_msg can be NULL, meaning the error message won't be received.
+/// \details Only memory pages changed since the machine was last stored or loaded are written.
+/// Loading dir with cm_load_machine also reads base_dir, so base_dir must be kept.
+/// \returns 0 for success, non zero code for error
+CM_API int cm_store_delta(cm_machine *m, const char *dir, const char *base_dir, char **err_msg);
+
 /// \brief Deletes machine instance
 /// \param m Valid pointer to the existing machine instance
 CM_API void cm_delete_machine(cm_machine *m);
@@ -513,6 +601,25 @@ CM_API int cm_get_proof(const cm_machine *m, uint64_t address, int log2_size, cm
 /// \param proof Valid pointer to cm_merkle_tree_proof object
 CM_API void cm_delete_merkle_tree_proof(cm_merkle_tree_proof *proof);
 
+/// \brief Obtains a single proof for several nodes in the Merkle tree
+/// \param m Pointer to valid machine instance
+/// \param targets Address and log<sub>2</sub> of size of each target node, as in cm_get_proof
+/// \param count Number of target nodes
+/// \param multiproof Receives the multiproof
+/// multiproof must be deleted with the function cm_delete_merkle_tree_multiproof
+/// \param err_msg Receives the error message if function execution fails
+/// or NULL in case of successful function execution. In case of failure error_msg
+/// must be deleted by the function caller using cm_delete_cstring.
+/// err_msg can be NULL, meaning the error message won't be received.
+/// \returns 0 for success, non zero code for error
+/// \details The Merkle tree is updated only once for all targets.
+CM_API int cm_get_proofs(const cm_machine *m, const cm_merkle_tree_target *targets, size_t count,
+    cm_merkle_tree_multiproof **multiproof, char **err_msg);
+
+/// \brief  Deletes the instance of cm_merkle_tree_multiproof acquired from cm_get_proofs
+/// \param multiproof Valid pointer to cm_merkle_tree_multiproof object
+CM_API void cm_delete_merkle_tree_multiproof(cm_merkle_tree_multiproof *multiproof);
+
 /// \brief Obtains the root hash of the Merkle tree
 /// \param m Pointer to valid machine instance
 /// \param hash Valid pointer to cm_hash structure that  receives the hash.
@@ -1513,6 +1620,18 @@ CM_API int cm_dump_pmas(const cm_machine *m, char **err_msg);
 /// \returns 0 for success, non zero code for error
 CM_API int cm_verify_dirty_page_maps(const cm_machine *m, bool *result, char **err_msg);
 
+/// \brief Obtains the number of page hash cache lookups that hit and missed.
+/// \param m Pointer to valid machine instance
+/// \param hits Receives the number of pages whose hash was found in the cache.
+/// \param misses Receives the number of pages that had to be hashed and inserted in the cache.
+/// \param err_msg Receives the error message if function execution fails
+/// or NULL in case of successful function execution. In case of failure error_msg
+/// must be deleted by the function caller using cm_delete_cstring.
+/// err_msg can be NULL, meaning the error message won't be received.
+/// \returns 0 for success, non zero code for error
+/// \details Counters are kept only by local machines, and only while the cache is enabled.
+CM_API int cm_get_page_hash_cache_stats(const cm_machine *m, uint64_t *hits, uint64_t *misses, char **err_msg);
+
 /// \brief Returns copy of initialization config.
 /// \param m Pointer to valid machine instance
 /// \param config Receives the initial configuration.
@@ -1585,6 +1704,8 @@ CM_API void cm_delete_semantic_version(const cm_semantic_version *version);
 CM_API int cm_destroy(cm_machine *m, char **err_msg);
 
 /// \brief Do a snapshot of the machine
+/// \details The snapshot replaces the previous one, if any. Local machines copy each memory page right before it is
+/// first modified after the snapshot, so the snapshot and its rollback take time proportional to the pages modified.
 /// \param err_msg Receives the error message if function execution fails
 /// or NULL in case of successful function execution. In case of failure error_msg
 /// must be deleted by the function caller using cm_delete_cstring.
@@ -1593,6 +1714,7 @@ CM_API int cm_destroy(cm_machine *m, char **err_msg);
 CM_API int cm_snapshot(cm_machine *m, char **err_msg);
 
 /// \brief Performs rollback
+/// \details Restores the state of the machine when the last snapshot was taken, and discards the snapshot.
 /// \param err_msg Receives the error message if function execution fails
 /// or NULL in case of successful function execution. In case of failure error_msg
 /// must be deleted by the function caller using cm_delete_cstring.
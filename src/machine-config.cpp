@@ -42,24 +42,24 @@ std::string machine_config::get_config_filename(const std::string &dir) {
     return dir + "/config.json";
 }
 
-static void adjust_image_filenames(machine_config &c, const std::string &dir) {
-    c.rom.image_filename = c.get_image_filename(dir, PMA_ROM_START, PMA_ROM_LENGTH);
-    c.ram.image_filename = c.get_image_filename(dir, PMA_RAM_START, c.ram.length);
-    c.tlb.image_filename = c.get_image_filename(dir, PMA_SHADOW_TLB_START, PMA_SHADOW_TLB_LENGTH);
-    for (auto &f : c.flash_drive) {
-        f.image_filename = c.get_image_filename(dir, f);
+void machine_config::adjust_image_filenames(const std::string &dir) {
+    rom.image_filename = get_image_filename(dir, PMA_ROM_START, PMA_ROM_LENGTH);
+    ram.image_filename = get_image_filename(dir, PMA_RAM_START, ram.length);
+    tlb.image_filename = get_image_filename(dir, PMA_SHADOW_TLB_START, PMA_SHADOW_TLB_LENGTH);
+    for (auto &f : flash_drive) {
+        f.image_filename = get_image_filename(dir, f);
     }
-    if (c.rollup.has_value()) {
-        auto &r = c.rollup.value();
-        r.rx_buffer.image_filename = c.get_image_filename(dir, r.rx_buffer);
-        r.tx_buffer.image_filename = c.get_image_filename(dir, r.tx_buffer);
-        r.input_metadata.image_filename = c.get_image_filename(dir, r.input_metadata);
-        r.voucher_hashes.image_filename = c.get_image_filename(dir, r.voucher_hashes);
-        r.notice_hashes.image_filename = c.get_image_filename(dir, r.notice_hashes);
+    if (rollup.has_value()) {
+        auto &r = rollup.value();
+        r.rx_buffer.image_filename = get_image_filename(dir, r.rx_buffer);
+        r.tx_buffer.image_filename = get_image_filename(dir, r.tx_buffer);
+        r.input_metadata.image_filename = get_image_filename(dir, r.input_metadata);
+        r.voucher_hashes.image_filename = get_image_filename(dir, r.voucher_hashes);
+        r.notice_hashes.image_filename = get_image_filename(dir, r.notice_hashes);
     }
 
-    if (c.uarch.ram.length > 0) {
-        c.uarch.ram.image_filename = c.get_image_filename(dir, PMA_UARCH_RAM_START, c.uarch.ram.length);
+    if (uarch.ram.length > 0) {
+        uarch.ram.image_filename = get_image_filename(dir, PMA_UARCH_RAM_START, uarch.ram.length);
     }
 }
 
@@ -84,7 +84,7 @@ machine_config machine_config::load(const std::string &dir) {
                 std::to_string(jv.get<int>()) + ")");
         }
         ju_get_field(j, std::string("config"), c, "");
-        adjust_image_filenames(c, dir);
+        c.adjust_image_filenames(dir);
     } catch (std::exception &e) {
         throw std::runtime_error{e.what()};
     }
@@ -141,6 +141,10 @@ struct machine_config final {
     static std::string get_image_filename(const std::string &dir, uint64_t start, uint64_t length);
     static std::string get_image_filename(const std::string &dir, const memory_range_config &c);
 
+    /// \brief Points the image filenames of all memory ranges to where they are stored in a directory
+    /// \param dir Directory where memory ranges are stored
+    void adjust_image_filenames(const std::string &dir);
+
     /// \brief Loads a machine config from a directory
     /// \param dir Directory from whence "config" will be loaded
     /// \returns The config loaded
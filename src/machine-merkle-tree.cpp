@@ -16,6 +16,8 @@
 
 #include "machine-merkle-tree.h"
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <cinttypes>
 #include <cstdlib>
@@ -23,6 +25,8 @@
 #include <functional>
 #include <iomanip>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 /// \file
 /// \brief Merkle tree implementation.
@@ -42,12 +46,8 @@ constexpr machine_merkle_tree::address_type machine_merkle_tree::get_page_index(
 
 machine_merkle_tree::tree_node *machine_merkle_tree::get_page_node(address_type page_index) const {
     // Look for entry in page map hash table
-    auto it = m_page_node_map.find(page_index);
-    if (it != m_page_node_map.end()) {
-        return it->second;
-    } else {
-        return nullptr;
-    }
+    tree_node *const *node = m_page_node_map.find(page_index);
+    return node ? *node : nullptr;
 }
 
 constexpr machine_merkle_tree::address_type machine_merkle_tree::get_offset_in_page(address_type address) {
@@ -55,24 +55,15 @@ constexpr machine_merkle_tree::address_type machine_merkle_tree::get_offset_in_p
 }
 
 int machine_merkle_tree::set_page_node_map(address_type page_index, tree_node *node) {
-    m_page_node_map[page_index] = node;
+    m_page_node_map.insert_or_assign(page_index, node);
     return 1;
 }
 
-// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
-machine_merkle_tree::tree_node *machine_merkle_tree::create_node(void) const {
+machine_merkle_tree::tree_node *machine_merkle_tree::create_node(void) {
 #ifdef MERKLE_DUMP_STATS
     m_num_nodes++;
 #endif
-    return new tree_node{};
-}
-
-// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
-void machine_merkle_tree::destroy_node(tree_node *node) const {
-#ifdef MERKLE_DUMP_STATS
-    --m_num_nodes;
-#endif
-    delete node;
+    return m_node_allocator.allocate();
 }
 
 machine_merkle_tree::tree_node *machine_merkle_tree::new_page_node(address_type page_index) {
@@ -107,26 +98,85 @@ machine_merkle_tree::tree_node *machine_merkle_tree::new_page_node(address_type
     return node;
 }
 
-void machine_merkle_tree::get_page_node_hash(hasher_type &h, const unsigned char *start, int log2_size,
-    hash_type &hash) const {
-    if (log2_size > get_log2_word_size()) {
-        hash_type child0;
-        hash_type child1;
-        --log2_size;
-        const address_type size = UINT64_C(1) << log2_size;
-        get_page_node_hash(h, start, log2_size, child0);
-        get_page_node_hash(h, start + size, log2_size, child1);
-        get_concat_hash(h, child0, child1, hash);
+void machine_merkle_tree::get_page_node_hash(hasher_type &h, page_hash_scratch &scratch, const unsigned char *start,
+    int log2_size, hash_type &hash) const {
+    assert(log2_size >= get_log2_word_size() && log2_size <= get_log2_page_size());
+    // Hash the tree one level at a time, bottom up, so the hasher gets all nodes in a level as a single batch.
+    // Each level is read from one buffer and written to the other.
+    // Nodes that cover only zero words are pristine, so they take their hashes from the pristine tree and are
+    // left out of the batch. Sparse pages therefore cost little more than the non-zero words they hold.
+    // Non-pristine nodes are packed into the scratch space when some nodes in the level are pristine
+    auto &level = scratch.level;
+    auto &pristine = scratch.pristine;
+    auto &packed_index = scratch.packed_index;
+    auto &packed_words = scratch.packed_words;
+    auto &packed_children = scratch.packed_children;
+    auto &packed_hashes = scratch.packed_hashes;
+    size_t count = UINT64_C(1) << (log2_size - get_log2_word_size());
+    size_t packed = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t word = 0;
+        memcpy(&word, start + i * get_word_size(), sizeof(word));
+        pristine[i] = (word == 0);
+        if (!pristine[i]) {
+            packed_index[packed] = static_cast<uint16_t>(i);
+            packed_words[packed] = word;
+            ++packed;
+        }
+    }
+    if (packed == count) {
+        h.hash_batch(start, get_word_size(), count, level.data());
     } else {
-        h.begin();
-        h.add_data(start, get_word_size());
-        h.end(hash);
+        h.hash_batch(reinterpret_cast<const unsigned char *>(packed_words.data()), get_word_size(), packed,
+            packed_hashes.data());
+        const hash_type &pristine_word = get_pristine_hash(get_log2_word_size());
+        for (size_t i = 0; i < count; ++i) {
+            level[i] = pristine_word;
+        }
+        for (size_t i = 0; i < packed; ++i) {
+            level[packed_index[i]] = packed_hashes[i];
+        }
     }
+    hash_type *children = level.data();
+    hash_type *nodes = scratch.parents.data();
+    int log2_node_size = get_log2_word_size();
+    while (count > 1) {
+        count /= 2;
+        ++log2_node_size;
+        packed = 0;
+        for (size_t i = 0; i < count; ++i) {
+            pristine[i] = pristine[2 * i] && pristine[2 * i + 1];
+            if (!pristine[i]) {
+                packed_index[packed] = static_cast<uint16_t>(i);
+                ++packed;
+            }
+        }
+        if (packed == count) {
+            // The concatenation of each pair of sibling hashes is contiguous in memory
+            h.hash_batch(children->data(), 2 * sizeof(hash_type), count, nodes);
+        } else {
+            for (size_t i = 0; i < packed; ++i) {
+                packed_children[i][0] = children[2 * packed_index[i]];
+                packed_children[i][1] = children[2 * packed_index[i] + 1];
+            }
+            h.hash_batch(packed_children[0][0].data(), sizeof(packed_children[0]), packed, packed_hashes.data());
+            const hash_type &pristine_node = get_pristine_hash(log2_node_size);
+            for (size_t i = 0; i < count; ++i) {
+                nodes[i] = pristine_node;
+            }
+            for (size_t i = 0; i < packed; ++i) {
+                nodes[packed_index[i]] = packed_hashes[i];
+            }
+        }
+        std::swap(children, nodes);
+    }
+    hash = children[0];
 }
 
-void machine_merkle_tree::get_page_node_hash(hasher_type &h, const unsigned char *page_data, hash_type &hash) const {
+void machine_merkle_tree::get_page_node_hash(hasher_type &h, page_hash_scratch &scratch, const unsigned char *page_data,
+    hash_type &hash) const {
     if (page_data) {
-        get_page_node_hash(h, page_data, get_log2_page_size(), hash);
+        get_page_node_hash(h, scratch, page_data, get_log2_page_size(), hash);
     } else {
         hash = get_pristine_hash(get_log2_page_size());
     }
@@ -148,8 +198,23 @@ const machine_merkle_tree::hash_type &machine_merkle_tree::get_child_hash(int ch
     return child ? child->hash : get_pristine_hash(child_log2_size);
 }
 
-void machine_merkle_tree::update_inner_node_hash(hasher_type &h, int log2_size, tree_node *node) {
-    get_concat_hash(h, get_child_hash(log2_size - 1, node, 0), get_child_hash(log2_size - 1, node, 1), node->hash);
+void machine_merkle_tree::update_inner_node_hashes(hasher_type &h, int log2_size, tree_node *const *nodes,
+    uint64_t count) {
+    // Lay out the concatenated child hashes of each node one after the other, so they can be hashed as a batch
+    constexpr uint64_t batch = 64;
+    std::array<std::array<hash_type, 2>, batch> children;
+    std::array<hash_type, batch> hashes;
+    for (uint64_t first = 0; first < count; first += batch) {
+        const uint64_t n = std::min(count - first, batch);
+        for (uint64_t i = 0; i < n; ++i) {
+            children[i][0] = get_child_hash(log2_size - 1, nodes[first + i], 0);
+            children[i][1] = get_child_hash(log2_size - 1, nodes[first + i], 1);
+        }
+        h.hash_batch(children[0][0].data(), sizeof(children[0]), n, hashes.data());
+        for (uint64_t i = 0; i < n; ++i) {
+            nodes[first + i]->hash = hashes[i];
+        }
+    }
 }
 
 void machine_merkle_tree::dump_hash(const hash_type &hash) {
@@ -182,20 +247,13 @@ void machine_merkle_tree::dump_merkle_tree(tree_node *node, uint64_t address, in
     }
 }
 
-void machine_merkle_tree::destroy_merkle_tree(tree_node *node, int log2_size) {
-    if (node) {
-        // If this is an inner node, invoke recursively
-        if (log2_size > get_log2_page_size()) {
-            destroy_merkle_tree(node->child[0], log2_size - 1);
-            destroy_merkle_tree(node->child[1], log2_size - 1);
-        }
-        destroy_node(node);
-    }
-}
-
 void machine_merkle_tree::destroy_merkle_tree(void) {
-    destroy_merkle_tree(m_root_storage.child[0], get_log2_root_size() - 1);
-    destroy_merkle_tree(m_root_storage.child[1], get_log2_root_size() - 1);
+    // All nodes but the root live in the allocator, so they are freed in bulk
+    m_page_node_map.clear();
+    m_node_allocator.clear();
+#ifdef MERKLE_DUMP_STATS
+    m_num_nodes = 0;
+#endif
     memset(&m_root_storage, 0, sizeof(m_root_storage));
 }
 
@@ -273,21 +331,47 @@ bool machine_merkle_tree::update_page_node_hash(address_type page_index, const h
     return true;
 }
 
-bool machine_merkle_tree::end_update(hasher_type &h) {
-    // Now go over the queue of inner nodes updating their hashes and
-    // enqueueing their parents until the queue is empty
-    while (!m_merkle_update_fifo.empty()) {
-        int log2_size{};
-        tree_node *node{};
-        std::tie(log2_size, node) = m_merkle_update_fifo.front();
-        update_inner_node_hash(h, log2_size, node);
-        m_merkle_update_fifo.pop_front();
-        if (node->parent && node->parent->mark != m_merkle_update_nonce) {
-            m_merkle_update_fifo.emplace_back(log2_size + 1, node->parent);
-            node->parent->mark = m_merkle_update_nonce;
+void machine_merkle_tree::update_inner_levels(
+    const std::function<void(int, std::vector<tree_node *> &)> &update_level) {
+    // All nodes in the queue are parents of page nodes, so they form the first level
+    std::vector<tree_node *> level;
+    level.reserve(m_merkle_update_fifo.size());
+    for (const auto &entry : m_merkle_update_fifo) {
+        level.push_back(entry.second);
+    }
+    m_merkle_update_fifo.clear();
+    std::vector<tree_node *> next_level;
+    for (int log2_size = get_log2_page_size() + 1; !level.empty(); ++log2_size) {
+        update_level(log2_size, level);
+        // Gather the parents that form the next level, each only once
+        next_level.clear();
+        for (tree_node *node : level) {
+            if (node->parent && node->parent->mark != m_merkle_update_nonce) {
+                next_level.push_back(node->parent);
+                node->parent->mark = m_merkle_update_nonce;
+            }
         }
+        std::swap(level, next_level);
     }
     ++m_merkle_update_nonce;
+}
+
+bool machine_merkle_tree::end_update(hasher_type &h) {
+    update_inner_levels([&h](int log2_size, std::vector<tree_node *> &level) {
+        update_inner_node_hashes(h, log2_size, level.data(), level.size());
+    });
+    return true;
+}
+
+bool machine_merkle_tree::end_update(thread_pool &pool) {
+    // Levels with fewer nodes than this are not worth splitting among threads
+    constexpr uint64_t chunk = 64;
+    std::vector<hasher_type> hashers(pool.get_concurrency());
+    update_inner_levels([&](int log2_size, std::vector<tree_node *> &level) {
+        pool.parallel_for(level.size(), chunk, [&](uint64_t worker, uint64_t begin, uint64_t end) {
+            update_inner_node_hashes(hashers[worker], log2_size, level.data() + begin, end - begin);
+        });
+    });
     return true;
 }
 
@@ -23,13 +23,18 @@
 #include <array>
 #include <cstdint>
 #include <deque>
+#include <functional>
 #include <iosfwd>
 #include <type_traits>
-#include <unordered_map>
+#include <vector>
 
+#include "flat-address-map.h"
 #include "keccak-256-hasher.h"
+#include "merkle-tree-multiproof.h"
 #include "merkle-tree-proof.h"
 #include "pristine-merkle-tree.h"
+#include "slab-allocator.h"
+#include "thread-pool.h"
 
 namespace cartesi {
 
@@ -119,10 +124,27 @@ public:
     /// \brief Storage for the proof of a word value.
     using proof_type = merkle_tree_proof<hash_type, address_type>;
 
+    /// \brief Storage for the proof of several nodes at once.
+    using multiproof_type = merkle_tree_multiproof<hash_type, address_type>;
+
     /// \brief Storage for the hashes of the siblings of all nodes along
     /// the path from the root to target node.
     using siblings_type = proof_type::sibling_hashes_type;
 
+    /// \brief Scratch space for hashing the levels of a page.
+    /// \details It is too large for the stack, so each thread that hashes pages keeps its own.
+    struct page_hash_scratch {
+        /// \brief Number of words in a page.
+        static constexpr size_t max_words = UINT64_C(1) << (LOG2_PAGE_SIZE - LOG2_WORD_SIZE);
+        std::array<hash_type, max_words> level;                              ///< Hashes of nodes in a level.
+        std::array<hash_type, max_words / 2> parents;                        ///< Hashes of their parents.
+        std::array<bool, max_words> pristine;                                ///< Whether each node is pristine.
+        std::array<uint16_t, max_words> packed_index;                        ///< Index of each non-pristine node.
+        std::array<uint64_t, max_words> packed_words;                        ///< Non-pristine words, packed.
+        std::array<std::array<hash_type, 2>, max_words / 2> packed_children; ///< Children of non-pristine nodes.
+        std::array<hash_type, max_words> packed_hashes;                      ///< Hashes of non-pristine nodes.
+    };
+
 private:
     /// \brief Merkle tree node structure.
     /// \details A node is known to be an inner-node or a page-node implicitly
@@ -137,7 +159,11 @@ private:
 
     // Sparse map from virtual page index to the
     // corresponding page node in the Merkle tree.
-    std::unordered_map<address_type, tree_node *> m_page_node_map;
+    flat_address_map<tree_node *, LOG2_PAGE_SIZE> m_page_node_map;
+
+    // Storage for all nodes but the root, so nodes are
+    // allocated in bulk and freed all at once.
+    slab_allocator<tree_node> m_node_allocator;
 
     // Root of the Merkle tree.
     tree_node m_root_storage;
@@ -163,11 +189,7 @@ private:
 
     /// \brief Creates and returns a new tree node.
     /// \return Newly created node or nullptr if out-of-memory.
-    tree_node *create_node(void) const;
-
-    /// \brief Deallocates node.
-    /// \param node Node to be deallocated.
-    void destroy_node(tree_node *node) const;
+    tree_node *create_node(void);
 
     /// \brief Creates a new page node and insert it into the Merkle tree.
     /// \param page_index Page index for node.
@@ -176,11 +198,18 @@ private:
     /// Maps new node to the page index.
     tree_node *new_page_node(address_type page_index);
 
-    /// \brief Updates an inner node hash from its children.
+    /// \brief Updates the hashes of several inner nodes of the same size from their children in a single batch.
     /// \param h Hasher object.
-    /// \param log2_size log<sub>2</sub> of size subintended by node.
-    /// \param node Node to be updated.
-    static void update_inner_node_hash(hasher_type &h, int log2_size, tree_node *node);
+    /// \param log2_size log<sub>2</sub> of size subintended by nodes.
+    /// \param nodes Pointer to first node to be updated.
+    /// \param count Number of nodes to be updated.
+    static void update_inner_node_hashes(hasher_type &h, int log2_size, tree_node *const *nodes, uint64_t count);
+
+    /// \brief Updates the hashes of all inner nodes in the update queue and their ancestors, one level at a time.
+    /// \param update_level Updates the hashes of all nodes in a level, given its log<sub>2</sub> size.
+    /// \details The parents of all nodes in a level are independent from each other, so each level can be hashed
+    /// as a single batch before moving on to the next.
+    void update_inner_levels(const std::function<void(int, std::vector<tree_node *> &)> &update_level);
 
     /// \brief Dumps a hash to std::cerr.
     /// \param hash Hash to be dumped.
@@ -203,11 +232,6 @@ private:
     /// \brief Dumps the entire tree rooted to std::cerr.
     void dump_merkle_tree(void) const;
 
-    /// \brief Destroys tree rooted at node.
-    /// \param node Root of subtree.
-    /// \param  log2_size log<sub>2</sub> of size subintended by \p node.
-    void destroy_merkle_tree(tree_node *node, int log2_size);
-
     /// \brief Destroys entire Merkle tree.
     void destroy_merkle_tree(void);
 
@@ -236,10 +260,12 @@ private:
     /// \brief Recursively builds hash for log2_size node
     /// from contiguous memory.
     /// \param h Hasher object.
+    /// \param scratch Scratch space.
     /// \param start Start of contiguous memory subintended by node.
     /// \param log2_size log<sub>2</sub> of size subintended by node.
     /// \param hash Receives the hash.
-    void get_page_node_hash(hasher_type &h, const unsigned char *start, int log2_size, hash_type &hash) const;
+    void get_page_node_hash(hasher_type &h, page_hash_scratch &scratch, const unsigned char *start, int log2_size,
+        hash_type &hash) const;
 
     /// \brief Gets the sibling hashes along the path from
     /// the node currently being visited and a target node.
@@ -318,13 +344,20 @@ public:
     /// parallelization to compute Merkle trees
     bool update_page_node_hash(address_type page_index, const hash_type &hash);
 
-    /// \brief End tree update.
+    /// \brief End tree update, hashing each level of inner nodes as a batch.
     /// \param h Hasher object.
     /// \returns True if succeeded, false otherwise.
     /// \details This method is not thread safe, so be careful when using
     /// parallelization to compute Merkle trees
     bool end_update(hasher_type &h);
 
+    /// \brief End tree update, hashing each level of inner nodes in parallel.
+    /// \param pool Threads used to hash nodes.
+    /// \returns True if succeeded, false otherwise.
+    /// \details This method is not thread safe, so be careful when using
+    /// parallelization to compute Merkle trees
+    bool end_update(thread_pool &pool);
+
     /// \brief Returns the proof for a node in the tree.
     /// \param target_address Address of target node. Must be aligned
     /// to a 2<sup>log2_target_size</sup> boundary.
@@ -339,9 +372,11 @@ public:
 
     /// \brief Recursively builds hash for page node from contiguous memory.
     /// \param h Hasher object.
+    /// \param scratch Scratch space, which must not be shared with other threads.
     /// \param page_data Pointer to start of contiguous page data.
     /// \param hash Receives the hash.
-    void get_page_node_hash(hasher_type &h, const unsigned char *page_data, hash_type &hash) const;
+    void get_page_node_hash(hasher_type &h, page_hash_scratch &scratch, const unsigned char *page_data,
+        hash_type &hash) const;
 
     /// \brief Gets currently stored hash for page node.
     /// \param page_index Page index for node.
@@ -32,10 +32,37 @@ struct htif_runtime_config {
     bool no_console_putchar;
 };
 
+/// \brief TLB runtime configuration
+/// \details Geometry of the host-side cache of page table walks consulted on TLB misses.
+/// Zero selects the default value.
+struct tlb_runtime_config {
+    uint64_t sets{}; ///< Number of sets (power of 2)
+    uint64_t ways{}; ///< Number of entries in each set (power of 2)
+};
+
+/// \brief Hasher runtime configuration
+struct hasher_runtime_config {
+    uint64_t page_cache_entries{}; ///< Number of page hashes cached by content (power of 2, or 0 to disable)
+};
+
+/// \brief How the pages of memory range images are brought into host memory
+/// \details Images are mapped copy-on-write, so by default each page is read from its image when first accessed.
+enum class image_prefault_policy {
+    none,     ///< Pages are read when first accessed
+    willneed, ///< Pages are read ahead in the background, while the machine starts
+    populate, ///< All pages are read before the machine is created
+};
+
 /// \brief Machine runtime configuration
 struct machine_runtime_config {
     concurrency_runtime_config concurrency{};
     htif_runtime_config htif{};
+    tlb_runtime_config tlb{};
+    hasher_runtime_config hasher{};
+    bool merkle_cache{};
+    bool store_direct_io{};
+    bool store_compressed{};
+    image_prefault_policy image_prefault{};
     bool skip_root_hash_check{};
     bool skip_version_check{};
 };
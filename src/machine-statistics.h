@@ -45,6 +45,8 @@ struct machine_statistics {
     uint64_t tlb_rmiss;                      ///< Counts TLB read access misses
     uint64_t tlb_whit;                       ///< Counts TLB write access hits
     uint64_t tlb_wmiss;                      ///< Counts TLB write access misses
+    uint64_t tlb_hhit;                       ///< Counts TLB misses that hit the host TLB
+    uint64_t tlb_hmiss;                      ///< Counts TLB misses that also missed the host TLB
     uint64_t tlb_flush_all;                  ///< Counts TLB flush all calls
     uint64_t tlb_flush_vaddr;                ///< Counts TLB flush virtual address calls
     uint64_t tlb_flush_read;                 ///< Counts read TLB flush calls
@@ -14,22 +14,29 @@
 // with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
 //
 
+#include <algorithm>
+#include <atomic>
 #include <boost/range/adaptor/sliced.hpp>
 #include <chrono>
 #include <cinttypes>
 #include <cstdio>
 #include <cstring>
 #include <filesystem>
-#include <future>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
-#include <mutex>
+#include <set>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <thread>
+#include <unistd.h>
+#include <zlib.h>
 
 #include "clint-factory.h"
 #include "htif-factory.h"
 #include "interpret.h"
+#include "is-pristine.h"
 #include "machine.h"
 #include "riscv-constants.h"
 #include "rom.h"
@@ -134,6 +141,34 @@ pma_entry machine::make_memory_range_pma_entry(const std::string &description, c
     return make_mmapd_memory_pma_entry(description, c.start, c.length, c.image_filename, c.shared);
 }
 
+/// \brief Brings the pages of a memory range image into host memory according to a prefault policy
+/// \param pma Memory range PMA entry
+/// \param policy Prefault policy
+static void prefault_image(pma_entry &pma, image_prefault_policy policy) {
+    auto &memory = pma.get_memory();
+    if (policy == image_prefault_policy::none || memory.get_backing_file() < 0) {
+        return;
+    }
+    unsigned char *host_memory = memory.get_host_memory();
+    const uint64_t length = memory.get_length();
+    // Advice is only a hint, so failures are ignored and pages are read on demand as usual
+    if (policy == image_prefault_policy::willneed) {
+        (void) madvise(host_memory, length, MADV_WILLNEED);
+        return;
+    }
+#ifdef MADV_POPULATE_READ
+    if (madvise(host_memory, length, MADV_POPULATE_READ) == 0) {
+        return;
+    }
+#endif
+    // Older kernels cannot populate mappings on request, so read one byte of each page instead
+    const auto page_size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    (void) madvise(host_memory, length, MADV_WILLNEED);
+    for (uint64_t offset = 0; offset < length; offset += page_size) {
+        (void) *static_cast<volatile unsigned char *>(host_memory + offset);
+    }
+}
+
 pma_entry machine::make_flash_drive_pma_entry(const std::string &description, const memory_range_config &c) {
     return make_memory_range_pma_entry(description, c).set_flags(m_flash_drive_flags);
 }
@@ -223,8 +258,14 @@ void machine::replace_memory_range(const memory_range_config &range) {
             if (DID_is_protected(curr)) {
                 throw std::invalid_argument{"attempt to replace a protected range "s + pma.get_description()};
             }
-            // replace range preserving original flags
-            pma = make_memory_range_pma_entry(pma.get_description(), range).set_flags(pma.get_flags());
+            // replace range preserving original description and flags
+            const auto description = pma.get_description();
+            const auto flags = pma.get_flags();
+            keep_pma_entry_for_rollback(pma);
+            pma = make_memory_range_pma_entry(description, range).set_flags(flags);
+            prefault_image(pma, m_r.image_prefault);
+            m_decode_cache.clear();
+            m_host_tlb.clear();
             return;
         }
     }
@@ -280,7 +321,9 @@ machine::machine(const machine_config &c, const machine_runtime_config &r) :
     m_t{},
     m_c{c},
     m_uarch{c.uarch},
-    m_r{r} {
+    m_r{r},
+    m_host_tlb{r.tlb},
+    m_page_hash_cache{r.hasher} {
 
     if (m_c.processor.marchid == UINT64_C(-1)) {
         m_c.processor.marchid = MARCHID_INIT;
@@ -438,6 +481,12 @@ machine::machine(const machine_config &c, const machine_runtime_config &r) :
     // Last, add sentinel
     m_pmas.push_back(&m_s.empty_pma);
 
+    for (auto *pma : m_pmas) {
+        if (pma->get_istart_M()) {
+            prefault_image(*pma, m_r.image_prefault);
+        }
+    }
+
     // Initialize TLB device
     // this must be done after all PMA entries are already registered, so we can lookup page addresses
     if (!m_c.tlb.image_filename.empty()) {
@@ -472,13 +521,129 @@ static void load_hash(const std::string &dir, machine::hash_type &h) {
     }
 }
 
-machine::machine(const std::string &dir, const machine_runtime_config &r) : machine{machine_config::load(dir), r} {
+/// \brief Returns the name of the file that holds the base directory of a delta store
+static std::string get_delta_base_filename(const std::string &dir) {
+    return dir + "/base";
+}
+
+/// \brief Returns the name of the file that holds the pages of a memory range changed since the base
+static std::string get_delta_filename(const std::string &dir, uint64_t start, uint64_t length) {
+    return std::filesystem::path{machine_config::get_image_filename(dir, start, length)}
+        .replace_extension(".delta")
+        .string();
+}
+
+/// \brief Reads the base directory of a delta store
+/// \param dir Directory where machine was stored
+/// \returns Base directory, or an empty string if machine was stored in full
+static std::string load_delta_base(const std::string &dir) {
+    const auto name = get_delta_base_filename(dir);
+    if (!std::filesystem::exists(name)) {
+        return {};
+    }
+    std::ifstream ifs{name, std::ios::binary};
+    const std::string base{std::istreambuf_iterator<char>{ifs}, std::istreambuf_iterator<char>{}};
+    if (!ifs.good() && !ifs.eof()) {
+        throw std::runtime_error{"error reading from '" + name + "'"};
+    }
+    if (base.empty()) {
+        throw std::runtime_error{"empty base directory in '" + name + "'"};
+    }
+    // Relative bases are relative to the delta store, so both can be moved together
+    std::filesystem::path path{base};
+    if (path.is_relative()) {
+        path = std::filesystem::path{dir} / path;
+    }
+    return path.lexically_normal().string();
+}
+
+/// \brief Writes the base directory of a delta store
+static void store_delta_base(const std::string &base_dir, const std::string &dir) {
+    const auto name = get_delta_base_filename(dir);
+    const auto base = std::filesystem::proximate(base_dir, dir).string();
+    auto fp = unique_fopen(name.c_str(), "wb");
+    if (fwrite(base.data(), 1, base.size(), fp.get()) != base.size()) {
+        throw std::runtime_error{"error writing to '" + name + "'"};
+    }
+}
+
+/// \brief Returns the chain of delta stores leading from a stored machine to the full store they are based on
+/// \param dir Directory where machine was stored
+/// \returns Directories in the chain, starting with dir and ending with the full store
+static std::vector<std::string> get_delta_chain(const std::string &dir) {
+    std::vector<std::string> chain{dir};
+    std::set<std::filesystem::path> seen{std::filesystem::weakly_canonical(dir)};
+    for (auto base = load_delta_base(dir); !base.empty(); base = load_delta_base(base)) {
+        if (!seen.insert(std::filesystem::weakly_canonical(base)).second) {
+            throw std::runtime_error{"delta store '" + dir + "' has a cyclic chain of bases"};
+        }
+        chain.push_back(base);
+    }
+    return chain;
+}
+
+/// \brief Returns the name of the compressed image file that replaces a memory range image file
+static std::string get_compressed_image_filename(const std::string &image_filename) {
+    return std::filesystem::path{image_filename}.replace_extension(".cbin").string();
+}
+
+/// \brief Loads the config of a stored machine
+/// \details The memory ranges of a delta store are first loaded from the images in the full store it is based on
+static machine_config load_layered_config(const std::string &dir) {
+    auto c = machine_config::load(dir);
+    const auto chain = get_delta_chain(dir);
+    if (chain.size() > 1) {
+        c.adjust_image_filenames(chain.back());
+        c.tlb.image_filename = machine_config::get_image_filename(dir, PMA_SHADOW_TLB_START, PMA_SHADOW_TLB_LENGTH);
+        // Deltas are layered over the images in memory, so the images themselves must not change
+        for (auto &f : c.flash_drive) {
+            f.shared = false;
+        }
+    }
+    // Ranges stored compressed start out zeroed, and are decompressed into memory once the machine is built
+    const auto clear_if_compressed = [](std::string &image_filename) {
+        if (!image_filename.empty() && std::filesystem::exists(get_compressed_image_filename(image_filename))) {
+            image_filename.clear();
+        }
+    };
+    clear_if_compressed(c.rom.image_filename);
+    clear_if_compressed(c.ram.image_filename);
+    clear_if_compressed(c.uarch.ram.image_filename);
+    for (auto &f : c.flash_drive) {
+        clear_if_compressed(f.image_filename);
+        if (f.image_filename.empty()) {
+            f.shared = false;
+        }
+    }
+    if (c.rollup.has_value()) {
+        auto &r = c.rollup.value();
+        clear_if_compressed(r.rx_buffer.image_filename);
+        clear_if_compressed(r.tx_buffer.image_filename);
+        clear_if_compressed(r.input_metadata.image_filename);
+        clear_if_compressed(r.voucher_hashes.image_filename);
+        clear_if_compressed(r.notice_hashes.image_filename);
+    }
+    return c;
+}
+
+machine::machine(const std::string &dir, const machine_runtime_config &r) : machine{load_layered_config(dir), r} {
+    load_compressed_pmas(get_delta_chain(dir).back());
+    load_delta_pmas(dir);
+    hash_type hstored;
+    load_hash(dir, hstored);
+    // Memory now matches what was stored, so a later delta store needs only pages changed from now on
+    begin_store_generation(hstored);
+    if (r.skip_root_hash_check && !r.merkle_cache) {
+        return;
+    }
+    // Pages with hashes in the cache need not be hashed again
+    if (r.merkle_cache) {
+        load_merkle_cache(dir, hstored);
+    }
     if (r.skip_root_hash_check) {
         return;
     }
-    hash_type hstored;
     hash_type hrestored;
-    load_hash(dir, hstored);
     if (!update_merkle_tree()) {
         throw std::runtime_error{"error updating Merkle tree"};
     }
@@ -591,15 +756,371 @@ static void store_device_pma(const machine &m, const pma_entry &pma, const std::
     }
 }
 
-static void store_memory_pma(const pma_entry &pma, const std::string &dir) {
-    if (!pma.get_istart_M()) {
-        throw std::runtime_error{"attempt to save non-memory PMA"};
+/// \brief Owns a file descriptor, closing it when destroyed
+class unique_fd final {
+public:
+    explicit unique_fd(int fd) : m_fd{fd} {}
+    /// \brief No copy constructor
+    unique_fd(const unique_fd &) = delete;
+    /// \brief No copy assignment
+    unique_fd &operator=(const unique_fd &) = delete;
+    /// \brief Move constructor takes ownership
+    unique_fd(unique_fd &&other) noexcept : m_fd{std::exchange(other.m_fd, -1)} {}
+    /// \brief No move assignment
+    unique_fd &operator=(unique_fd &&) = delete;
+    /// \brief Destructor closes file descriptor
+    ~unique_fd() {
+        if (m_fd >= 0) {
+            close(m_fd);
+        }
     }
-    auto name = machine_config::get_image_filename(dir, pma.get_start(), pma.get_length());
-    auto fp = unique_fopen(name.c_str(), "wb");
-    const pma_memory &mem = pma.get_memory();
-    if (fwrite(mem.get_host_memory(), 1, pma.get_length(), fp.get()) != pma.get_length()) {
-        throw std::runtime_error{"error writing to '" + name + "'"};
+    int get(void) const {
+        return m_fd;
+    }
+
+private:
+    int m_fd;
+};
+
+/// \brief Creates a memory range image file filled with zeros, without allocating any of its blocks
+/// \param name Image file name
+/// \param length Length of image
+/// \param direct Whether to bypass the page cache when writing, if the file system supports it
+static unique_fd create_sparse_image(const std::string &name, uint64_t length, bool direct) {
+    constexpr int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+    int fd = -1;
+#ifdef O_DIRECT
+    if (direct) {
+        fd = open(name.c_str(), flags | O_DIRECT, 0666);
+    }
+#else
+    (void) direct;
+#endif
+    // File systems that do not support direct I/O fail with EINVAL, so fall back to buffered I/O
+    // (those that fail only when writing are handled by pwrite_direct())
+    if (fd < 0) {
+        fd = open(name.c_str(), flags, 0666);
+    }
+    if (fd < 0) {
+        throw std::system_error{errno, std::generic_category(), "unable to create '" + name + "'"};
+    }
+    unique_fd image{fd};
+    if (ftruncate(fd, static_cast<off_t>(length)) != 0) {
+        throw std::system_error{errno, std::generic_category(), "error writing to '" + name + "'"};
+    }
+    return image;
+}
+
+/// \brief Writes data to a file at a given offset, retrying until all of it is written
+static void pwrite_all(int fd, const unsigned char *data, uint64_t length, uint64_t offset, const std::string &name) {
+    while (length > 0) {
+        const ssize_t written = pwrite(fd, data, length, static_cast<off_t>(offset));
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            throw std::system_error{errno, std::generic_category(), "error writing to '" + name + "'"};
+        }
+        data += written;
+        length -= written;
+        offset += written;
+    }
+}
+
+/// \brief Reads data from a file at a given offset, retrying until all of it is read
+static void pread_all(int fd, unsigned char *data, uint64_t length, uint64_t offset, const std::string &name) {
+    while (length > 0) {
+        const ssize_t got = pread(fd, data, length, static_cast<off_t>(offset));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got < 0) {
+            throw std::system_error{errno, std::generic_category(), "error reading from '" + name + "'"};
+        }
+        if (got == 0) {
+            throw std::runtime_error{"unexpected end of file reading from '" + name + "'"};
+        }
+        data += got;
+        length -= got;
+        offset += got;
+    }
+}
+
+/// \brief Writes data to a file that may have been opened for direct I/O, falling back to buffered I/O
+/// \details Some file systems accept O_DIRECT when the file is opened, but reject the writes themselves with EINVAL.
+/// In that case, direct I/O is turned off for the file, which is shared by all writers, and the write is retried.
+static void pwrite_direct(int fd, const unsigned char *data, uint64_t length, uint64_t offset,
+    const std::string &name) {
+    try {
+        pwrite_all(fd, data, length, offset, name);
+    } catch (const std::system_error &e) {
+        if (e.code() != std::errc::invalid_argument) {
+            throw;
+        }
+#ifdef O_DIRECT
+        // Another writer may have turned off direct I/O already
+        const int flags = fcntl(fd, F_GETFL);
+        if (flags < 0 || ((flags & O_DIRECT) != 0 && fcntl(fd, F_SETFL, flags & ~O_DIRECT) != 0)) {
+            throw;
+        }
+#endif
+        // Rewriting what was already written is harmless, so the whole write is retried
+        pwrite_all(fd, data, length, offset, name);
+    }
+}
+
+/// \brief Writes a run of pages of a memory range to its image file
+/// \param fd Image file descriptor
+/// \param data Host memory of run
+/// \param length Length of run, a multiple of the page size
+/// \param offset Offset of run within range, a multiple of the page size
+/// \param bounce Page-aligned buffer of DIRECT_IO_BOUNCE_SIZE bytes, or nullptr if the file does not use direct I/O
+/// \param name Image file name
+static void store_page_run(int fd, const unsigned char *data, uint64_t length, uint64_t offset, unsigned char *bounce,
+    const std::string &name) {
+    if (!bounce) {
+        pwrite_all(fd, data, length, offset, name);
+        return;
+    }
+    if ((reinterpret_cast<uintptr_t>(data) & (PMA_PAGE_SIZE - 1)) == 0) {
+        pwrite_direct(fd, data, length, offset, name);
+        return;
+    }
+    // Direct I/O requires page-aligned buffers, so copy misaligned data through the bounce buffer
+    constexpr uint64_t DIRECT_IO_BOUNCE_SIZE = UINT64_C(1) << 20;
+    for (uint64_t done = 0; done < length; done += DIRECT_IO_BOUNCE_SIZE) {
+        const uint64_t chunk = std::min(DIRECT_IO_BOUNCE_SIZE, length - done);
+        memcpy(bounce, data + done, chunk);
+        pwrite_direct(fd, bounce, chunk, offset + done, name);
+    }
+}
+
+void machine::store_memory_pmas(const std::vector<const pma_entry *> &pmas, const std::string &dir) const {
+    // Ranges are split into pieces of this many bytes, written independently by each worker
+    constexpr uint64_t piece_length = UINT64_C(16) << 20;
+    constexpr uint64_t bounce_length = UINT64_C(1) << 20;
+    /// \brief Part of a memory range to be written to its image file
+    struct piece {
+        size_t image;    ///< Index of image file
+        uint64_t offset; ///< Offset of piece within range
+        uint64_t length; ///< Length of piece
+    };
+    std::vector<std::string> names;
+    std::vector<unique_fd> images;
+    std::vector<piece> pieces;
+    names.reserve(pmas.size());
+    images.reserve(pmas.size());
+    for (const auto *pma : pmas) {
+        if (!pma->get_istart_M()) {
+            throw std::runtime_error{"attempt to save non-memory PMA"};
+        }
+        names.push_back(machine_config::get_image_filename(dir, pma->get_start(), pma->get_length()));
+        images.push_back(create_sparse_image(names.back(), pma->get_length(), m_r.store_direct_io));
+        for (uint64_t offset = 0; offset < pma->get_length(); offset += piece_length) {
+            pieces.push_back(piece{images.size() - 1, offset, std::min(piece_length, pma->get_length() - offset)});
+        }
+    }
+    const auto &pristine_page_hash = machine_merkle_tree::get_pristine_hash(machine_merkle_tree::get_log2_page_size());
+    thread_pool &pool = get_merkle_tree_pool();
+    std::vector<unique_calloc_ptr<unsigned char>> bounces(pool.get_concurrency());
+    pool.parallel_for(pieces.size(), 1, [&](uint64_t worker, uint64_t begin, uint64_t end) {
+        auto &bounce = bounces[worker];
+        if (m_r.store_direct_io && !bounce) {
+            // NOLINTNEXTLINE(cppcoreguidelines-no-malloc)
+            bounce.reset(static_cast<unsigned char *>(std::aligned_alloc(PMA_PAGE_SIZE, bounce_length)));
+            if (!bounce) {
+                throw std::bad_alloc{};
+            }
+        }
+        for (uint64_t i = begin; i < end; ++i) {
+            const auto &p = pieces[i];
+            const pma_entry &pma = *pmas[p.image];
+            const unsigned char *host_memory = pma.get_memory().get_host_memory();
+            // Pages whose hash is pristine are all zeros, and are left as holes in the image
+            uint64_t run_begin = p.offset;
+            for (uint64_t offset = p.offset; offset <= p.offset + p.length; offset += PMA_PAGE_SIZE) {
+                bool pristine = true;
+                if (offset < p.offset + p.length) {
+                    hash_type page_hash;
+                    m_t.get_page_node_hash(pma.get_start() + offset, page_hash);
+                    pristine = page_hash == pristine_page_hash;
+                }
+                if (pristine) {
+                    if (offset > run_begin) {
+                        store_page_run(images[p.image].get(), host_memory + run_begin, offset - run_begin, run_begin,
+                            bounce.get(), names[p.image]);
+                    }
+                    run_begin = offset + PMA_PAGE_SIZE;
+                }
+            }
+        }
+    });
+}
+
+// A compressed image file holds a header, followed by one record per chunk of the range, followed by the chunks
+// themselves. Each chunk is compressed independently with zlib, so chunks can be compressed and decompressed in
+// parallel and in any order. Pristine chunks are not stored, and chunks that do not compress are stored as they are.
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Compressed image layout requires a little-endian host");
+
+/// \brief Compressed image file header
+struct compressed_image_header {
+    std::array<char, 8> magic; ///< COMPRESSED_IMAGE_MAGIC
+    uint64_t version;          ///< COMPRESSED_IMAGE_VERSION
+    uint64_t length;           ///< Length of range
+    uint64_t log2_chunk_size;  ///< Log2 of the uncompressed size of each chunk (the last one may be shorter)
+    uint64_t chunk_count;      ///< Number of chunk records
+};
+
+/// \brief Compressed image record of a chunk
+struct compressed_image_chunk {
+    uint64_t offset; ///< Offset of chunk data in file
+    uint64_t length; ///< Length of chunk data: 0 if pristine, its uncompressed size if stored as is
+};
+
+static constexpr std::array<char, 8> COMPRESSED_IMAGE_MAGIC{'C', 'M', 'C', 'I', 'M', 'A', 'G', 'E'};
+static constexpr uint64_t COMPRESSED_IMAGE_VERSION = 1;
+static constexpr uint64_t COMPRESSED_IMAGE_LOG2_CHUNK_SIZE = 16;
+
+void machine::store_compressed_pmas(const std::vector<const pma_entry *> &pmas, const std::string &dir) const {
+    constexpr uint64_t chunk_size = UINT64_C(1) << COMPRESSED_IMAGE_LOG2_CHUNK_SIZE;
+    // Chunks are compressed a batch at a time, so the memory holding compressed data stays bounded
+    constexpr uint64_t batch_count = 256;
+    const uint64_t bound = compressBound(chunk_size);
+    const auto &pristine_page_hash = machine_merkle_tree::get_pristine_hash(machine_merkle_tree::get_log2_page_size());
+    thread_pool &pool = get_merkle_tree_pool();
+    std::vector<unsigned char> compressed(batch_count * bound);
+    for (const auto *pma : pmas) {
+        if (!pma->get_istart_M()) {
+            throw std::runtime_error{"attempt to save non-memory PMA"};
+        }
+        const uint64_t length = pma->get_length();
+        const unsigned char *host_memory = pma->get_memory().get_host_memory();
+        const auto name =
+            get_compressed_image_filename(machine_config::get_image_filename(dir, pma->get_start(), length));
+        const int fd = open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+        if (fd < 0) {
+            throw std::system_error{errno, std::generic_category(), "unable to create '" + name + "'"};
+        }
+        const unique_fd image{fd};
+        const compressed_image_header header{COMPRESSED_IMAGE_MAGIC, COMPRESSED_IMAGE_VERSION, length,
+            COMPRESSED_IMAGE_LOG2_CHUNK_SIZE, (length + chunk_size - 1) >> COMPRESSED_IMAGE_LOG2_CHUNK_SIZE};
+        std::vector<compressed_image_chunk> chunks(header.chunk_count);
+        uint64_t file_offset = sizeof(header) + chunks.size() * sizeof(compressed_image_chunk);
+        for (uint64_t batch_begin = 0; batch_begin < chunks.size(); batch_begin += batch_count) {
+            const uint64_t batch_end = std::min<uint64_t>(batch_begin + batch_count, chunks.size());
+            pool.parallel_for(batch_end - batch_begin, 1, [&](uint64_t, uint64_t begin, uint64_t end) {
+                for (uint64_t i = begin; i < end; ++i) {
+                    const uint64_t offset = (batch_begin + i) << COMPRESSED_IMAGE_LOG2_CHUNK_SIZE;
+                    const uint64_t chunk_length = std::min(chunk_size, length - offset);
+                    auto &chunk = chunks[batch_begin + i];
+                    bool pristine = true;
+                    for (uint64_t page = offset; pristine && page < offset + chunk_length; page += PMA_PAGE_SIZE) {
+                        hash_type page_hash;
+                        m_t.get_page_node_hash(pma->get_start() + page, page_hash);
+                        pristine = page_hash == pristine_page_hash;
+                    }
+                    if (pristine) {
+                        chunk.length = 0;
+                        continue;
+                    }
+                    uLongf compressed_length = bound;
+                    if (compress2(compressed.data() + i * bound, &compressed_length, host_memory + offset,
+                            chunk_length, Z_BEST_SPEED) != Z_OK ||
+                        compressed_length >= chunk_length) {
+                        compressed_length = chunk_length;
+                    }
+                    chunk.length = compressed_length;
+                }
+            });
+            // Chunks are laid out in order, so the batch is written sequentially once it is compressed
+            for (uint64_t i = batch_begin; i < batch_end; ++i) {
+                auto &chunk = chunks[i];
+                if (chunk.length == 0) {
+                    continue;
+                }
+                const uint64_t offset = i << COMPRESSED_IMAGE_LOG2_CHUNK_SIZE;
+                const bool stored_as_is = chunk.length == std::min(chunk_size, length - offset);
+                chunk.offset = file_offset;
+                pwrite_all(fd, stored_as_is ? host_memory + offset : compressed.data() + (i - batch_begin) * bound,
+                    chunk.length, file_offset, name);
+                file_offset += chunk.length;
+            }
+        }
+        pwrite_all(fd, reinterpret_cast<const unsigned char *>(&header), sizeof(header), 0, name);
+        pwrite_all(fd, reinterpret_cast<const unsigned char *>(chunks.data()),
+            chunks.size() * sizeof(compressed_image_chunk), sizeof(header), name);
+    }
+}
+
+void machine::load_compressed_pmas(const std::string &dir) {
+    thread_pool &pool = get_merkle_tree_pool();
+    for (auto *pma : m_pmas) {
+        if (!pma->get_istart_M() || pma->get_length() == 0) {
+            continue;
+        }
+        const uint64_t length = pma->get_length();
+        const auto name =
+            get_compressed_image_filename(machine_config::get_image_filename(dir, pma->get_start(), length));
+        if (!std::filesystem::exists(name)) {
+            continue;
+        }
+        const int fd = open(name.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::system_error{errno, std::generic_category(), "unable to open '" + name + "'"};
+        }
+        const unique_fd image{fd};
+        struct stat statbuf {};
+        if (fstat(fd, &statbuf) != 0) {
+            throw std::system_error{errno, std::generic_category(), "unable to obtain length of '" + name + "'"};
+        }
+        const auto size = static_cast<uint64_t>(statbuf.st_size);
+        compressed_image_header header{};
+        pread_all(fd, reinterpret_cast<unsigned char *>(&header), sizeof(header), 0, name);
+        if (header.magic != COMPRESSED_IMAGE_MAGIC || header.version != COMPRESSED_IMAGE_VERSION ||
+            header.length != length || header.log2_chunk_size < PMA_constants::PMA_PAGE_SIZE_LOG2 ||
+            header.log2_chunk_size > 30 ||
+            header.chunk_count != (length + (UINT64_C(1) << header.log2_chunk_size) - 1) >> header.log2_chunk_size) {
+            throw std::runtime_error{"invalid compressed image file '" + name + "'"};
+        }
+        const uint64_t chunk_size = UINT64_C(1) << header.log2_chunk_size;
+        std::vector<compressed_image_chunk> chunks(header.chunk_count);
+        const uint64_t data_offset = sizeof(header) + chunks.size() * sizeof(compressed_image_chunk);
+        pread_all(fd, reinterpret_cast<unsigned char *>(chunks.data()), chunks.size() * sizeof(compressed_image_chunk),
+            sizeof(header), name);
+        for (uint64_t i = 0; i < chunks.size(); ++i) {
+            const auto &chunk = chunks[i];
+            const uint64_t chunk_length = std::min(chunk_size, length - (i << header.log2_chunk_size));
+            if (chunk.length > chunk_length ||
+                (chunk.length > 0 &&
+                    (chunk.offset < data_offset || chunk.offset > size || chunk.length > size - chunk.offset))) {
+                throw std::runtime_error{"invalid compressed image file '" + name + "'"};
+            }
+        }
+        // Memory starts out zeroed, so pristine chunks need no work at all
+        unsigned char *host_memory = pma->get_memory().get_host_memory();
+        std::vector<std::vector<unsigned char>> buffers(pool.get_concurrency());
+        pool.parallel_for(chunks.size(), 1, [&](uint64_t worker, uint64_t begin, uint64_t end) {
+            auto &buffer = buffers[worker];
+            buffer.resize(chunk_size);
+            for (uint64_t i = begin; i < end; ++i) {
+                const auto &chunk = chunks[i];
+                const uint64_t offset = i << header.log2_chunk_size;
+                const uint64_t chunk_length = std::min(chunk_size, length - offset);
+                if (chunk.length == 0) {
+                    continue;
+                }
+                if (chunk.length == chunk_length) {
+                    pread_all(fd, host_memory + offset, chunk_length, chunk.offset, name);
+                    continue;
+                }
+                pread_all(fd, buffer.data(), chunk.length, chunk.offset, name);
+                uLongf uncompressed_length = chunk_length;
+                if (uncompress(host_memory + offset, &uncompressed_length, buffer.data(), chunk.length) != Z_OK ||
+                    uncompressed_length != chunk_length) {
+                    throw std::runtime_error{"invalid compressed image file '" + name + "'"};
+                }
+            }
+        });
     }
 }
 
@@ -648,25 +1169,30 @@ static inline T &deref(T *t) {
 }
 
 void machine::store_pmas(const machine_config &c, const std::string &dir) const {
-    store_memory_pma(find_pma_entry<uint64_t>(PMA_ROM_START), dir);
-    store_memory_pma(find_pma_entry<uint64_t>(PMA_RAM_START), dir);
-    store_device_pma(*this, find_pma_entry<uint64_t>(PMA_SHADOW_TLB_START), dir);
+    std::vector<const pma_entry *> memory_pmas{&find_pma_entry<uint64_t>(PMA_ROM_START),
+        &find_pma_entry<uint64_t>(PMA_RAM_START)};
     // Could iterate over PMAs checking for those with a drive DID
     // but this is easier
     for (const auto &f : c.flash_drive) {
-        store_memory_pma(find_pma_entry<uint64_t>(f.start), dir);
+        memory_pmas.push_back(&find_pma_entry<uint64_t>(f.start));
     }
     if (c.rollup.has_value()) {
         const auto &r = c.rollup.value();
-        store_memory_pma(find_pma_entry<uint64_t>(r.rx_buffer.start), dir);
-        store_memory_pma(find_pma_entry<uint64_t>(r.tx_buffer.start), dir);
-        store_memory_pma(find_pma_entry<uint64_t>(r.input_metadata.start), dir);
-        store_memory_pma(find_pma_entry<uint64_t>(r.voucher_hashes.start), dir);
-        store_memory_pma(find_pma_entry<uint64_t>(r.notice_hashes.start), dir);
+        memory_pmas.push_back(&find_pma_entry<uint64_t>(r.rx_buffer.start));
+        memory_pmas.push_back(&find_pma_entry<uint64_t>(r.tx_buffer.start));
+        memory_pmas.push_back(&find_pma_entry<uint64_t>(r.input_metadata.start));
+        memory_pmas.push_back(&find_pma_entry<uint64_t>(r.voucher_hashes.start));
+        memory_pmas.push_back(&find_pma_entry<uint64_t>(r.notice_hashes.start));
     }
     if (!m_uarch.get_state().ram.get_istart_E()) {
-        store_memory_pma(m_uarch.get_state().ram, dir);
+        memory_pmas.push_back(&m_uarch.get_state().ram);
+    }
+    if (m_r.store_compressed) {
+        store_compressed_pmas(memory_pmas, dir);
+    } else {
+        store_memory_pmas(memory_pmas, dir);
     }
+    store_device_pma(*this, find_pma_entry<uint64_t>(PMA_SHADOW_TLB_START), dir);
 }
 
 static void store_hash(const machine::hash_type &h, const std::string &dir) {
@@ -677,6 +1203,143 @@ static void store_hash(const machine::hash_type &h, const std::string &dir) {
     }
 }
 
+// The Merkle cache file holds a header, followed by one range record per memory PMA, followed by the hashes of the
+// non-pristine pages of all ranges, in the order of the ranges and in increasing address within each range.
+// Records have fixed sizes and native (little-endian) layout, so the file can be used in place once read or mapped.
+// Loading the cache trusts the stored directory, much like skip_root_hash_check does: memory is not read to check
+// the hashes, so images that are mapped lazily stay that way. Images modified after the cache was stored go unnoticed.
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Merkle cache layout requires a little-endian host");
+
+/// \brief Merkle cache file header
+struct merkle_cache_header {
+    std::array<char, 8> magic;    ///< MERKLE_CACHE_MAGIC
+    uint64_t version;             ///< MERKLE_CACHE_VERSION
+    machine::hash_type root_hash; ///< Root hash of machine when cache was stored
+    uint64_t range_count;         ///< Number of range records
+    uint64_t page_count;          ///< Number of page records
+};
+
+/// \brief Merkle cache record of a memory range
+struct merkle_cache_range {
+    uint64_t start;      ///< Start of range
+    uint64_t length;     ///< Length of range
+    uint64_t page_count; ///< Number of page records belonging to range
+};
+
+/// \brief Merkle cache record of a non-pristine page
+struct merkle_cache_page {
+    uint64_t address;        ///< Start of page
+    machine::hash_type hash; ///< Page hash
+};
+
+static constexpr std::array<char, 8> MERKLE_CACHE_MAGIC{'C', 'M', 'M', 'K', 'C', 'A', 'C', 'H'};
+static constexpr uint64_t MERKLE_CACHE_VERSION = 3;
+
+static std::string get_merkle_cache_filename(const std::string &dir) {
+    return dir + "/merkle-cache";
+}
+
+/// \brief Tells if the page records of a range in the Merkle cache are well formed for a memory PMA
+/// \param pma Memory PMA entry.
+/// \param first First page record of range.
+/// \param last One past last page record of range.
+/// \returns True if records are sorted by address and each names a page inside the PMA.
+static bool is_valid_merkle_cache_range(const pma_entry &pma, const merkle_cache_page *first,
+    const merkle_cache_page *last) {
+    const bool sorted = std::adjacent_find(first, last, [](const auto &a, const auto &b) {
+        return a.address >= b.address;
+    }) == last;
+    return sorted && std::all_of(first, last, [&pma](const auto &page) {
+        return (page.address & (PMA_PAGE_SIZE - 1)) == 0 && page.address - pma.get_start() < pma.get_length();
+    });
+}
+
+void machine::store_merkle_cache(const std::string &dir) const {
+    const auto &pristine_page_hash = machine_merkle_tree::get_pristine_hash(machine_merkle_tree::get_log2_page_size());
+    std::vector<merkle_cache_range> ranges;
+    std::vector<merkle_cache_page> pages;
+    for (const auto *pma : m_pmas) {
+        merkle_cache_range range{pma->get_start(), pma->get_length(), 0};
+        if (!pma->get_istart_M() || range.length == 0) {
+            continue;
+        }
+        for (uint64_t offset = 0; offset < range.length; offset += PMA_PAGE_SIZE) {
+            merkle_cache_page page{range.start + offset, {}};
+            m_t.get_page_node_hash(page.address, page.hash);
+            if (page.hash != pristine_page_hash) {
+                pages.push_back(page);
+                ++range.page_count;
+            }
+        }
+        ranges.push_back(range);
+    }
+    merkle_cache_header header{MERKLE_CACHE_MAGIC, MERKLE_CACHE_VERSION, {}, ranges.size(), pages.size()};
+    m_t.get_root_hash(header.root_hash);
+    auto name = get_merkle_cache_filename(dir);
+    auto fp = unique_fopen(name.c_str(), "wb");
+    if (fwrite(&header, sizeof(header), 1, fp.get()) != 1 ||
+        fwrite(ranges.data(), sizeof(merkle_cache_range), ranges.size(), fp.get()) != ranges.size() ||
+        fwrite(pages.data(), sizeof(merkle_cache_page), pages.size(), fp.get()) != pages.size()) {
+        throw std::runtime_error{"error writing to '" + name + "'"};
+    }
+}
+
+void machine::load_merkle_cache(const std::string &dir, const hash_type &root_hash) {
+    // The cache only saves work, so any problem with it just means pages are hashed as usual
+    auto name = get_merkle_cache_filename(dir);
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(name, ec);
+    if (ec || size < sizeof(merkle_cache_header)) {
+        return;
+    }
+    auto fp = unique_fopen(name.c_str(), "rb", std::nothrow_t{});
+    merkle_cache_header header{};
+    if (!fp || fread(&header, sizeof(header), 1, fp.get()) != 1) {
+        return;
+    }
+    if (header.magic != MERKLE_CACHE_MAGIC || header.version != MERKLE_CACHE_VERSION ||
+        header.root_hash != root_hash || header.range_count > m_pmas.size() ||
+        header.page_count > (size - sizeof(header)) / sizeof(merkle_cache_page) ||
+        size != sizeof(header) + header.range_count * sizeof(merkle_cache_range) +
+                header.page_count * sizeof(merkle_cache_page)) {
+        return;
+    }
+    std::vector<merkle_cache_range> ranges(header.range_count);
+    std::vector<merkle_cache_page> pages(header.page_count);
+    if (fread(ranges.data(), sizeof(merkle_cache_range), ranges.size(), fp.get()) != ranges.size() ||
+        fread(pages.data(), sizeof(merkle_cache_page), pages.size(), fp.get()) != pages.size()) {
+        return;
+    }
+    m_t.begin_update();
+    uint64_t first_page = 0;
+    for (const auto &range : ranges) {
+        if (range.page_count > pages.size() - first_page) {
+            break;
+        }
+        const auto *first = pages.data() + first_page;
+        const auto *last = first + range.page_count;
+        first_page += range.page_count;
+        // Skip ranges that no longer match the machine, or whose records are malformed
+        auto it = std::find_if(m_pmas.begin(), m_pmas.end(), [&range](const pma_entry *pma) {
+            return pma->get_istart_M() && pma->get_start() == range.start && pma->get_length() == range.length;
+        });
+        if (it == m_pmas.end() || !is_valid_merkle_cache_range(**it, first, last)) {
+            continue;
+        }
+        for (const auto *page = first; page != last; ++page) {
+            if (!m_t.update_page_node_hash(page->address, page->hash)) {
+                m_t.end_update(get_merkle_tree_pool());
+                throw std::runtime_error{"error updating Merkle tree"};
+            }
+        }
+        // Pages without a record are pristine, and so is their (missing) node in the tree
+        (*it)->mark_pages_clean();
+    }
+    if (!m_t.end_update(get_merkle_tree_pool())) {
+        throw std::runtime_error{"error updating Merkle tree"};
+    }
+}
+
 void machine::store(const std::string &dir) const {
     if (mkdir(dir.c_str(), 0700)) {
         throw std::runtime_error{"error creating directory '" + dir + "'"};
@@ -690,6 +1353,139 @@ void machine::store(const std::string &dir) const {
     auto c = get_serialization_config();
     c.store(dir);
     store_pmas(c, dir);
+    if (m_r.merkle_cache) {
+        store_merkle_cache(dir);
+    }
+    begin_store_generation(h);
+}
+
+// A delta file holds a header, followed by the offsets of the pages it contains, in increasing order, followed by
+// the contents of these pages, in the same order.
+
+/// \brief Delta file header
+struct delta_header {
+    std::array<char, 8> magic;         ///< DELTA_MAGIC
+    uint64_t version;                  ///< DELTA_VERSION
+    machine::hash_type base_root_hash; ///< Root hash of the base the delta applies to
+    uint64_t start;                    ///< Start of range
+    uint64_t length;                   ///< Length of range
+    uint64_t page_count;               ///< Number of pages in delta
+};
+
+static constexpr std::array<char, 8> DELTA_MAGIC{'C', 'M', 'D', 'E', 'L', 'T', 'A', '\0'};
+static constexpr uint64_t DELTA_VERSION = 1;
+
+void machine::store_delta_pmas(const hash_type &base_root_hash, const std::string &dir) const {
+    for (const auto *pma : m_pmas) {
+        if (!pma->get_istart_M() || pma->get_length() == 0) {
+            continue;
+        }
+        std::vector<uint64_t> offsets;
+        for (uint64_t offset = 0; offset < pma->get_length(); offset += PMA_PAGE_SIZE) {
+            if (pma->is_page_marked_store_dirty(offset)) {
+                offsets.push_back(offset);
+            }
+        }
+        const delta_header header{DELTA_MAGIC, DELTA_VERSION, base_root_hash, pma->get_start(), pma->get_length(),
+            offsets.size()};
+        const auto name = get_delta_filename(dir, pma->get_start(), pma->get_length());
+        auto fp = unique_fopen(name.c_str(), "wb");
+        if (fwrite(&header, sizeof(header), 1, fp.get()) != 1 ||
+            fwrite(offsets.data(), sizeof(uint64_t), offsets.size(), fp.get()) != offsets.size()) {
+            throw std::runtime_error{"error writing to '" + name + "'"};
+        }
+        const unsigned char *host_memory = pma->get_memory().get_host_memory();
+        for (const auto offset : offsets) {
+            if (fwrite(host_memory + offset, 1, PMA_PAGE_SIZE, fp.get()) != PMA_PAGE_SIZE) {
+                throw std::runtime_error{"error writing to '" + name + "'"};
+            }
+        }
+    }
+}
+
+void machine::load_delta_pmas(const std::string &dir) {
+    const auto chain = get_delta_chain(dir);
+    // Apply deltas from the oldest to the newest, each over the state of its base
+    for (size_t layer = chain.size() - 1; layer > 0; --layer) {
+        const auto &delta_dir = chain[layer - 1];
+        hash_type base_root_hash;
+        load_hash(chain[layer], base_root_hash);
+        for (auto *pma : m_pmas) {
+            if (!pma->get_istart_M() || pma->get_length() == 0) {
+                continue;
+            }
+            const auto name = get_delta_filename(delta_dir, pma->get_start(), pma->get_length());
+            auto fp = unique_fopen(name.c_str(), "rb");
+            delta_header header{};
+            if (fread(&header, sizeof(header), 1, fp.get()) != 1) {
+                throw std::runtime_error{"error reading from '" + name + "'"};
+            }
+            if (header.magic != DELTA_MAGIC || header.version != DELTA_VERSION || header.start != pma->get_start() ||
+                header.length != pma->get_length() || header.page_count > pma->get_page_count()) {
+                throw std::runtime_error{"invalid delta file '" + name + "'"};
+            }
+            if (header.base_root_hash != base_root_hash) {
+                throw std::runtime_error{"delta file '" + name + "' does not apply to base '" + chain[layer] + "'"};
+            }
+            std::vector<uint64_t> offsets(header.page_count);
+            if (fread(offsets.data(), sizeof(uint64_t), offsets.size(), fp.get()) != offsets.size()) {
+                throw std::runtime_error{"error reading from '" + name + "'"};
+            }
+            for (size_t i = 0; i < offsets.size(); ++i) {
+                if ((offsets[i] & (PMA_PAGE_SIZE - 1)) != 0 || offsets[i] >= pma->get_length() ||
+                    (i > 0 && offsets[i] <= offsets[i - 1])) {
+                    throw std::runtime_error{"invalid delta file '" + name + "'"};
+                }
+            }
+            // Pages are stored back to back, so runs of consecutive pages are read at once
+            unsigned char *host_memory = pma->get_memory().get_host_memory();
+            for (size_t begin = 0, end = 0; begin < offsets.size(); begin = end) {
+                for (end = begin + 1; end < offsets.size() && offsets[end] == offsets[end - 1] + PMA_PAGE_SIZE;
+                     ++end) {
+                    ;
+                }
+                const uint64_t length = (end - begin) * PMA_PAGE_SIZE;
+                if (fread(host_memory + offsets[begin], 1, length, fp.get()) != length) {
+                    throw std::runtime_error{"error reading from '" + name + "'"};
+                }
+                for (size_t i = begin; i < end; ++i) {
+                    pma->mark_dirty_page(offsets[i]);
+                }
+            }
+        }
+    }
+}
+
+void machine::begin_store_generation(const hash_type &root_hash) const {
+    for (auto *pma : m_pmas) {
+        pma->mark_pages_store_clean();
+    }
+    m_store_generation_hash = root_hash;
+}
+
+void machine::store_delta(const std::string &dir, const std::string &base_dir) const {
+    hash_type base_root_hash;
+    load_hash(base_dir, base_root_hash);
+    // Pages are store dirty relative to the state last stored or loaded, so the base must hold that state
+    if (!m_store_generation_hash.has_value() || m_store_generation_hash.value() != base_root_hash) {
+        throw std::invalid_argument{"base directory '" + base_dir + "' is not the state last stored or loaded"};
+    }
+    if (mkdir(dir.c_str(), 0700)) {
+        throw std::runtime_error{"error creating directory '" + dir + "'"};
+    }
+    if (!update_merkle_tree()) {
+        throw std::runtime_error{"error updating Merkle tree"};
+    }
+    hash_type h;
+    m_t.get_root_hash(h);
+    store_hash(h, dir);
+    auto c = get_serialization_config();
+    c.store(dir);
+    store_delta_base(base_dir, dir);
+    store_delta_pmas(base_root_hash, dir);
+    store_device_pma(*this, find_pma_entry<uint64_t>(PMA_SHADOW_TLB_START), dir);
+    // The Merkle cache is not stored, since it describes images that are not in the delta store
+    begin_store_generation(h);
 }
 
 // NOLINTNEXTLINE(modernize-use-equals-default)
@@ -731,6 +1527,8 @@ machine::~machine() {
     (void) fprintf(stderr, "tlb_rmiss: %" PRIu64 "\n", m_s.stats.tlb_rmiss);
     (void) fprintf(stderr, "tlb_whit: %" PRIu64 "\n", m_s.stats.tlb_whit);
     (void) fprintf(stderr, "tlb_wmiss: %" PRIu64 "\n", m_s.stats.tlb_wmiss);
+    (void) fprintf(stderr, "tlb_hhit: %" PRIu64 "\n", m_s.stats.tlb_hhit);
+    (void) fprintf(stderr, "tlb_hmiss: %" PRIu64 "\n", m_s.stats.tlb_hmiss);
     (void) fprintf(stderr, "tlb_flush_all: %" PRIu64 "\n", m_s.stats.tlb_flush_all);
     (void) fprintf(stderr, "tlb_flush_read: %" PRIu64 "\n", m_s.stats.tlb_flush_read);
     (void) fprintf(stderr, "tlb_flush_write: %" PRIu64 "\n", m_s.stats.tlb_flush_write);
@@ -742,6 +1540,8 @@ machine::~machine() {
     (void) fprintf(stderr, "tlb_flush_fence_vma_asid: %" PRIu64 "\n", m_s.stats.tlb_flush_fence_vma_asid);
     (void) fprintf(stderr, "tlb_flush_fence_vma_vaddr: %" PRIu64 "\n", m_s.stats.tlb_flush_fence_vma_vaddr);
     (void) fprintf(stderr, "tlb_flush_fence_vma_asid_vaddr: %" PRIu64 "\n", m_s.stats.tlb_flush_fence_vma_asid_vaddr);
+    (void) fprintf(stderr, "page_hash_cache_hit: %" PRIu64 "\n", m_page_hash_cache.get_hits());
+    (void) fprintf(stderr, "page_hash_cache_miss: %" PRIu64 "\n", m_page_hash_cache.get_misses());
 #endif
 }
 
@@ -1384,6 +2184,40 @@ void machine::mark_write_tlb_dirty_pages(void) const {
     }
 }
 
+void machine::mark_modified_write_tlb_dirty_pages(void) const {
+    for (uint64_t i = 0; i < PMA_TLB_SIZE; ++i) {
+        const tlb_hot_entry &tlbhe = m_s.tlb.hot[TLB_WRITE][i];
+        if (tlbhe.vaddr_page != TLB_INVALID_PAGE) {
+            const tlb_cold_entry &tlbce = m_s.tlb.cold[TLB_WRITE][i];
+            pma_entry &pma = m_s.pmas[tlbce.pma_index];
+            const uint64_t page_start_in_range = tlbce.paddr_page - pma.get_start();
+            // Pages that did not change since the last update still have the same hash
+            if (!m_write_tlb_snapshot.is_unchanged(i, tlbce.paddr_page,
+                    pma.get_memory().get_host_memory() + page_start_in_range)) {
+                pma.mark_dirty_page(page_start_in_range);
+            }
+        }
+    }
+}
+
+void machine::take_write_tlb_snapshot(void) const {
+    for (uint64_t i = 0; i < PMA_TLB_SIZE; ++i) {
+        const tlb_hot_entry &tlbhe = m_s.tlb.hot[TLB_WRITE][i];
+        if (tlbhe.vaddr_page != TLB_INVALID_PAGE) {
+            const tlb_cold_entry &tlbce = m_s.tlb.cold[TLB_WRITE][i];
+            const pma_entry &pma = m_s.pmas[tlbce.pma_index];
+            const unsigned char *page_data =
+                pma.get_memory().get_host_memory() + (tlbce.paddr_page - pma.get_start());
+            if (!m_write_tlb_snapshot.is_unchanged(i, tlbce.paddr_page, page_data)) {
+                m_write_tlb_snapshot.take(i, tlbce.paddr_page, page_data);
+            }
+        } else {
+            // The Merkle tree may hold the hash of other contents once the entry maps the page again
+            m_write_tlb_snapshot.invalidate_entry(i);
+        }
+    }
+}
+
 bool machine::verify_dirty_page_maps(void) const {
     // double begin = now();
     static_assert(PMA_PAGE_SIZE == machine_merkle_tree::get_page_size(),
@@ -1393,6 +2227,7 @@ bool machine::verify_dirty_page_maps(void) const {
     if (!scratch) {
         return false;
     }
+    auto hash_scratch = std::make_unique<machine_merkle_tree::page_hash_scratch>();
     bool broken = false;
     // Go over the write TLB and mark as dirty all pages currently there
     mark_write_tlb_dirty_pages();
@@ -1408,7 +2243,7 @@ bool machine::verify_dirty_page_maps(void) const {
                 hash_type stored;
                 hash_type real;
                 m_t.get_page_node_hash(page_address, stored);
-                m_t.get_page_node_hash(h, page_data, real);
+                m_t.get_page_node_hash(h, *hash_scratch, page_data, real);
                 const bool marked_dirty = pma.is_page_marked_dirty(page_start_in_range);
                 const bool is_dirty = (real != stored);
                 if (is_dirty && !marked_dirty) {
@@ -1433,100 +2268,120 @@ bool machine::verify_dirty_page_maps(void) const {
     return !broken;
 }
 
+/// \brief Number of dirty pages hashed by a thread at a time while updating the Merkle tree
+static constexpr uint64_t merkle_tree_update_chunk = 8;
+
+/// \brief Maximum number of dirty pages gathered before they are hashed while updating the Merkle tree
+static constexpr uint64_t merkle_tree_update_batch = 16384;
+
 static uint64_t get_task_concurrency(uint64_t value) {
     const uint64_t concurrency = value > 0 ? value : std::max(std::thread::hardware_concurrency(), 1U);
     return std::min(concurrency, static_cast<uint64_t>(THREADS_MAX));
 }
 
+thread_pool &machine::get_merkle_tree_pool(void) const {
+    if (!m_merkle_tree_pool) {
+        m_merkle_tree_pool = std::make_unique<thread_pool>(get_task_concurrency(m_r.concurrency.update_merkle_tree));
+    }
+    return *m_merkle_tree_pool;
+}
+
 bool machine::update_merkle_tree(void) const {
     machine_merkle_tree::hasher_type gh;
     // double begin = now();
     static_assert(PMA_PAGE_SIZE == machine_merkle_tree::get_page_size(),
         "PMA and machine_merkle_tree page sizes must match");
-    // Go over the write TLB and mark as dirty all pages currently there
-    mark_write_tlb_dirty_pages();
-    // Now go over all PMAs and updating the Merkle tree
-    m_t.begin_update();
-    for (const auto &pma : m_pmas) {
-        auto peek = pma->get_peek();
-        // Each PMA has a number of pages
-        auto pages_in_range = (pma->get_length() + PMA_PAGE_SIZE - 1) / PMA_PAGE_SIZE;
-        // For each PMA, we launch as many threads (n) as defined on concurrency
-        // runtime config or as the hardware supports.
-        const uint64_t n = get_task_concurrency(m_r.concurrency.update_merkle_tree);
-        // The update_page_node_hash function in the machine_merkle_tree is not thread
-        // safe, so we protect it with a mutex
-        std::mutex updatex;
-        // Each thread is launched as a future, whose value tells if the
-        // computation succeeded
-        std::vector<std::future<bool>> futures;
-        futures.reserve(n);
-        for (uint64_t j = 0; j < n; ++j) {
-            futures.emplace_back(std::async((n == 1) ? std::launch::deferred : std::launch::async,
-                [&](int j) -> bool {
-                    auto scratch = unique_calloc<unsigned char>(PMA_PAGE_SIZE, std::nothrow_t{});
-                    if (!scratch) {
-                        return false;
-                    }
-                    machine_merkle_tree::hasher_type h;
-                    // Thread j is responsible for page i if i % n == j.
-                    for (uint64_t i = j; i < pages_in_range; i += n) {
-                        const uint64_t page_start_in_range = i * PMA_PAGE_SIZE;
-                        const uint64_t page_address = pma->get_start() + page_start_in_range;
-                        const unsigned char *page_data = nullptr;
-                        // Skip any clean pages
-                        if (!pma->is_page_marked_dirty(page_start_in_range)) {
-                            continue;
-                        }
-                        // If the peek failed, or if it returned a page for update but
-                        // we failed updating it, the entire process failed
-                        if (!peek(*pma, *this, page_start_in_range, &page_data, scratch.get())) {
-                            return false;
-                        }
-                        if (page_data) {
-                            const bool is_pristine = std::all_of(page_data, page_data + PMA_PAGE_SIZE,
-                                [](unsigned char pp) -> bool { return pp == '\0'; });
-
-                            if (is_pristine) {
-                                const std::lock_guard<std::mutex> lock(updatex);
-                                if (!m_t.update_page_node_hash(page_address,
-                                        machine_merkle_tree::get_pristine_hash(
-                                            machine_merkle_tree::get_log2_page_size()))) {
-                                    return false;
-                                }
-                            } else {
-                                hash_type hash;
-                                m_t.get_page_node_hash(h, page_data, hash);
-                                {
-                                    const std::lock_guard<std::mutex> lock(updatex);
-                                    if (!m_t.update_page_node_hash(page_address, hash)) {
-                                        return false;
-                                    }
-                                }
-                            }
-                        }
+    // Go over the write TLB and mark as dirty all pages currently there that may have been modified
+    mark_modified_write_tlb_dirty_pages();
+    // Gather the dirty pages of all PMAs in batches, so they can be hashed in parallel regardless of the PMA they
+    // belong to, while the memory used to gather them stays bounded no matter how many pages are dirty
+    struct dirty_page {
+        pma_entry *pma;
+        uint64_t page_start_in_range;
+        hash_type hash;
+        bool has_hash;
+    };
+    std::vector<dirty_page> pages;
+    pages.reserve(merkle_tree_update_batch);
+    // Hash dirty pages with the persistent pool of threads, each with its own hasher and scratch space.
+    // Each page receives its own hash, so no locking is needed.
+    thread_pool &pool = get_merkle_tree_pool();
+    std::vector<machine_merkle_tree::hasher_type> hashers(pool.get_concurrency());
+    std::vector<machine_merkle_tree::page_hash_scratch> hash_scratches(pool.get_concurrency());
+    auto scratch = unique_calloc<unsigned char>(pool.get_concurrency() * PMA_PAGE_SIZE, std::nothrow_t{});
+    if (!scratch) {
+        return false;
+    }
+    std::atomic<bool> failed{false};
+    const auto hash_pages = [&](uint64_t worker, uint64_t begin, uint64_t end) {
+        unsigned char *worker_scratch = scratch.get() + worker * PMA_PAGE_SIZE;
+        for (uint64_t i = begin; i < end && !failed.load(std::memory_order_relaxed); ++i) {
+            dirty_page &page = pages[i];
+            const unsigned char *page_data = nullptr;
+            // If the peek failed, the entire process failed
+            if (!page.pma->get_peek()(*page.pma, *this, page.page_start_in_range, &page_data, worker_scratch)) {
+                failed = true;
+                return;
+            }
+            if (page_data) {
+                if (is_pristine(page_data, PMA_PAGE_SIZE)) {
+                    page.hash = machine_merkle_tree::get_pristine_hash(machine_merkle_tree::get_log2_page_size());
+                } else if (m_page_hash_cache.is_enabled()) {
+                    const uint64_t fingerprint = page_hash_cache::get_fingerprint(page_data);
+                    if (!m_page_hash_cache.find(page_data, fingerprint, page.hash)) {
+                        m_t.get_page_node_hash(hashers[worker], hash_scratches[worker], page_data, page.hash);
+                        m_page_hash_cache.insert(page_data, fingerprint, page.hash);
                     }
-                    return true;
-                },
-                j));
-        }
-        // Check if any thread failed
-        bool succeeded = true;
-        for (auto &f : futures) {
-            succeeded = succeeded && f.get();
-        }
-        // If so, we also failed
-        if (!succeeded) {
-            m_t.end_update(gh);
+                } else {
+                    m_t.get_page_node_hash(hashers[worker], hash_scratches[worker], page_data, page.hash);
+                }
+                page.has_hash = true;
+            }
+        }
+    };
+    // Hashes the gathered batch, then updates the Merkle tree with the new page hashes and marks the pages as clean.
+    // Pages of a batch were already passed by the dirty page iterators, so marking them clean does not disturb them.
+    const auto flush_pages = [&]() {
+        pool.parallel_for(pages.size(), merkle_tree_update_chunk, hash_pages);
+        if (failed) {
             return false;
         }
-        // Otherwise, mark all pages in PMA as clean and move on to next
-        pma->mark_pages_clean();
+        for (auto &page : pages) {
+            if (page.has_hash &&
+                !m_t.update_page_node_hash(page.pma->get_start() + page.page_start_in_range, page.hash)) {
+                return false;
+            }
+            page.pma->mark_clean_page(page.page_start_in_range);
+        }
+        pages.clear();
+        return true;
+    };
+    m_t.begin_update();
+    bool ok = true;
+    for (auto *pma : m_pmas) {
+        const auto end = pma->end_dirty_pages();
+        for (auto it = pma->begin_dirty_pages(); ok && it != end; ++it) {
+            pages.push_back(dirty_page{pma, *it, hash_type{}, false});
+            if (pages.size() == merkle_tree_update_batch) {
+                ok = flush_pages();
+            }
+        }
+    }
+    if (!ok || !flush_pages()) {
+        m_write_tlb_snapshot.clear();
+        m_t.end_update(gh);
+        return false;
     }
     // std::cerr << "page updates done in " << now()-begin << "s\n";
     // begin = now();
-    const bool ret = m_t.end_update(gh);
+    const bool ret = m_t.end_update(pool);
     // std::cerr << "inner tree updates done in " << now()-begin << "s\n";
+    // The Merkle tree now holds the hashes of all pages, so the write TLB pages can be copied
+    if (ret) {
+        take_write_tlb_snapshot();
+    } else {
+        m_write_tlb_snapshot.clear();
+    }
     return ret;
 }
 
@@ -1542,6 +2397,8 @@ bool machine::update_merkle_tree_page(uint64_t address) {
     if (!scratch) {
         return false;
     }
+    // The Merkle tree will no longer hold the hash of the copies of this page
+    m_write_tlb_snapshot.invalidate_page(address);
     m_t.begin_update();
     const unsigned char *page_data = nullptr;
     auto peek = pma.get_peek();
@@ -1552,7 +2409,8 @@ bool machine::update_merkle_tree_page(uint64_t address) {
     if (page_data) {
         const uint64_t page_address = pma.get_start() + page_start_in_range;
         hash_type hash;
-        m_t.get_page_node_hash(h, page_data, hash);
+        auto hash_scratch = std::make_unique<machine_merkle_tree::page_hash_scratch>();
+        m_t.get_page_node_hash(h, *hash_scratch, page_data, hash);
         if (!m_t.update_page_node_hash(page_address, hash)) {
             m_t.end_update(h);
             return false;
@@ -1659,6 +2517,27 @@ machine_merkle_tree::proof_type machine::get_proof(uint64_t address, int log2_si
     return get_proof(address, log2_size, skip_merkle_tree_update);
 }
 
+machine_merkle_tree::multiproof_type machine::get_proofs(
+    const std::vector<machine_merkle_tree::multiproof_type::target_type> &targets, skip_merkle_tree_update_t) const {
+    if (targets.empty()) {
+        throw std::invalid_argument{"no proof targets"};
+    }
+    std::vector<machine_merkle_tree::proof_type> proofs;
+    proofs.reserve(targets.size());
+    for (const auto &target : targets) {
+        proofs.push_back(get_proof(target.address, target.log2_size, skip_merkle_tree_update));
+    }
+    return machine_merkle_tree::multiproof_type::from_proofs(proofs);
+}
+
+machine_merkle_tree::multiproof_type machine::get_proofs(
+    const std::vector<machine_merkle_tree::multiproof_type::target_type> &targets) const {
+    if (!update_merkle_tree()) {
+        throw std::runtime_error{"error updating Merkle tree"};
+    }
+    return get_proofs(targets, skip_merkle_tree_update);
+}
+
 void machine::read_memory(uint64_t address, unsigned char *data, uint64_t length) const {
     if (length == 0) {
         return;
@@ -1722,14 +2601,18 @@ void machine::write_memory(uint64_t address, const unsigned char *data, size_t l
         throw std::invalid_argument{"address range not entirely in memory PMA"};
     }
     constexpr const auto log2_page_size = PMA_constants::PMA_PAGE_SIZE_LOG2;
-    uint64_t page_in_range = ((address - pma.get_start()) >> log2_page_size) << log2_page_size;
+    const uint64_t offset = address - pma.get_start();
+    uint64_t page_in_range = (offset >> log2_page_size) << log2_page_size;
     constexpr const auto page_size = PMA_constants::PMA_PAGE_SIZE;
-    auto npages = (length + page_size - 1) / page_size;
+    // The range may straddle one more page than its length suggests, when not page aligned
+    auto npages = ((offset + length - 1) >> log2_page_size) - (offset >> log2_page_size) + 1;
     for (decltype(npages) i = 0; i < npages; ++i) {
+        pma.save_page_for_rollback(page_in_range);
         pma.mark_dirty_page(page_in_range);
+        m_decode_cache.invalidate_page(pma.get_start() + page_in_range);
         page_in_range += page_size;
     }
-    memcpy(pma.get_memory().get_host_memory() + (address - pma.get_start()), data, length);
+    memcpy(pma.get_memory().get_host_memory() + offset, data, length);
 }
 
 void machine::read_virtual_memory(uint64_t vaddr_start, unsigned char *data, uint64_t length) {
@@ -1860,9 +2743,120 @@ void machine::set_uarch_halt_flag() {
 }
 
 void machine::reset_uarch_state() {
+    auto &ram = m_uarch.get_state().ram;
+    // Resetting the state replaces the RAM, unless it fails because the microarchitecture is not halted
+    if (m_uarch.get_state().halt_flag && ram.get_istart_M()) {
+        keep_pma_entry_for_rollback(ram);
+    }
     m_uarch.reset_state();
 }
 
+void machine::keep_pma_entry_for_rollback(pma_entry &pma) {
+    if (!m_rollback_state) {
+        return;
+    }
+    auto &replaced = m_rollback_state->replaced_pmas;
+    // Only the entry in place when the snapshot was taken matters
+    const bool kept = std::any_of(replaced.begin(), replaced.end(), [&pma](const auto &r) { return r.first == &pma; });
+    if (!kept) {
+        replaced.emplace_back(&pma, std::move(pma));
+    }
+}
+
+void machine::save_write_tlb_pages_for_rollback(void) {
+    for (uint64_t i = 0; i < PMA_TLB_SIZE; ++i) {
+        const tlb_hot_entry &tlbhe = m_s.tlb.hot[TLB_WRITE][i];
+        if (tlbhe.vaddr_page != TLB_INVALID_PAGE) {
+            const tlb_cold_entry &tlbce = m_s.tlb.cold[TLB_WRITE][i];
+            pma_entry &pma = m_s.pmas[tlbce.pma_index];
+            pma.save_page_for_rollback(tlbce.paddr_page - pma.get_start());
+        }
+    }
+}
+
+/// \brief Tells if a CSR is restored by a rollback
+static bool is_rollback_csr(machine::csr r) {
+    switch (r) {
+        case machine::csr::mvendorid:
+        case machine::csr::marchid:
+        case machine::csr::mimpid:
+        case machine::csr::uarch_ram_length:
+            // Read-only
+            return false;
+        case machine::csr::uarch_halt_flag:
+            // Can only be set, so it is restored separately
+            return false;
+        default:
+            return true;
+    }
+}
+
+void machine::snapshot(void) {
+    auto state = std::make_unique<rollback_state>();
+    for (int i = 1; i < X_REG_COUNT; ++i) {
+        state->x[i] = read_x(i);
+    }
+    for (int i = 0; i < F_REG_COUNT; ++i) {
+        state->f[i] = read_f(i);
+    }
+    state->csrs.resize(num_csr);
+    for (int i = 0; i < num_csr; ++i) {
+        if (is_rollback_csr(static_cast<csr>(i))) {
+            state->csrs[i] = read_csr(static_cast<csr>(i));
+        }
+    }
+    for (int i = 1; i < UARCH_X_REG_COUNT; ++i) {
+        state->uarch_x[i] = read_uarch_x(i);
+    }
+    state->uarch_halt_flag = read_uarch_halt_flag();
+    state->tlb = m_s.tlb;
+    // Memory is not copied now: each page is saved right before it is first modified
+    for (auto *pma : m_pmas) {
+        pma->begin_saving_pages_for_rollback();
+    }
+    save_write_tlb_pages_for_rollback();
+    m_rollback_state = std::move(state);
+}
+
+void machine::rollback(void) {
+    if (!m_rollback_state) {
+        throw std::runtime_error{"no snapshot to roll back to"};
+    }
+    const auto state = std::move(m_rollback_state);
+    // Bring back replaced entries first, since the pages they saved must be restored into them
+    for (auto &[slot, original] : state->replaced_pmas) {
+        *slot = std::move(original);
+        // The Merkle tree holds the hashes of the replacement, so every page must be hashed again
+        for (uint64_t offset = 0; offset < slot->get_length(); offset += PMA_PAGE_SIZE) {
+            slot->mark_dirty_page(offset);
+        }
+    }
+    for (auto *pma : m_pmas) {
+        pma->restore_pages_saved_for_rollback();
+    }
+    for (int i = 1; i < X_REG_COUNT; ++i) {
+        write_x(i, state->x[i]);
+    }
+    for (int i = 0; i < F_REG_COUNT; ++i) {
+        write_f(i, state->f[i]);
+    }
+    for (int i = 0; i < num_csr; ++i) {
+        if (is_rollback_csr(static_cast<csr>(i))) {
+            write_csr(static_cast<csr>(i), state->csrs[i]);
+        }
+    }
+    for (int i = 1; i < UARCH_X_REG_COUNT; ++i) {
+        write_uarch_x(i, state->uarch_x[i]);
+    }
+    m_uarch.get_state().halt_flag = state->uarch_halt_flag;
+    m_s.tlb = state->tlb;
+    // Memory, page tables and TLB changed behind the back of the caches used by the interpreter
+    m_decode_cache.clear();
+    m_host_tlb.clear();
+    m_host_tlb.mark_all_shadow_entries();
+    m_write_tlb_snapshot.clear();
+}
+
 uint64_t machine::read_uarch_ram_length(void) const {
     return m_uarch.read_ram_length();
 }
@@ -1928,6 +2922,10 @@ access_log machine::step_uarch(const access_log::type &log_type, bool one_based)
     a.push_bracket(bracket_type::begin, "step");
     uarch_step(a);
     a.push_bracket(bracket_type::end, "step");
+    // The microarchitecture changes memory and TLB behind the back of the decoded instruction cache
+    m_decode_cache.clear();
+    m_host_tlb.mark_all_shadow_entries();
+    save_write_tlb_pages_for_rollback();
     // Verify access log before returning
     if (log_type.has_proofs()) {
         hash_type root_hash_after;
@@ -1940,13 +2938,17 @@ access_log machine::step_uarch(const access_log::type &log_type, bool one_based)
     return std::move(*a.get_log());
 }
 
-// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
 uarch_interpreter_break_reason machine::run_uarch(uint64_t uarch_cycle_end) {
     if (m_uarch.get_state().ram.get_istart_E()) {
         throw std::runtime_error("microarchitecture RAM is not present");
     }
     uarch_state_access a(m_uarch.get_state(), get_state());
-    return uarch_interpret(a, uarch_cycle_end);
+    const auto break_reason = uarch_interpret(a, uarch_cycle_end);
+    // The microarchitecture changes memory and TLB behind the back of the decoded instruction cache
+    m_decode_cache.clear();
+    m_host_tlb.mark_all_shadow_entries();
+    save_write_tlb_pages_for_rollback();
+    return break_reason;
 }
 
 interpreter_break_reason machine::run(uint64_t mcycle_end) {
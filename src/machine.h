@@ -21,16 +21,22 @@
 /// \brief Cartesi machine interface
 
 #include <memory>
+#include <optional>
 
 #include "access-log.h"
+#include "decode-cache.h"
+#include "host-tlb.h"
 #include "htif.h"
 #include "interpret.h"
 #include "machine-config.h"
 #include "machine-merkle-tree.h"
 #include "machine-runtime-config.h"
 #include "machine-state.h"
+#include "page-hash-cache.h"
+#include "thread-pool.h"
 #include "uarch-interpret.h"
 #include "uarch-machine.h"
+#include "write-tlb-snapshot.h"
 
 namespace cartesi {
 
@@ -58,6 +64,35 @@ class machine final {
     machine_config m_c;              ///< Copy of initialization config
     uarch_machine m_uarch;           ///< Microarchitecture machine
     machine_runtime_config m_r;      ///< Copy of initialization runtime config
+    decode_cache m_decode_cache;     ///< Decoded instruction cache used by the interpreter
+    host_tlb m_host_tlb;             ///< Cache of page table walks used by the interpreter
+
+    /// \brief Copies of the pages mapped by the write TLB when the Merkle tree was last updated
+    mutable write_tlb_snapshot m_write_tlb_snapshot;
+
+    /// \brief Threads used to update the Merkle tree, created on first use
+    mutable std::unique_ptr<thread_pool> m_merkle_tree_pool;
+
+    /// \brief Root hash of the state last stored or loaded, which delta stores must use as their base
+    mutable std::optional<machine_merkle_tree::hash_type> m_store_generation_hash;
+
+    /// \brief Hashes of recently hashed pages, indexed by contents
+    mutable page_hash_cache m_page_hash_cache;
+
+    /// \brief State restored by a rollback, other than the pages memory PMAs save before they are first modified
+    struct rollback_state {
+        std::array<uint64_t, X_REG_COUNT> x{};             ///< General-purpose registers
+        std::array<uint64_t, F_REG_COUNT> f{};             ///< Floating-point registers
+        std::vector<uint64_t> csrs;                        ///< Writable CSRs, indexed by csr
+        std::array<uint64_t, UARCH_X_REG_COUNT> uarch_x{}; ///< Microarchitecture general-purpose registers
+        bool uarch_halt_flag{};                            ///< Microarchitecture halt flag
+        shadow_tlb_state tlb{};                            ///< TLB
+        /// \brief PMA entries replaced since the snapshot, each with the entry it replaced
+        std::vector<std::pair<pma_entry *, pma_entry>> replaced_pmas;
+    };
+
+    /// \brief State saved by the last snapshot, or nullptr if there is none
+    std::unique_ptr<rollback_state> m_rollback_state;
 
     static const pma_entry::flags m_rom_flags;                   ///< PMA flags used for ROM
     static const pma_entry::flags m_ram_flags;                   ///< PMA flags used for RAM
@@ -115,6 +150,50 @@ class machine final {
     /// \param directory Directory where PMAs will be stored
     void store_pmas(const machine_config &config, const std::string &directory) const;
 
+    /// \brief Saves memory PMAs into sparse image files, in parallel
+    /// \param pmas Memory PMAs to be stored
+    /// \param directory Directory where PMAs will be stored
+    /// \details Pages the Merkle tree knows to be pristine are left as holes in the image files.
+    /// Must only be called right after the Merkle tree is updated.
+    void store_memory_pmas(const std::vector<const pma_entry *> &pmas, const std::string &directory) const;
+
+    /// \brief Saves memory PMAs into compressed image files, compressing chunks in parallel
+    /// \param pmas Memory PMAs to be stored
+    /// \param directory Directory where PMAs will be stored
+    /// \details Chunks the Merkle tree knows to be pristine are not stored at all.
+    /// Must only be called right after the Merkle tree is updated.
+    void store_compressed_pmas(const std::vector<const pma_entry *> &pmas, const std::string &directory) const;
+
+    /// \brief Decompresses the compressed image files of memory PMAs into host memory, in parallel
+    /// \param directory Directory where PMAs were stored
+    /// \details Memory PMAs without a compressed image file are left untouched.
+    void load_compressed_pmas(const std::string &directory);
+
+    /// \brief Saves the page hashes of all stored memory PMAs into the Merkle cache file
+    /// \param directory Directory where PMAs were stored
+    void store_merkle_cache(const std::string &directory) const;
+
+    /// \brief Loads the page hashes of memory PMAs from the Merkle cache file, marking those pages clean
+    /// \param directory Directory where machine was stored
+    /// \param root_hash Root hash stored with the machine
+    /// \details Cached hashes are trusted without reading memory. Ranges that no longer match the machine, or whose
+    /// records are malformed, are left dirty, to be hashed as usual. Nothing is loaded if the cache is missing,
+    /// malformed, or was not stored with the same root hash.
+    void load_merkle_cache(const std::string &directory, const machine_merkle_tree::hash_type &root_hash);
+
+    /// \brief Saves the pages of memory PMAs dirtied since the store generation began into delta files
+    /// \param base_root_hash Root hash of the base the deltas apply to
+    /// \param directory Directory where PMAs will be stored
+    void store_delta_pmas(const machine_merkle_tree::hash_type &base_root_hash, const std::string &directory) const;
+
+    /// \brief Layers the delta files of a chain of delta stores over memory PMAs loaded from the full store
+    /// \param directory Directory where machine was stored
+    void load_delta_pmas(const std::string &directory);
+
+    /// \brief Begins a new store generation, in which pages are store dirty only if they change
+    /// \param root_hash Root hash of the state that was just stored or loaded
+    void begin_store_generation(const machine_merkle_tree::hash_type &root_hash) const;
+
     /// \brief Obtain PMA entry that covers a given physical memory region
     /// \param pmas Container of pmas to be searched.
     /// \param s Pointer to machine state.
@@ -128,6 +207,24 @@ class machine final {
     template <typename CONTAINER>
     const pma_entry &find_pma_entry(const CONTAINER &pmas, uint64_t paddr, size_t length) const;
 
+    /// \brief Go over the write TLB and mark as dirty all pages modified since the last Merkle tree update.
+    void mark_modified_write_tlb_dirty_pages(void) const;
+
+    /// \brief Returns threads used to update the Merkle tree, creating them if needed.
+    thread_pool &get_merkle_tree_pool(void) const;
+
+    /// \brief Go over the write TLB and copy all pages currently there into the snapshot.
+    /// \details Must only be called right after the Merkle tree is updated.
+    void take_write_tlb_snapshot(void) const;
+
+    /// \brief Go over the write TLB and save for rollback all pages currently there.
+    /// \details Pages in the write TLB can be modified without notice, so they must be saved as soon as they get there.
+    void save_write_tlb_pages_for_rollback(void);
+
+    /// \brief Keeps a PMA entry about to be replaced, so a rollback can bring it back
+    /// \param pma PMA entry to be replaced
+    void keep_pma_entry_for_rollback(pma_entry &pma);
+
 public:
     /// \brief Type of hash
     using hash_type = machine_merkle_tree::hash_type;
@@ -193,6 +290,13 @@ public:
     /// \param directory Directory to store machine into
     void store(const std::string &directory) const;
 
+    /// \brief Serialize state to directory, as a delta relative to a previously stored directory
+    /// \param directory Directory to store machine into
+    /// \param base_directory Directory the machine was last stored to or loaded from
+    /// \details Only memory pages changed since the machine was last stored or loaded are written.
+    /// Loading the delta directory also reads the base directory, so the base must be kept.
+    void store_delta(const std::string &directory, const std::string &base_directory) const;
+
     /// \brief No default constructor
     machine(void) = delete;
     /// \brief No copy constructor
@@ -219,6 +323,14 @@ public:
     /// \brief Resets the microarchitecture state
     void reset_uarch_state();
 
+    /// \brief Takes a snapshot of the machine state, replacing the previous snapshot, if any
+    /// \details Memory pages are only copied right before they are first modified after the snapshot, so a snapshot
+    /// and its rollback take time proportional to the number of pages modified in between.
+    void snapshot(void);
+
+    /// \brief Rolls the machine state back to the last snapshot, which is then discarded
+    void rollback(void);
+
     /// \brief Runs the machine for one micro cycle logging all accesses to the state.
     /// \param log_type Type of access log to generate.
     /// \param one_based Use 1-based indices when reporting errors.
@@ -253,6 +365,21 @@ public:
         return m_s;
     }
 
+    /// \brief Returns decoded instruction cache used by the interpreter.
+    decode_cache &get_decode_cache(void) {
+        return m_decode_cache;
+    }
+
+    /// \brief Returns cache of page table walks used by the interpreter.
+    host_tlb &get_host_tlb(void) {
+        return m_host_tlb;
+    }
+
+    /// \brief Returns cache of page hashes used when updating the Merkle tree, with its hit and miss counters.
+    const page_hash_cache &get_page_hash_cache(void) const {
+        return m_page_hash_cache;
+    }
+
     /// \brief Destructor.
     ~machine();
 
@@ -283,6 +410,20 @@ public:
     /// This overload is used to optimize proof generation when the caller knows that the tree is already up to date.
     machine_merkle_tree::proof_type get_proof(uint64_t address, int log2_size, skip_merkle_tree_update_t) const;
 
+    /// \brief Obtains a single proof for several nodes in the Merkle tree.
+    /// \param targets Address and log<sub>2</sub> of size of each target node, as in get_proof().
+    /// \returns Multiproof with the hash of each target, and each sibling hash needed to verify them listed once.
+    /// \details The Merkle tree is updated only once for all targets.
+    machine_merkle_tree::multiproof_type get_proofs(
+        const std::vector<machine_merkle_tree::multiproof_type::target_type> &targets) const;
+
+    /// \brief Obtains a single proof for several nodes in the Merkle tree without making any modifications to the tree.
+    /// \param targets Address and log<sub>2</sub> of size of each target node, as in get_proof().
+    /// \returns Multiproof with the hash of each target, and each sibling hash needed to verify them listed once.
+    /// \details This overload is used when the caller knows that the tree is already up to date.
+    machine_merkle_tree::multiproof_type get_proofs(
+        const std::vector<machine_merkle_tree::multiproof_type::target_type> &targets, skip_merkle_tree_update_t) const;
+
     /// \brief Obtains the root hash of the Merkle tree.
     /// \param hash Receives the hash.
     void get_root_hash(hash_type &hash) const;
@@ -14,8 +14,10 @@
 // with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
 //
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <chrono>
 #include <cinttypes>
 #include <cstdarg>
 #include <cstddef>
@@ -24,9 +26,17 @@
 #include <cstdlib>
 #include <cstring>
 #include <optional>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h> // mmap, munmap, madvise
+#include <sys/stat.h> // fstat
 
 #include "back-merkle-tree.h"
 #include "cryptopp-keccak-256-hasher.h"
+#include "is-pristine.h"
+#include "pristine-merkle-tree.h"
+#include "thread-pool.h"
 #include "unique-c-ptr.h"
 
 using namespace cartesi;
@@ -110,15 +120,42 @@ __attribute__((format(printf, 1, 2))) static void error(const char *fmt, ...) {
     exit(1);
 }
 
-/// \brief Computes the hash of a word
+/// \brief Log<sub>2</sub> of the maximum number of words hashed by get_block_hash() at a time
+/// \details This bounds the scratch buffer of each worker, whatever the leaf size.
+constexpr int LOG2_MAX_BLOCK_WORDS = 12;
+
+/// \brief Returns the number of hashes in the scratch buffer needed by get_leaf_hash()
+/// \param log2_leaf_size Log<sub>2</sub> of leaf size
+/// \param log2_word_size Log<sub>2</sub> of word size
+static uint64_t get_leaf_scratch_size(int log2_leaf_size, int log2_word_size) {
+    const int log2_block_words = std::min(log2_leaf_size - log2_word_size, LOG2_MAX_BLOCK_WORDS);
+    return std::max(UINT64_C(1), 3 * (UINT64_C(1) << log2_block_words) / 2);
+}
+
+/// \brief Computes the Merkle hash of a block of data
 /// \param h Hasher object
-/// \param word Pointer to word data. Must contain 2^log2_word_size bytes
+/// \param block_data Pointer to buffer containing block data with
+/// 2^(log2_block_words+log2_word_size) bytes
+/// \param log2_block_words Log<sub>2</sub> of number of words in block
 /// \param log2_word_size Log<sub>2</sub> of word size
-/// \param hash Receives the word hash
-static void get_word_hash(hasher_type &h, const unsigned char *word, int log2_word_size, hash_type &hash) {
-    h.begin();
-    h.add_data(word, 1 << log2_word_size);
-    h.end(hash);
+/// \param scratch Buffer with room for 3*2^(log2_block_words-1) hashes
+/// \param hash Receives the Merkle hash of block data
+/// \details Word hashes are computed in a single batch. Each level above
+/// them is then computed in a single batch as well, because the hashes of
+/// sibling nodes are contiguous. Levels alternate between the beginning
+/// of the scratch buffer and the space after the word hashes.
+static void get_block_hash(hasher_type &h, const unsigned char *block_data, int log2_block_words, int log2_word_size,
+    hash_type *scratch, hash_type &hash) {
+    uint64_t count = UINT64_C(1) << log2_block_words;
+    hash_type *nodes = scratch;
+    h.hash_batch(block_data, UINT64_C(1) << log2_word_size, count, nodes);
+    while (count > 1) {
+        hash_type *parents = (nodes == scratch) ? scratch + count : scratch;
+        count /= 2;
+        h.hash_batch(nodes->data(), 2 * sizeof(hash_type), count, parents);
+        nodes = parents;
+    }
+    hash = nodes[0];
 }
 
 /// \brief Computes the Merkle hash of a leaf of data
@@ -127,31 +164,88 @@ static void get_word_hash(hasher_type &h, const unsigned char *word, int log2_wo
 /// at least 2^log2_leaf_size bytes
 /// \param log2_leaf_size Log<sub>2</sub> of leaf size
 /// \param log2_word_size Log<sub>2</sub> of word size
-/// \returns Merkle hash of leaf data
-static hash_type get_leaf_hash(hasher_type &h, const unsigned char *leaf_data, int log2_leaf_size, int log2_word_size) {
+/// \param scratch Buffer with room for get_leaf_scratch_size() hashes
+/// \param hash Receives the Merkle hash of leaf data
+/// \details Leaves with more than 2^LOG2_MAX_BLOCK_WORDS words are hashed one
+/// block at a time. The hash of each block is combined with the pending left
+/// siblings at each level above it, so only one hash per level is kept.
+static void get_leaf_hash(hasher_type &h, const unsigned char *leaf_data, int log2_leaf_size, int log2_word_size,
+    hash_type *scratch, hash_type &hash) {
     assert(log2_leaf_size >= log2_word_size);
-    if (log2_leaf_size > log2_word_size) {
-        hash_type left = get_leaf_hash(h, leaf_data, log2_leaf_size - 1, log2_word_size);
-        const hash_type right =
-            get_leaf_hash(h, leaf_data + (1 << (log2_leaf_size - 1)), log2_leaf_size - 1, log2_word_size);
-        get_concat_hash(h, left, right, left);
-        return left;
-    } else {
-        hash_type leaf;
-        get_word_hash(h, leaf_data, log2_word_size, leaf);
-        return leaf;
+    const int log2_leaf_words = log2_leaf_size - log2_word_size;
+    if (log2_leaf_words <= LOG2_MAX_BLOCK_WORDS) {
+        get_block_hash(h, leaf_data, log2_leaf_words, log2_word_size, scratch, hash);
+        return;
+    }
+    const int log2_block_size = LOG2_MAX_BLOCK_WORDS + log2_word_size;
+    const int log2_block_count = log2_leaf_words - LOG2_MAX_BLOCK_WORDS;
+    std::array<hash_type, 64> pending{};
+    for (uint64_t i = 0; i < (UINT64_C(1) << log2_block_count); ++i) {
+        hash_type node;
+        get_block_hash(h, leaf_data + (i << log2_block_size), LOG2_MAX_BLOCK_WORDS, log2_word_size, scratch, node);
+        // Each trailing one in the block index completes a subtree
+        int level = 0;
+        for (uint64_t j = i; (j & 1) != 0; j >>= 1, ++level) {
+            get_concat_hash(h, pending[level], node, node);
+        }
+        pending[level] = node;
     }
+    hash = pending[log2_block_count];
 }
 
-/// \brief Computes the Merkle hash of a leaf of data
-/// \param leaf_data Pointer to buffer containing leaf data with
-/// at least 2^log2_leaf_size bytes
+/// \brief Per-worker state for computing leaf hashes
+struct leaf_hasher {
+    hasher_type h;                  ///< Hasher object
+    std::vector<hash_type> scratch; ///< Scratch buffer for get_leaf_hash()
+};
+
+/// \brief Computes the Merkle hashes of consecutive leaves of data in parallel
+/// \param pool Thread pool
+/// \param workers Per-worker state, one for each worker in the pool
+/// \param data Pointer to buffer containing leaf_count leaves of data
+/// \param leaf_count Number of leaves
 /// \param log2_leaf_size Log<sub>2</sub> of leaf size
 /// \param log2_word_size Log<sub>2</sub> of word size
-/// \returns Merkle hash of leaf data
-static hash_type get_leaf_hash(const unsigned char *leaf_data, int log2_leaf_size, int log2_word_size) {
-    hasher_type h;
-    return get_leaf_hash(h, leaf_data, log2_leaf_size, log2_word_size);
+/// \param pristine_leaf_hash Merkle hash of a leaf filled with zeros
+/// \param leaf_hashes Receives the Merkle hash of each leaf
+/// \details Leaves filled with zeros are not hashed at all
+static void get_leaf_hashes(thread_pool &pool, std::vector<leaf_hasher> &workers, const unsigned char *data,
+    uint64_t leaf_count, int log2_leaf_size, int log2_word_size, const hash_type &pristine_leaf_hash,
+    std::vector<hash_type> &leaf_hashes) {
+    // Leaves given to a worker at a time
+    constexpr uint64_t chunk = 16;
+    const uint64_t leaf_size = UINT64_C(1) << log2_leaf_size;
+    leaf_hashes.resize(leaf_count);
+    pool.parallel_for(leaf_count, chunk, [&](uint64_t worker, uint64_t begin, uint64_t end) {
+        auto &w = workers[worker];
+        for (uint64_t i = begin; i < end; ++i) {
+            const unsigned char *leaf_data = data + i * leaf_size;
+            if (is_pristine(leaf_data, leaf_size)) {
+                leaf_hashes[i] = pristine_leaf_hash;
+            } else {
+                get_leaf_hash(w.h, leaf_data, log2_leaf_size, log2_word_size, w.scratch.data(), leaf_hashes[i]);
+            }
+        }
+    });
+}
+
+/// \brief Maps a regular file into memory for reading
+/// \param file File to map
+/// \param length Receives the length of the file
+/// \returns Pointer to mapped file, or nullptr if the file is not a regular file, is empty, or cannot be mapped
+static const unsigned char *map_input_file(FILE *file, uint64_t &length) {
+    struct stat statbuf {};
+    if (fstat(fileno(file), &statbuf) != 0 || !S_ISREG(statbuf.st_mode) || statbuf.st_size <= 0) {
+        return nullptr;
+    }
+    length = static_cast<uint64_t>(statbuf.st_size);
+    void *data = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+    if (data == MAP_FAILED) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast,performance-no-int-to-ptr)
+        return nullptr;
+    }
+    // The file is read only once, from beginning to end
+    (void) madvise(data, length, MADV_SEQUENTIAL);
+    return static_cast<const unsigned char *>(data);
 }
 
 /// \brief Prints help message
@@ -190,6 +284,19 @@ Options:
   (> 0 and <= log2_root_size)
   The granularity in which bytes are read from the input file.
 
+  --log2-chunk-size=<integer>           default: 24
+  Number of bytes hashed at a time. Leaves in each chunk are hashed in
+  parallel, and leaves filled with zeros are not hashed at all.
+  Regular files are mapped into memory and hashed in place. Other inputs
+  are read one chunk at a time.
+
+  --threads=<integer>                   default: number of hardware threads
+  Number of threads used to hash leaves and nodes.
+
+  --throughput
+  Prints the number of bytes hashed, the time taken, and the throughput
+  to standard error.
+
   --help
   Prints this message and returns.
 )",
@@ -202,6 +309,9 @@ int main(int argc, char *argv[]) {
     int log2_word_size = 3;
     int log2_leaf_size = 12;
     int log2_root_size = 0;
+    int log2_chunk_size = 24;
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    bool throughput = false;
     // Process command line arguments
     for (int i = 1; i < argc; ++i) {
         if (strcmp(argv[i], "--help") == 0) {
@@ -214,6 +324,12 @@ int main(int argc, char *argv[]) {
             ;
         } else if (intval("--log2-root-size=", argv[i], &log2_root_size)) {
             ;
+        } else if (intval("--log2-chunk-size=", argv[i], &log2_chunk_size)) {
+            ;
+        } else if (intval("--threads=", argv[i], &threads)) {
+            ;
+        } else if (strcmp(argv[i], "--throughput") == 0) {
+            throughput = true;
         } else if (intval("--page-log2-size=", argv[i], &log2_leaf_size)) {
             std::cerr << "--page-log2-size is deprecated. "
                          "use --log2-leaf-size instead\n";
@@ -230,6 +346,13 @@ int main(int argc, char *argv[]) {
             log2_leaf_size, log2_root_size);
         return 1;
     }
+    if (log2_chunk_size < 0 || log2_chunk_size >= 48) {
+        error("invalid chunk size (%d)\n", log2_chunk_size);
+        return 1;
+    }
+    if (threads < 1) {
+        threads = 1;
+    }
     // Read from stdin if no input name was given
     auto input_file = unique_file_ptr{stdin};
     if (input_name) {
@@ -240,41 +363,95 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    // Allocate buffer for leaf data
+    const auto start = std::chrono::steady_clock::now();
+
+    // Chunks hold a whole number of leaves, no more than the entire tree
     const uint64_t leaf_size = UINT64_C(1) << log2_leaf_size;
+    const uint64_t chunk_size = UINT64_C(1) << std::min(std::max(log2_chunk_size, log2_leaf_size), log2_root_size);
+
+    // Hash regular files in place, otherwise read each chunk into a buffer
+    uint64_t mapped_length = 0;
+    const unsigned char *mapped = map_input_file(input_file.get(), mapped_length);
+    unique_calloc_ptr<unsigned char> chunk_buf;
+    if (!mapped) {
+        chunk_buf = unique_calloc<unsigned char>(chunk_size, std::nothrow_t{});
+        if (!chunk_buf) {
+            error("unable to allocate chunk buffer\n");
+            return 1;
+        }
+    }
+
+    // Allocate buffer for a last leaf that must be padded with zeros
     auto leaf_buf = unique_calloc<unsigned char>(leaf_size, std::nothrow_t{});
     if (!leaf_buf) {
         error("unable to allocate leaf buffer\n");
         return 1;
     }
 
+    thread_pool pool{static_cast<uint64_t>(threads)};
+    std::vector<leaf_hasher> workers(pool.get_concurrency());
+    for (auto &w : workers) {
+        w.scratch.resize(get_leaf_scratch_size(log2_leaf_size, log2_word_size));
+    }
+    const pristine_merkle_tree pristine{log2_root_size, log2_word_size};
+    const hash_type &pristine_leaf_hash = pristine.get_hash(log2_leaf_size);
+
     back_merkle_tree back_tree{log2_root_size, log2_leaf_size, log2_word_size};
+    std::vector<hash_type> leaf_hashes;
 
     const uint64_t max_leaves = UINT64_C(1) << (log2_root_size - log2_leaf_size);
     uint64_t leaf_count = 0;
-    // Loop reading leaves from file until done or error
+    uint64_t total = 0;
+    // Loop over chunks of input until done or error
     while (true) {
-        auto got = fread(leaf_buf.get(), 1, leaf_size, input_file.get());
-        if (got == 0) {
-            if (ferror(input_file.get())) {
+        const unsigned char *data = nullptr;
+        uint64_t got = 0;
+        if (mapped) {
+            data = mapped + total;
+            got = std::min(chunk_size, mapped_length - total);
+        } else {
+            data = chunk_buf.get();
+            got = fread(chunk_buf.get(), 1, chunk_size, input_file.get());
+            if (got == 0 && ferror(input_file.get())) {
                 error("error reading input\n");
-            } else {
-                break;
             }
         }
-        if (leaf_count >= max_leaves) {
+        if (got == 0) {
+            break;
+        }
+        total += got;
+        const uint64_t full_leaves = got >> log2_leaf_size;
+        const uint64_t partial_leaf_size = got & (leaf_size - 1);
+        if (full_leaves + (partial_leaf_size != 0 ? 1 : 0) > max_leaves - leaf_count) {
             error("too many leaves for tree\n");
         }
-        // Pad leaf with zeros if file ended before next leaf boundary
-        memset(leaf_buf.get() + got, 0, leaf_size - got);
-        // Compute leaf hash
-        auto leaf_hash = get_leaf_hash(leaf_buf.get(), log2_leaf_size, log2_word_size);
-        // Add leaf to incremental tree
-        back_tree.push_back(leaf_hash);
-        // Compare the root hash for the incremental tree and the
-        // proof-by-proof tree
-        ++leaf_count;
+        // Compute the hashes of all leaves in chunk
+        get_leaf_hashes(pool, workers, data, full_leaves, log2_leaf_size, log2_word_size, pristine_leaf_hash,
+            leaf_hashes);
+        // Pad leaf with zeros if input ended before next leaf boundary
+        if (partial_leaf_size != 0) {
+            memcpy(leaf_buf.get(), data + (full_leaves << log2_leaf_size), partial_leaf_size);
+            memset(leaf_buf.get() + partial_leaf_size, 0, leaf_size - partial_leaf_size);
+            leaf_hashes.emplace_back();
+            get_leaf_hash(workers[0].h, leaf_buf.get(), log2_leaf_size, log2_word_size, workers[0].scratch.data(),
+                leaf_hashes.back());
+        }
+        // Add leaves to incremental tree
+        back_tree.push_back_range(leaf_hashes, pool);
+        leaf_count += leaf_hashes.size();
+        if (partial_leaf_size != 0) {
+            break;
+        }
     }
     print_hash(back_tree.get_root_hash(), stdout);
+    if (mapped) {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast): munmap takes a non-const pointer
+        munmap(const_cast<unsigned char *>(mapped), mapped_length);
+    }
+    if (throughput) {
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        (void) fprintf(stderr, "hashed %" PRIu64 " bytes in %.3fs (%.1f MiB/s) using %" PRIu64 " threads\n", total,
+            seconds, static_cast<double>(total) / seconds / (1024.0 * 1024.0), pool.get_concurrency());
+    }
     return 0;
 }
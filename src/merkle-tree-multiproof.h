@@ -0,0 +1,237 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef MERKLE_TREE_MULTIPROOF_H
+#define MERKLE_TREE_MULTIPROOF_H
+
+/// \file
+/// \brief Merkle tree multiproof structure
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "i-hasher.h"
+#include "merkle-tree-proof.h"
+
+namespace cartesi {
+
+/// \brief Merkle tree multiproof structure
+/// \details \{
+/// This structure holds a proof that several target nodes in the tree have certain hashes.
+/// Paths from different targets to the root often share most of their nodes, so the multiproof
+/// lists each sibling hash at most once, and omits siblings that can be computed from the targets
+/// themselves. Siblings are listed in increasing order of log2_size, then of address.
+/// \}
+/// \tparam HASH_TYPE the type that holds a hash
+/// \tparam ADDRESS_TYPE the type that holds an address
+template <typename HASH_TYPE, typename ADDRESS_TYPE = uint64_t>
+class merkle_tree_multiproof final {
+public:
+    using hash_type = HASH_TYPE;
+
+    using address_type = ADDRESS_TYPE;
+
+    /// \brief Location of a node in the tree
+    struct target_type {
+        address_type address; ///< Address of node, aligned to 2<sup>log2_size</sup>
+        int log2_size;        ///< log<sub>2</sub> of size subintended by node
+    };
+
+    /// \brief Location and hash of a node in the tree
+    struct node_type {
+        address_type address; ///< Address of node, aligned to 2<sup>log2_size</sup>
+        int log2_size;        ///< log<sub>2</sub> of size subintended by node
+        hash_type hash;       ///< Hash of node
+
+        bool operator==(const node_type &other) const {
+            return address == other.address && log2_size == other.log2_size && hash == other.hash;
+        }
+    };
+
+    /// \brief Storage for target and sibling nodes
+    using nodes_type = std::vector<node_type>;
+
+    /// \brief Constructs an empty merkle_tree_multiproof object
+    explicit merkle_tree_multiproof(int log2_root_size) : m_log2_root_size{log2_root_size}, m_root_hash{} {
+        if (log2_root_size <= 0) {
+            throw std::out_of_range{"log2_root_size is not positive"};
+        }
+    }
+
+    merkle_tree_multiproof(const merkle_tree_multiproof &other) = default;
+    merkle_tree_multiproof(merkle_tree_multiproof &&other) noexcept = default;
+    merkle_tree_multiproof &operator=(const merkle_tree_multiproof &other) = default;
+    merkle_tree_multiproof &operator=(merkle_tree_multiproof &&other) noexcept = default;
+    ~merkle_tree_multiproof() = default;
+
+    /// \brief Combines proofs for individual targets into a multiproof
+    /// \param proofs Proofs to combine, in the order targets should appear in the multiproof.
+    /// \returns Multiproof, or throws exception if proofs are not for the same tree.
+    static merkle_tree_multiproof from_proofs(const std::vector<merkle_tree_proof<hash_type, address_type>> &proofs) {
+        if (proofs.empty()) {
+            throw std::invalid_argument{"no proofs to combine"};
+        }
+        merkle_tree_multiproof multiproof{proofs.front().get_log2_root_size()};
+        multiproof.set_root_hash(proofs.front().get_root_hash());
+        // Nodes along the paths from targets to the root, and the hashes of their siblings
+        std::set<std::pair<int, address_type>> path;
+        std::map<std::pair<int, address_type>, hash_type> siblings;
+        for (const auto &proof : proofs) {
+            if (proof.get_log2_root_size() != multiproof.get_log2_root_size() ||
+                proof.get_root_hash() != multiproof.get_root_hash()) {
+                throw std::invalid_argument{"proofs are not for the same tree"};
+            }
+            multiproof.get_targets().push_back(
+                node_type{proof.get_target_address(), proof.get_log2_target_size(), proof.get_target_hash()});
+            for (int log2_size = proof.get_log2_target_size(); log2_size < proof.get_log2_root_size(); ++log2_size) {
+                const address_type address = align(proof.get_target_address(), log2_size);
+                path.emplace(log2_size, address);
+                siblings.emplace(std::make_pair(log2_size, address ^ (static_cast<address_type>(1) << log2_size)),
+                    proof.get_sibling_hash(log2_size));
+            }
+        }
+        for (const auto &[key, hash] : siblings) {
+            if (path.find(key) == path.end()) {
+                multiproof.get_siblings().push_back(node_type{key.second, key.first, hash});
+            }
+        }
+        return multiproof;
+    }
+
+    /// \brief Gets log<sub>2</sub> of size subintended by entire tree.
+    /// \returns log<sub>2</sub> of size subintended by entire tree.
+    int get_log2_root_size(void) const {
+        return m_log2_root_size;
+    }
+
+    /// \brief Set hash of root node
+    /// \param hash New hash.
+    void set_root_hash(const hash_type &hash) {
+        m_root_hash = hash;
+    }
+
+    /// \brief Gets hash of root node
+    /// \return Reference to hash.
+    const hash_type &get_root_hash(void) const {
+        return m_root_hash;
+    }
+    hash_type &get_root_hash(void) {
+        return m_root_hash;
+    }
+
+    /// \brief Gets target nodes
+    /// \return Reference to target nodes.
+    const nodes_type &get_targets(void) const {
+        return m_targets;
+    }
+    nodes_type &get_targets(void) {
+        return m_targets;
+    }
+
+    /// \brief Gets sibling nodes needed to compute the root hash from the target nodes
+    /// \return Reference to sibling nodes.
+    const nodes_type &get_siblings(void) const {
+        return m_siblings;
+    }
+    nodes_type &get_siblings(void) {
+        return m_siblings;
+    }
+
+    /// \brief Checks if two Merkle multiproofs are equal
+    bool operator==(const merkle_tree_multiproof &other) const {
+        return get_log2_root_size() == other.get_log2_root_size() && get_root_hash() == other.get_root_hash() &&
+            get_targets() == other.get_targets() && get_siblings() == other.get_siblings();
+    }
+
+    /// \brief Checks if two Merkle multiproofs are different
+    bool operator!=(const merkle_tree_multiproof &other) const {
+        return !(operator==(other));
+    }
+
+    ///< \brief Verify if multiproof is valid
+    ///< \tparam HASHER_TYPE Hasher class to use
+    ///< \param h Hasher object to use
+    ///< \return True if multiproof is valid, false otherwise
+    ///< \details Fails if a node lacks the sibling needed to compute its parent, or if nodes disagree
+    ///< (e.g., a target nested inside another target is inconsistent with it).
+    template <typename HASHER_TYPE>
+    bool verify(HASHER_TYPE &&h) const {
+        static_assert(is_an_i_hasher<HASHER_TYPE>::value, "not an i_hasher");
+        static_assert(std::is_same<typename remove_cvref<HASHER_TYPE>::type::hash_type, hash_type>::value,
+            "incompatible hash types");
+        if (get_targets().empty()) {
+            return false;
+        }
+        // Hashes of known nodes, ordered by log2_size, so each level is complete before moving to the next
+        std::map<std::pair<int, address_type>, hash_type> known;
+        for (const auto *nodes : {&get_targets(), &get_siblings()}) {
+            for (const auto &node : *nodes) {
+                const int log2_size = node.log2_size;
+                if (log2_size < 0 || log2_size > get_log2_root_size() ||
+                    node.address != align(node.address, log2_size) || align(node.address, get_log2_root_size()) != 0) {
+                    return false;
+                }
+                auto [it, inserted] = known.emplace(std::make_pair(log2_size, node.address), node.hash);
+                if (!inserted && it->second != node.hash) {
+                    return false;
+                }
+            }
+        }
+        for (auto it = known.begin(); it != known.end() && it->first.first < get_log2_root_size(); ++it) {
+            const auto [log2_size, address] = it->first;
+            const address_type bit = static_cast<address_type>(1) << log2_size;
+            auto sibling = known.find(std::make_pair(log2_size, address ^ bit));
+            if (sibling == known.end()) {
+                return false;
+            }
+            hash_type parent_hash;
+            if (address & bit) {
+                get_concat_hash(h, sibling->second, it->second, parent_hash);
+            } else {
+                get_concat_hash(h, it->second, sibling->second, parent_hash);
+            }
+            auto [parent, inserted] =
+                known.emplace(std::make_pair(log2_size + 1, align(address, log2_size + 1)), parent_hash);
+            if (!inserted && parent->second != parent_hash) {
+                return false;
+            }
+        }
+        auto root = known.find(std::make_pair(get_log2_root_size(), static_cast<address_type>(0)));
+        return root != known.end() && root->second == get_root_hash();
+    }
+
+private:
+    /// \brief Clears the bits of an address below a node size
+    static address_type align(address_type address, int log2_size) {
+        if (log2_size >= static_cast<int>(sizeof(address_type) * 8)) {
+            return 0;
+        }
+        return (address >> log2_size) << log2_size;
+    }
+
+    int m_log2_root_size;  ///< log<sub>2</sub> of size subintended by tree
+    hash_type m_root_hash; ///< Hash of root node
+    nodes_type m_targets;  ///< Target nodes, in the order they were requested
+    nodes_type m_siblings; ///< Sibling nodes not computable from targets, each listed once
+};
+
+} // namespace cartesi
+
+#endif
@@ -0,0 +1,87 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include "page-hash-cache.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace cartesi {
+
+static bool is_power_of_2(uint64_t v) {
+    return v != 0 && (v & (v - 1)) == 0;
+}
+
+page_hash_cache::page_hash_cache(const hasher_runtime_config &c) {
+    if (c.page_cache_entries == 0) {
+        return;
+    }
+    if (!is_power_of_2(c.page_cache_entries) || c.page_cache_entries > PAGE_HASH_CACHE_ENTRIES_MAX) {
+        throw std::invalid_argument{"number of page hash cache entries must be a power of 2 no greater than 1048576"};
+    }
+    m_entries.resize(c.page_cache_entries);
+    // Host pages backing the copies are only committed as entries are filled
+    m_pages = unique_calloc<unsigned char>(c.page_cache_entries * machine_merkle_tree::get_page_size());
+}
+
+uint64_t page_hash_cache::get_fingerprint(const unsigned char *page_data) {
+    // Four independent multiply-xorshift accumulators, so the loop is not bound by multiplication latency
+    constexpr uint64_t prime = UINT64_C(0x9e3779b97f4a7c15);
+    std::array<uint64_t, 4> acc{UINT64_C(0x243f6a8885a308d3), UINT64_C(0x13198a2e03707344),
+        UINT64_C(0xa4093822299f31d0), UINT64_C(0x082efa98ec4e6c89)};
+    for (uint64_t offset = 0; offset < machine_merkle_tree::get_page_size(); offset += sizeof(acc)) {
+        for (size_t i = 0; i < acc.size(); ++i) {
+            uint64_t word = 0;
+            memcpy(&word, page_data + offset + i * sizeof(uint64_t), sizeof(word));
+            acc[i] = (acc[i] ^ word) * prime;
+            acc[i] ^= acc[i] >> 29;
+        }
+    }
+    uint64_t fingerprint = 0;
+    for (const uint64_t a : acc) {
+        fingerprint = (fingerprint ^ a) * prime;
+        fingerprint ^= fingerprint >> 32;
+    }
+    return fingerprint;
+}
+
+bool page_hash_cache::find(const unsigned char *page_data, uint64_t fingerprint, hash_type &hash) {
+    const uint64_t index = fingerprint & (m_entries.size() - 1);
+    {
+        const std::lock_guard<std::mutex> lock(get_lock(index));
+        const entry &e = m_entries[index];
+        if (e.valid && e.fingerprint == fingerprint &&
+            memcmp(get_page_copy(index), page_data, machine_merkle_tree::get_page_size()) == 0) {
+            hash = e.hash;
+            m_hits.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    m_misses.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void page_hash_cache::insert(const unsigned char *page_data, uint64_t fingerprint, const hash_type &hash) {
+    const uint64_t index = fingerprint & (m_entries.size() - 1);
+    const std::lock_guard<std::mutex> lock(get_lock(index));
+    entry &e = m_entries[index];
+    memcpy(get_page_copy(index), page_data, machine_merkle_tree::get_page_size());
+    e.fingerprint = fingerprint;
+    e.hash = hash;
+    e.valid = true;
+}
+
+} // namespace cartesi
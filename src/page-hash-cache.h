@@ -0,0 +1,130 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef PAGE_HASH_CACHE_H
+#define PAGE_HASH_CACHE_H
+
+/// \file
+/// \brief Page hash cache.
+/// \details Guests often hold many pages with identical contents (e.g., shared library text, or buffers copied
+/// around), and rehashing each of them costs a full Merkle tree of the page. The page hash cache maps page
+/// contents to page hashes, so a page identical to one hashed recently is not hashed again.
+/// Entries are found by a fast non-cryptographic fingerprint of the contents. Each entry also keeps a copy
+/// of its page, and a hit requires the contents to match byte for byte, so fingerprint collisions (even ones
+/// crafted by the guest) can only cost a miss.
+/// Hashes depend only on page contents, never on their addresses, so entries never become stale.
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "machine-merkle-tree.h"
+#include "machine-runtime-config.h"
+#include "unique-c-ptr.h"
+
+namespace cartesi {
+
+/// \brief Page hash cache constants.
+enum PAGE_HASH_CACHE_constants : uint64_t {
+    PAGE_HASH_CACHE_ENTRIES_MAX = UINT64_C(1) << 20, ///< Maximum number of entries
+    PAGE_HASH_CACHE_LOCKS = 64,                      ///< Number of locks protecting the entries
+};
+
+/// \class page_hash_cache
+/// \brief Bounded direct-mapped cache of page hashes indexed by page contents.
+/// \details Lookups and insertions may run concurrently from several threads.
+class page_hash_cache final {
+public:
+    using hash_type = machine_merkle_tree::hash_type;
+
+    /// \brief Constructor
+    /// \param c Runtime configuration with the number of entries (0 disables the cache).
+    explicit page_hash_cache(const hasher_runtime_config &c);
+
+    /// \brief No copy constructor
+    page_hash_cache(const page_hash_cache &) = delete;
+    /// \brief No copy assignment
+    page_hash_cache &operator=(const page_hash_cache &) = delete;
+    /// \brief No move constructor
+    page_hash_cache(page_hash_cache &&) = delete;
+    /// \brief No move assignment
+    page_hash_cache &operator=(page_hash_cache &&) = delete;
+    /// \brief Default destructor
+    ~page_hash_cache() = default;
+
+    /// \brief Checks if the cache is enabled.
+    bool is_enabled(void) const {
+        return !m_entries.empty();
+    }
+
+    /// \brief Computes the fingerprint of a page.
+    /// \param page_data Pointer to start of page contents.
+    /// \returns Fingerprint to be passed to find() and insert().
+    static uint64_t get_fingerprint(const unsigned char *page_data);
+
+    /// \brief Looks up the hash of a page.
+    /// \param page_data Pointer to start of page contents.
+    /// \param fingerprint Fingerprint of page contents.
+    /// \param hash Receives the page hash on a hit.
+    /// \returns True on a hit, false on a miss.
+    bool find(const unsigned char *page_data, uint64_t fingerprint, hash_type &hash);
+
+    /// \brief Inserts the hash of a page, replacing whatever entry it maps to.
+    /// \param page_data Pointer to start of page contents.
+    /// \param fingerprint Fingerprint of page contents.
+    /// \param hash Page hash.
+    void insert(const unsigned char *page_data, uint64_t fingerprint, const hash_type &hash);
+
+    /// \brief Returns the number of lookups that hit.
+    uint64_t get_hits(void) const {
+        return m_hits.load(std::memory_order_relaxed);
+    }
+
+    /// \brief Returns the number of lookups that missed.
+    uint64_t get_misses(void) const {
+        return m_misses.load(std::memory_order_relaxed);
+    }
+
+private:
+    /// \brief Cache entry.
+    struct entry final {
+        uint64_t fingerprint{}; ///< Fingerprint of page contents
+        bool valid{};           ///< Whether entry holds a page
+        hash_type hash{};       ///< Page hash
+    };
+
+    /// \brief Returns the lock protecting an entry.
+    std::mutex &get_lock(uint64_t index) {
+        return m_locks[index % PAGE_HASH_CACHE_LOCKS];
+    }
+
+    /// \brief Returns the copy of the page held by an entry.
+    unsigned char *get_page_copy(uint64_t index) {
+        return m_pages.get() + index * machine_merkle_tree::get_page_size();
+    }
+
+    std::vector<entry> m_entries;                          ///< Entries, indexed by fingerprint
+    unique_calloc_ptr<unsigned char> m_pages;              ///< Copies of the pages held by entries
+    std::array<std::mutex, PAGE_HASH_CACHE_LOCKS> m_locks; ///< Locks protecting entries and their pages
+    std::atomic<uint64_t> m_hits{0};                       ///< Number of lookups that hit
+    std::atomic<uint64_t> m_misses{0};                     ///< Number of lookups that missed
+};
+
+} // namespace cartesi
+
+#endif
@@ -19,6 +19,7 @@
 #include <sys/stat.h> // fstat
 #include <unistd.h>   // close
 
+#include <algorithm>
 #include <cerrno>
 #include <cstring>
 #include <string>
@@ -79,36 +80,62 @@ pma_memory::pma_memory(const std::string &description, uint64_t length, const mo
 }
 
 pma_memory::pma_memory(const std::string &description, uint64_t length, const std::string &path, const callocd &c) :
-    pma_memory{description, length, c} {
-    // Try to load image file, if any
-    if (!path.empty()) {
-        auto fp = unique_fopen(path.c_str(), "rb", std::nothrow_t{});
-        if (!fp) {
-            throw std::system_error{errno, std::generic_category(),
-                "error opening image file '"s + path + "' when initializing "s + description};
-        }
-        // Get file size
-        if (fseek(fp.get(), 0, SEEK_END)) {
-            throw std::system_error{errno, std::generic_category(),
-                "error obtaining length of image file '"s + path + "' when initializing "s + description};
-        }
-        auto file_length = ftell(fp.get());
-        if (fseek(fp.get(), 0, SEEK_SET)) {
-            throw std::system_error{errno, std::generic_category(),
-                "error obtaining length of image file '"s + path + "' when initializing "s + description};
-        }
-        // Check against PMA range size
-        if (static_cast<uint64_t>(file_length) > length) {
-            throw std::runtime_error{"image file '"s + path + "' of "s + description + " is too large for range"s};
-        }
-        // Read to host memory
-        auto read = fread(m_host_memory, 1, length, fp.get());
-        (void) read;
-        if (ferror(fp.get())) {
+    m_length{length},
+    m_host_memory{nullptr},
+    m_backing_file{-1} {
+    if (path.empty()) {
+        *this = pma_memory{description, length, c};
+        return;
+    }
+
+    // Try to open image file
+    const int backing_file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (backing_file < 0) {
+        throw std::system_error{errno, std::generic_category(),
+            "error opening image file '"s + path + "' when initializing "s + description};
+    }
+
+    // Try to get file size
+    struct stat statbuf {};
+    if (fstat(backing_file, &statbuf) < 0) {
+        close(backing_file);
+        throw std::system_error{errno, std::generic_category(),
+            "error obtaining length of image file '"s + path + "' when initializing "s + description};
+    }
+
+    // Check against PMA range size
+    const auto file_length = static_cast<uint64_t>(statbuf.st_size);
+    if (file_length > length) {
+        close(backing_file);
+        throw std::runtime_error{"image file '"s + path + "' of "s + description + " is too large for range"s};
+    }
+
+    // Reserve the entire range filled with zeros, and map the image privately over its beginning.
+    // Pages are read from the image only when first accessed, and copied only when first written to,
+    // so machines loaded from the same image share the host page cache and never modify the image.
+    auto *host_memory = static_cast<unsigned char *>(
+        mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (host_memory == MAP_FAILED) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast,performance-no-int-to-ptr)
+        close(backing_file);
+        throw std::runtime_error{"error allocating memory for "s + description};
+    }
+    if (file_length > 0) {
+        // The zeros past the end of the image in its last page come from the mapping itself
+        const auto page_size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        const uint64_t image_length = std::min(length, (file_length + page_size - 1) & ~(page_size - 1));
+        auto *image_memory = mmap(host_memory, image_length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+            backing_file, 0);
+        if (image_memory == MAP_FAILED) { // NOLINT(cppcoreguidelines-pro-type-cstyle-cast,performance-no-int-to-ptr)
+            munmap(host_memory, length);
+            close(backing_file);
             throw std::system_error{errno, std::generic_category(),
-                "error reading from image file '"s + path + "' when initializing "s + description};
+                "could not map image file '"s + path + "' to memory when initializing "s + description};
         }
     }
+
+    // Finally store everything in object
+    m_host_memory = host_memory;
+    m_backing_file = backing_file;
 }
 
 pma_memory::pma_memory(const std::string &description, uint64_t length, const std::string &path, const mmapd &m) :
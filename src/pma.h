@@ -17,8 +17,11 @@
 #ifndef PMA_H
 #define PMA_H
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <stdexcept>
 #include <string>
 #include <variant>
@@ -123,6 +126,8 @@ public:
     /// \param length Length of range.
     /// \param path Path for backing file.
     /// \param c Calloc'd range data (just a tag).
+    /// \details The backing file, which can be shorter than the range, is mapped copy-on-write,
+    /// so its pages are only read when first accessed, and changes to the range never reach the file.
     pma_memory(const std::string &description, uint64_t length, const std::string &path, const callocd &c);
 
     /// \brief Constructor for calloc'd ranges.
@@ -203,7 +208,12 @@ private:
 
     pma_peek m_peek; ///< Callback for peek operations.
 
-    std::vector<uint8_t> m_dirty_page_map; ///< Map of dirty pages.
+    std::vector<uint64_t> m_dirty_page_map;       ///< Map of dirty pages, one bit per page.
+    std::vector<uint64_t> m_dirty_page_summary;   ///< One bit per word of dirty page map, set if word is not zero.
+    std::vector<uint64_t> m_store_dirty_page_map; ///< Map of pages dirtied since last store or load.
+    std::vector<uint64_t> m_rollback_page_map;    ///< Map of pages saved for rollback, empty without a snapshot.
+    std::vector<uint64_t> m_rollback_offsets;     ///< Offsets of pages saved for rollback, in the order saved.
+    std::vector<unsigned char> m_rollback_pages;  ///< Contents of pages saved for rollback, in the same order.
 
     std::variant<pma_empty, ///< Data specific to E ranges
         pma_device,         ///< Data specific to IO ranges
@@ -267,7 +277,13 @@ public:
         m_peek{peek},
         m_data{std::move(memory)} {
         // allocate dirty page map and mark all pages as dirty
-        m_dirty_page_map.resize(length / (8 * PMA_PAGE_SIZE) + 1, 0xff);
+        const uint64_t pages = get_page_count();
+        m_dirty_page_map.resize(pages / 64 + 1, 0);
+        m_dirty_page_summary.resize(m_dirty_page_map.size() / 64 + 1, 0);
+        m_store_dirty_page_map.resize(m_dirty_page_map.size(), 0);
+        for (uint64_t page_number = 0; page_number < pages; ++page_number) {
+            mark_dirty_page(page_number << PMA_constants::PMA_PAGE_SIZE_LOG2);
+        }
     }
 
     /// \brief Constructor for device entry
@@ -428,9 +444,11 @@ public:
     void mark_dirty_page(uint64_t address_in_range) {
         if (!m_dirty_page_map.empty()) {
             auto page_number = address_in_range >> PMA_constants::PMA_PAGE_SIZE_LOG2;
-            auto map_index = page_number >> 3;
+            auto map_index = page_number >> 6;
             assert(map_index < m_dirty_page_map.size());
-            m_dirty_page_map[map_index] |= (1 << (page_number & 7));
+            m_dirty_page_map[map_index] |= UINT64_C(1) << (page_number & 63);
+            m_dirty_page_summary[map_index >> 6] |= UINT64_C(1) << (map_index & 63);
+            m_store_dirty_page_map[map_index] |= UINT64_C(1) << (page_number & 63);
         }
     }
 
@@ -439,9 +457,12 @@ public:
     void mark_clean_page(uint64_t address_in_range) {
         if (!m_dirty_page_map.empty()) {
             auto page_number = address_in_range >> PMA_constants::PMA_PAGE_SIZE_LOG2;
-            auto map_index = page_number >> 3;
+            auto map_index = page_number >> 6;
             assert(map_index < m_dirty_page_map.size());
-            m_dirty_page_map[map_index] &= ~(1 << (page_number & 7));
+            m_dirty_page_map[map_index] &= ~(UINT64_C(1) << (page_number & 63));
+            if (m_dirty_page_map[map_index] == 0) {
+                m_dirty_page_summary[map_index >> 6] &= ~(UINT64_C(1) << (map_index & 63));
+            }
         }
     }
 
@@ -451,9 +472,9 @@ public:
     bool is_page_marked_dirty(uint64_t address_in_range) const {
         if (!m_dirty_page_map.empty()) {
             auto page_number = address_in_range >> PMA_constants::PMA_PAGE_SIZE_LOG2;
-            auto map_index = page_number >> 3;
+            auto map_index = page_number >> 6;
             assert(map_index < m_dirty_page_map.size());
-            return m_dirty_page_map[map_index] & (1 << (page_number & 7));
+            return (m_dirty_page_map[map_index] >> (page_number & 63)) & 1;
         } else {
             return true;
         }
@@ -461,7 +482,167 @@ public:
 
     /// \brief Marks all pages in range as clean
     void mark_pages_clean(void) {
-        return std::fill(m_dirty_page_map.begin(), m_dirty_page_map.end(), 0);
+        std::fill(m_dirty_page_map.begin(), m_dirty_page_map.end(), 0);
+        std::fill(m_dirty_page_summary.begin(), m_dirty_page_summary.end(), 0);
+    }
+
+    /// \brief Checks if a given page was marked dirty since the store generation began
+    /// \param address_in_range Any address within page in range
+    /// \returns true if dirty, false if clean
+    /// \details Unlike the dirty page map, which is cleared whenever the Merkle tree is updated, this map is only
+    /// cleared when the machine is stored or loaded, so it tells which pages may differ from the stored images.
+    bool is_page_marked_store_dirty(uint64_t address_in_range) const {
+        if (!m_store_dirty_page_map.empty()) {
+            auto page_number = address_in_range >> PMA_constants::PMA_PAGE_SIZE_LOG2;
+            auto map_index = page_number >> 6;
+            assert(map_index < m_store_dirty_page_map.size());
+            return (m_store_dirty_page_map[map_index] >> (page_number & 63)) & 1;
+        } else {
+            return true;
+        }
+    }
+
+    /// \brief Begins a new store generation, marking all pages in range as store clean
+    void mark_pages_store_clean(void) {
+        std::fill(m_store_dirty_page_map.begin(), m_store_dirty_page_map.end(), 0);
+    }
+
+    /// \brief Starts saving pages for rollback before they are first modified, discarding pages saved before
+    /// \details Only memory ranges save pages. Until this is called, saving pages for rollback does nothing.
+    void begin_saving_pages_for_rollback(void) {
+        if (std::holds_alternative<pma_memory>(m_data)) {
+            m_rollback_page_map.assign(m_dirty_page_map.size(), 0);
+        }
+        m_rollback_offsets.clear();
+        m_rollback_pages.clear();
+    }
+
+    /// \brief Stops saving pages for rollback, discarding pages saved so far
+    void end_saving_pages_for_rollback(void) {
+        m_rollback_page_map = {};
+        m_rollback_offsets = {};
+        m_rollback_pages = {};
+    }
+
+    /// \brief Saves the contents of a page, if it was not saved since pages started being saved for rollback
+    /// \param address_in_range Any address within page in range
+    /// \details Must be called before the page is modified.
+    void save_page_for_rollback(uint64_t address_in_range) {
+        if (!m_rollback_page_map.empty()) {
+            auto page_number = address_in_range >> PMA_constants::PMA_PAGE_SIZE_LOG2;
+            auto map_index = page_number >> 6;
+            assert(map_index < m_rollback_page_map.size());
+            const uint64_t bit = UINT64_C(1) << (page_number & 63);
+            if ((m_rollback_page_map[map_index] & bit) == 0) {
+                m_rollback_page_map[map_index] |= bit;
+                const uint64_t page_offset = page_number << PMA_constants::PMA_PAGE_SIZE_LOG2;
+                const unsigned char *page = get_memory().get_host_memory() + page_offset;
+                m_rollback_offsets.push_back(page_offset);
+                m_rollback_pages.insert(m_rollback_pages.end(), page, page + PMA_constants::PMA_PAGE_SIZE);
+            }
+        }
+    }
+
+    /// \brief Restores the pages saved for rollback and stops saving pages
+    /// \details Restored pages are marked dirty, so their hashes are updated with the Merkle tree.
+    void restore_pages_saved_for_rollback(void) {
+        for (size_t i = 0; i < m_rollback_offsets.size(); ++i) {
+            memcpy(get_memory().get_host_memory() + m_rollback_offsets[i],
+                m_rollback_pages.data() + i * PMA_constants::PMA_PAGE_SIZE, PMA_constants::PMA_PAGE_SIZE);
+            mark_dirty_page(m_rollback_offsets[i]);
+        }
+        end_saving_pages_for_rollback();
+    }
+
+    /// \brief Returns number of pages in range
+    uint64_t get_page_count(void) const {
+        return (m_length + PMA_constants::PMA_PAGE_SIZE - 1) >> PMA_constants::PMA_PAGE_SIZE_LOG2;
+    }
+
+    /// \brief Iterator over the dirty pages in range, in increasing order
+    /// \details Dereferencing gives the start of a dirty page relative to the start of the range.
+    /// Skipping over clean pages takes time proportional to the number of 64-bit words in the summary of the
+    /// dirty page map, i.e., one word per 4096 pages. In ranges without a dirty page map, all pages are dirty.
+    class dirty_page_iterator final {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = uint64_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const uint64_t *;
+        using reference = uint64_t;
+
+        /// \brief Constructor
+        /// \param pma PMA entry whose dirty pages are visited.
+        /// \param page_number First page number that may be visited.
+        dirty_page_iterator(const pma_entry &pma, uint64_t page_number) : m_pma{&pma}, m_page_number{page_number} {
+            seek();
+        }
+
+        /// \brief Returns start of current dirty page relative to start of range
+        uint64_t operator*() const {
+            return m_page_number << PMA_constants::PMA_PAGE_SIZE_LOG2;
+        }
+
+        /// \brief Advances to next dirty page
+        dirty_page_iterator &operator++() {
+            ++m_page_number;
+            seek();
+            return *this;
+        }
+
+        bool operator==(const dirty_page_iterator &other) const {
+            return m_page_number == other.m_page_number;
+        }
+
+        bool operator!=(const dirty_page_iterator &other) const {
+            return !(*this == other);
+        }
+
+    private:
+        /// \brief Moves to first dirty page at or after current page, or to end of range
+        void seek(void) {
+            const uint64_t pages = m_pma->get_page_count();
+            const auto &map = m_pma->m_dirty_page_map;
+            const auto &summary = m_pma->m_dirty_page_summary;
+            if (m_page_number >= pages || map.empty()) {
+                m_page_number = std::min(m_page_number, pages);
+                return;
+            }
+            // Look for remaining dirty pages in the word of the current page
+            uint64_t map_index = m_page_number >> 6;
+            const uint64_t bits = map[map_index] & (~UINT64_C(0) << (m_page_number & 63));
+            if (bits != 0) {
+                m_page_number = (map_index << 6) + static_cast<uint64_t>(__builtin_ctzll(bits));
+                return;
+            }
+            // Otherwise, use the summary to find the next word with dirty pages
+            ++map_index;
+            for (uint64_t summary_index = map_index >> 6; summary_index < summary.size(); ++summary_index) {
+                uint64_t summary_bits = summary[summary_index];
+                if (summary_index == (map_index >> 6)) {
+                    summary_bits &= ~UINT64_C(0) << (map_index & 63);
+                }
+                if (summary_bits != 0) {
+                    map_index = (summary_index << 6) + static_cast<uint64_t>(__builtin_ctzll(summary_bits));
+                    m_page_number = (map_index << 6) + static_cast<uint64_t>(__builtin_ctzll(map[map_index]));
+                    return;
+                }
+            }
+            m_page_number = pages;
+        }
+
+        const pma_entry *m_pma;  ///< PMA entry whose dirty pages are visited
+        uint64_t m_page_number; ///< Current dirty page number, or number of pages in range at end
+    };
+
+    /// \brief Returns iterator to first dirty page in range
+    dirty_page_iterator begin_dirty_pages(void) const {
+        return dirty_page_iterator{*this, 0};
+    }
+
+    /// \brief Returns iterator past last dirty page in range
+    dirty_page_iterator end_dirty_pages(void) const {
+        return dirty_page_iterator{*this, get_page_count()};
     }
 
     /// \brief Returns PMA description as a string
@@ -495,6 +676,8 @@ pma_entry make_callocd_memory_pma_entry(const std::string &description, uint64_t
 /// \param length Length of PMA range.
 /// \param path Path to backing file.
 /// \returns Corresponding PMA entry
+/// \details The backing file must not be modified while the range is in use,
+/// since pages not yet accessed are read from it on demand.
 pma_entry make_callocd_memory_pma_entry(const std::string &description, uint64_t start, uint64_t length,
     const std::string &path);
 
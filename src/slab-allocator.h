@@ -0,0 +1,91 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef SLAB_ALLOCATOR_H
+#define SLAB_ALLOCATOR_H
+
+/// \file
+/// \brief Slab allocator.
+/// \details Allocates objects of a single type from large slabs, instead of one heap allocation per object.
+/// Objects that are allocated together end up next to each other in memory, allocation is mostly a pointer
+/// increment, and releasing all objects at once frees only the slabs.
+/// Slabs come from calloc, so the host only commits their pages as objects are allocated.
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "unique-c-ptr.h"
+
+namespace cartesi {
+
+/// \class slab_allocator
+/// \brief Allocator for trivial objects of type T, SLAB_SIZE objects per slab.
+template <typename T, size_t SLAB_SIZE = 4096>
+class slab_allocator final {
+    static_assert(std::is_trivial_v<T>, "slab allocator only supports trivial types");
+
+public:
+    /// \brief Default constructor
+    slab_allocator(void) = default;
+
+    /// \brief No copy constructor
+    slab_allocator(const slab_allocator &) = delete;
+    /// \brief No copy assignment
+    slab_allocator &operator=(const slab_allocator &) = delete;
+    /// \brief No move constructor
+    slab_allocator(slab_allocator &&) = delete;
+    /// \brief No move assignment
+    slab_allocator &operator=(slab_allocator &&) = delete;
+    /// \brief Default destructor frees all slabs
+    ~slab_allocator() = default;
+
+    /// \brief Allocates a value-initialized object.
+    /// \returns Pointer to object, or nullptr if out of memory.
+    T *allocate(void) {
+        if (m_slabs.empty() || m_used == SLAB_SIZE) {
+            auto slab = unique_calloc<T>(SLAB_SIZE, std::nothrow_t{});
+            if (!slab) {
+                return nullptr;
+            }
+            m_slabs.push_back(std::move(slab));
+            m_used = 0;
+        }
+        // Fresh objects come zeroed from calloc
+        return m_slabs.back().get() + m_used++;
+    }
+
+    /// \brief Releases all objects at once.
+    void clear(void) {
+        m_slabs.clear();
+        m_used = 0;
+    }
+
+    /// \brief Returns the number of bytes held in slabs.
+    size_t get_footprint(void) const {
+        return m_slabs.size() * SLAB_SIZE * sizeof(T);
+    }
+
+private:
+    std::vector<unique_calloc_ptr<T>> m_slabs; ///< Slabs, the last of which may be partially used
+    size_t m_used{0};                          ///< Number of objects allocated from the last slab
+};
+
+} // namespace cartesi
+
+#endif
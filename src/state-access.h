@@ -565,10 +565,19 @@ private:
         const uint64_t vaddr_page = vaddr & ~PAGE_OFFSET_MASK;
         const uint64_t paddr_page = paddr & ~PAGE_OFFSET_MASK;
         unsigned char *hpage = pma.get_memory_noexcept().get_host_memory() + (paddr_page - pma.get_start());
+        // Pages written through the TLB are modified without notice, so save them in case of a rollback now
+        if constexpr (ETYPE == TLB_WRITE) {
+            pma.save_page_for_rollback(paddr_page - pma.get_start());
+        }
         tlbhe.vaddr_page = vaddr_page;
         tlbhe.vh_offset = cast_ptr_to_addr<uint64_t>(hpage) - vaddr_page;
         tlbce.paddr_page = paddr_page;
         tlbce.pma_index = static_cast<uint64_t>(pma.get_index());
+        m_m.get_host_tlb().mark_shadow_entry(ETYPE, eidx);
+        // Make sure no decoded instruction survives in a page that can now be written through the TLB
+        if constexpr (ETYPE == TLB_WRITE) {
+            m_m.get_decode_cache().replace_write_tlb_entry(eidx, paddr_page);
+        }
         return hpage;
     }
 
@@ -582,6 +591,7 @@ private:
                 const tlb_cold_entry &tlbce = m_m.get_state().tlb.cold[ETYPE][eidx];
                 pma_entry &pma = do_get_pma_entry(static_cast<int>(tlbce.pma_index));
                 pma.mark_dirty_page(tlbce.paddr_page - pma.get_start());
+                m_m.get_decode_cache().flush_write_tlb_entry(eidx);
             } else {
                 tlbhe.vaddr_page = TLB_INVALID_PAGE;
             }
@@ -592,9 +602,8 @@ private:
 
     template <TLB_entry_type ETYPE>
     void do_flush_tlb_type() {
-        for (uint64_t i = 0; i < PMA_TLB_SIZE; ++i) {
-            do_flush_tlb_entry<ETYPE>(i);
-        }
+        // Entries that were not replaced since they were last flushed are already invalid
+        m_m.get_host_tlb().flush_shadow_entries(ETYPE, [this](uint64_t eidx) { do_flush_tlb_entry<ETYPE>(eidx); });
     }
 
     void do_flush_tlb_vaddr(uint64_t vaddr) {
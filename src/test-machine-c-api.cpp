@@ -10,6 +10,7 @@
 #include <boost/test/included/unit_test.hpp>
 #pragma GCC diagnostic pop
 
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <filesystem>
@@ -21,6 +22,8 @@
 #include <tuple>
 #include <vector>
 
+#include <sys/stat.h>
+
 #include <nlohmann/json.hpp>
 
 #include "grpc-machine-c-api.h"
@@ -190,6 +193,15 @@ static char *new_cstr(const char *str) {
     return copy;
 }
 
+/// \brief Returns a page filled with a pattern that is not pristine and differs for each step
+static std::array<unsigned char, 4096> make_test_page(unsigned step, unsigned first) {
+    std::array<unsigned char, 4096> page{};
+    for (size_t i = 0; i < page.size(); ++i) {
+        page[i] = static_cast<unsigned char>(i * step + first);
+    }
+    return page;
+}
+
 // NOLINTNEXTLINE(cppcoreguidelines-special-member-functions)
 class incomplete_machine_fixture : public default_machine_fixture {
 public:
@@ -312,6 +324,123 @@ BOOST_FIXTURE_TEST_CASE_NOLINT(create_machine_null_machine_test, machine_rom_fix
     cm_delete_cstring(err_msg);
 }
 
+BOOST_FIXTURE_TEST_CASE_NOLINT(create_machine_invalid_tlb_sets_test, machine_rom_fixture) {
+    _runtime_config.tlb.sets = 100;
+    char *err_msg{};
+    int error_code = cm_create_machine(&_machine_config, &_runtime_config, &_machine, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+
+    std::string result = err_msg;
+    std::string origin("number of TLB sets must be a power of 2 no greater than 65536");
+    BOOST_CHECK_EQUAL(origin, result);
+
+    cm_delete_cstring(err_msg);
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(create_machine_invalid_tlb_ways_test, machine_rom_fixture) {
+    _runtime_config.tlb.ways = 32;
+    char *err_msg{};
+    int error_code = cm_create_machine(&_machine_config, &_runtime_config, &_machine, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+
+    std::string result = err_msg;
+    std::string origin("number of TLB ways must be a power of 2 no greater than 16");
+    BOOST_CHECK_EQUAL(origin, result);
+
+    cm_delete_cstring(err_msg);
+}
+
+BOOST_AUTO_TEST_CASE_NOLINT(set_hasher_backend_invalid_test) {
+    char *err_msg{};
+    int error_code = cm_set_hasher_backend(static_cast<CM_HASHER_BACKEND>(CM_HASHER_BACKEND_AVX2 + 1), &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+
+    std::string result = err_msg;
+    std::string origin("invalid hasher backend");
+    BOOST_CHECK_EQUAL(origin, result);
+
+    cm_delete_cstring(err_msg);
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(set_hasher_backend_root_hash_test, machine_rom_fixture) {
+    // All hasher backends must produce the same root hash
+    std::vector<std::array<uint8_t, sizeof(cm_hash)>> hashes;
+    for (auto backend : {CM_HASHER_BACKEND_GENERIC, CM_HASHER_BACKEND_SIMD}) {
+        char *err_msg{};
+        int error_code = cm_set_hasher_backend(backend, &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+        error_code = cm_create_machine(&_machine_config, &_runtime_config, &_machine, &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+        cm_hash hash{};
+        error_code = cm_get_root_hash(_machine, &hash, &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+        hashes.emplace_back();
+        std::copy(std::begin(hash), std::end(hash), hashes.back().begin());
+        cm_delete_machine(_machine);
+        _machine = nullptr;
+    }
+    BOOST_CHECK_EQUAL_COLLECTIONS(hashes[0].begin(), hashes[0].end(), hashes[1].begin(), hashes[1].end());
+    BOOST_CHECK_EQUAL(cm_set_hasher_backend(CM_HASHER_BACKEND_AUTO, nullptr), CM_ERROR_OK);
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(create_machine_invalid_page_hash_cache_test, machine_rom_fixture) {
+    _runtime_config.hasher.page_cache_entries = 1000;
+    char *err_msg{};
+    int error_code = cm_create_machine(&_machine_config, &_runtime_config, &_machine, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+
+    std::string result = err_msg;
+    std::string origin("number of page hash cache entries must be a power of 2 no greater than 1048576");
+    BOOST_CHECK_EQUAL(origin, result);
+
+    cm_delete_cstring(err_msg);
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(create_machine_page_hash_cache_root_hash_test, machine_rom_fixture) {
+    // Identical pages hashed through the cache must produce the same root hash as without it
+    std::vector<std::array<uint8_t, sizeof(cm_hash)>> hashes;
+    const auto page = make_test_page(7, 1);
+    for (uint64_t entries : {0, 16}) {
+        _runtime_config.hasher.page_cache_entries = entries;
+        char *err_msg{};
+        int error_code = cm_create_machine(&_machine_config, &_runtime_config, &_machine, &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+        for (uint64_t i = 0; i < 8; ++i) {
+            error_code = cm_write_memory(_machine, 0x80000000 + i * 2 * page.size(), page.data(), page.size(),
+                &err_msg);
+            BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+            BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+        }
+        cm_hash hash{};
+        error_code = cm_get_root_hash(_machine, &hash, &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+        hashes.emplace_back();
+        std::copy(std::begin(hash), std::end(hash), hashes.back().begin());
+        // The first copy of the page misses and is inserted, so the copies that follow hit
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        error_code = cm_get_page_hash_cache_stats(_machine, &hits, &misses, &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+        if (entries == 0) {
+            BOOST_CHECK_EQUAL(hits, 0);
+            BOOST_CHECK_EQUAL(misses, 0);
+        } else {
+            BOOST_CHECK_GE(hits, 7);
+            BOOST_CHECK_GT(misses, 0);
+        }
+        cm_delete_machine(_machine);
+        _machine = nullptr;
+    }
+    _runtime_config.hasher.page_cache_entries = 0;
+    BOOST_CHECK_EQUAL_COLLECTIONS(hashes[0].begin(), hashes[0].end(), hashes[1].begin(), hashes[1].end());
+}
+
 BOOST_FIXTURE_TEST_CASE_NOLINT(create_machine_unknown_rom_file_test, incomplete_machine_fixture) {
     _set_rom_image("/unknown/file.bin");
     char *err_msg{};
@@ -427,6 +556,16 @@ public:
 
 protected:
     std::string _machine_dir_path;
+
+    /// \brief Replaces the machine with a new one, created with the current runtime configuration
+    void recreate_machine(void) {
+        cm_delete_machine(_machine);
+        _machine = nullptr;
+        char *err_msg{};
+        const int error_code = cm_create_machine(&_machine_config, &_runtime_config, &_machine, &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    }
 };
 
 bool operator==(const cm_processor_config &lhs, const cm_processor_config &rhs) {
@@ -644,6 +783,85 @@ BOOST_FIXTURE_TEST_CASE_NOLINT(load_machine_null_error_placeholder_test, ordinar
     cm_delete_machine(restored_machine);
 }
 
+/// \brief Checks that two machines have the same root hash
+static void check_same_root_hash(cm_machine *machine, cm_machine *other_machine) {
+    char *err_msg{};
+    cm_hash hash{};
+    int error_code = cm_get_root_hash(machine, &hash, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    cm_hash other_hash{};
+    error_code = cm_get_root_hash(other_machine, &other_hash, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    BOOST_CHECK_EQUAL(0, memcmp(hash, other_hash, sizeof(cm_hash)));
+}
+
+/// \brief Loads a stored machine and checks that it has the same root hash as the machine it was stored from
+/// \returns Loaded machine, to be deleted by the caller
+static cm_machine *load_and_compare(cm_machine *machine, const std::string &dir_path,
+    const cm_machine_runtime_config &runtime_config) {
+    char *err_msg{};
+    cm_machine *restored_machine{};
+    const int error_code = cm_load_machine(dir_path.c_str(), &runtime_config, &restored_machine, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    check_same_root_hash(machine, restored_machine);
+    return restored_machine;
+}
+
+/// \brief Stores a machine, loads it back and checks that both have the same root hash
+/// \returns Loaded machine, to be deleted by the caller
+static cm_machine *store_load_and_compare(cm_machine *machine, const std::string &dir_path,
+    const cm_machine_runtime_config &runtime_config) {
+    char *err_msg{};
+    const int error_code = cm_store(machine, dir_path.c_str(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    return load_and_compare(machine, dir_path, runtime_config);
+}
+
+/// \brief Writes a page to machine memory
+static void write_page(cm_machine *machine, uint64_t address, const std::array<unsigned char, 4096> &page) {
+    char *err_msg{};
+    const int error_code = cm_write_memory(machine, address, page.data(), page.size(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+}
+
+/// \brief Checks that a page of machine memory holds the expected data
+static void check_page(cm_machine *machine, uint64_t address, const std::array<unsigned char, 4096> &page) {
+    char *err_msg{};
+    std::array<unsigned char, 4096> read_page{};
+    const int error_code = cm_read_memory(machine, address, read_page.data(), read_page.size(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    BOOST_CHECK(page == read_page);
+}
+
+/// \brief Checks that loading a stored machine fails with a runtime error
+static void check_load_fails(const std::string &dir_path, const cm_machine_runtime_config &runtime_config,
+    const std::string &expected_err_msg) {
+    char *err_msg{};
+    cm_machine *restored_machine{};
+    const int error_code = cm_load_machine(dir_path.c_str(), &runtime_config, &restored_machine, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_RUNTIME_ERROR);
+    BOOST_REQUIRE_NE(err_msg, nullptr);
+    BOOST_CHECK_EQUAL(std::string{err_msg}, expected_err_msg);
+    cm_delete_cstring(err_msg);
+    cm_delete_machine(restored_machine);
+}
+
+/// \brief Overwrites bytes of a stored file, keeping its modification time
+static void overwrite_bytes(const std::string &name, std::streamoff offset, const std::string &bytes) {
+    const auto mtime = std::filesystem::last_write_time(name);
+    std::fstream f(name, std::ios::in | std::ios::out | std::ios::binary);
+    f.seekp(offset, offset < 0 ? std::ios::end : std::ios::beg);
+    f.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    f.close();
+    std::filesystem::last_write_time(name, mtime);
+}
+
 BOOST_FIXTURE_TEST_CASE_NOLINT(serde_complex_test, ordinary_machine_fixture) {
     char *err_msg{};
     int error_code = cm_store(_machine, _machine_dir_path.c_str(), &err_msg);
@@ -668,6 +886,196 @@ BOOST_FIXTURE_TEST_CASE_NOLINT(serde_complex_test, ordinary_machine_fixture) {
     cm_delete_machine(restored_machine);
 }
 
+BOOST_FIXTURE_TEST_CASE_NOLINT(serde_merkle_cache_test, ordinary_machine_fixture) {
+    // Page hashes stored in the Merkle cache must restore the same root hash, before and after changes
+    _runtime_config.merkle_cache = true;
+    recreate_machine();
+    const auto page = make_test_page(7, 1);
+    write_page(_machine, 0x80000000, page);
+    cm_machine *restored_machine = store_load_and_compare(_machine, _machine_dir_path, _runtime_config);
+    BOOST_CHECK(std::filesystem::exists(_machine_dir_path + "/merkle-cache"));
+    for (auto *m : {_machine, restored_machine}) {
+        write_page(m, 0x80000000 + 3 * page.size(), page);
+    }
+    check_same_root_hash(_machine, restored_machine);
+    cm_delete_machine(restored_machine);
+
+    // A cache whose hashes do not match memory no longer matches the stored root hash, showing the cache is used
+    const std::string cache_name = _machine_dir_path + "/merkle-cache";
+    std::ifstream cache_stream(cache_name, std::ios::binary);
+    cache_stream.seekg(-1, std::ios::end);
+    const auto last_cache_byte = static_cast<char>(cache_stream.get());
+    cache_stream.close();
+    overwrite_bytes(cache_name, -1, std::string(1, static_cast<char>(~last_cache_byte)));
+    check_load_fails(_machine_dir_path, _runtime_config, "stored and restored hashes do not match");
+
+    // A malformed cache is ignored, and pages are hashed as usual
+    std::filesystem::resize_file(cache_name, std::filesystem::file_size(cache_name) - 1);
+    char *err_msg{};
+    const int error_code = cm_load_machine(_machine_dir_path.c_str(), &_runtime_config, &restored_machine, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    write_page(restored_machine, 0x80000000 + 3 * page.size(), page);
+    check_same_root_hash(_machine, restored_machine);
+    cm_delete_machine(restored_machine);
+
+    _runtime_config.merkle_cache = false;
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(serde_direct_io_test, ordinary_machine_fixture) {
+    // Memory stored with direct I/O, including pristine pages left as holes, must restore the same root hash
+    _runtime_config.store_direct_io = true;
+    recreate_machine();
+    const auto page = make_test_page(13, 5);
+    for (uint64_t offset : {UINT64_C(0), UINT64_C(5) * page.size(), UINT64_C(6) * page.size()}) {
+        write_page(_machine, 0x80000000 + offset, page);
+    }
+    cm_machine *restored_machine = store_load_and_compare(_machine, _machine_dir_path, _runtime_config);
+    check_page(restored_machine, 0x80000000 + 5 * page.size(), page);
+    cm_delete_machine(restored_machine);
+
+    // Only the pages that are not pristine take up space in the image
+    struct stat statbuf {};
+    BOOST_REQUIRE_EQUAL(stat((_machine_dir_path + "/0000000080000000-100000.bin").c_str(), &statbuf), 0);
+    BOOST_CHECK_EQUAL(statbuf.st_size, 0x100000);
+    BOOST_CHECK_LT(statbuf.st_blocks * 512, statbuf.st_size);
+
+    _runtime_config.store_direct_io = false;
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(serde_compressed_test, ordinary_machine_fixture) {
+    // Memory stored compressed, with chunks that compress, that do not, and that are pristine, must restore the same
+    // root hash
+    _runtime_config.store_compressed = true;
+    recreate_machine();
+    std::array<unsigned char, 4096> compressible_page{};
+    std::array<unsigned char, 4096> incompressible_page{};
+    uint64_t state = 1;
+    for (size_t i = 0; i < compressible_page.size(); ++i) {
+        compressible_page[i] = static_cast<unsigned char>(i % 7);
+        state = state * 6364136223846793005 + 1442695040888963407;
+        incompressible_page[i] = static_cast<unsigned char>(state >> 56);
+    }
+    const uint64_t compressible_address = 0x80000000;
+    const uint64_t incompressible_address = 0x80000000 + 40 * compressible_page.size();
+    write_page(_machine, compressible_address, compressible_page);
+    write_page(_machine, incompressible_address, incompressible_page);
+    cm_machine *restored_machine = store_load_and_compare(_machine, _machine_dir_path, _runtime_config);
+    check_page(restored_machine, compressible_address, compressible_page);
+    check_page(restored_machine, incompressible_address, incompressible_page);
+    cm_delete_machine(restored_machine);
+
+    // The image is replaced by a compressed one that is smaller than the two pages that are not pristine
+    const std::string image_name = _machine_dir_path + "/0000000080000000-100000.cbin";
+    BOOST_CHECK(!std::filesystem::exists(_machine_dir_path + "/0000000080000000-100000.bin"));
+    BOOST_REQUIRE(std::filesystem::exists(image_name));
+    const auto image_size = std::filesystem::file_size(image_name);
+    BOOST_CHECK_LT(image_size, 2 * compressible_page.size());
+
+    // Corrupt compressed images must be rejected
+    std::ifstream image_stream(image_name, std::ios::binary);
+    std::array<char, 16> first_chunk{};
+    image_stream.seekg(40); // Record of first chunk, which holds the compressible page, follows the header
+    image_stream.read(first_chunk.data(), first_chunk.size());
+    image_stream.close();
+    uint64_t first_chunk_offset = 0;
+    memcpy(&first_chunk_offset, first_chunk.data(), sizeof(first_chunk_offset));
+    const std::string invalid_err_msg = "invalid compressed image file '" + image_name + "'";
+    overwrite_bytes(image_name, static_cast<std::streamoff>(first_chunk_offset), std::string(16, '\xff'));
+    check_load_fails(_machine_dir_path, _runtime_config, invalid_err_msg);
+    std::filesystem::resize_file(image_name, image_size - 1);
+    check_load_fails(_machine_dir_path, _runtime_config, invalid_err_msg);
+
+    _runtime_config.store_compressed = false;
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(serde_delta_test, ordinary_machine_fixture) {
+    // A delta store layered over its base must restore the same root hash
+    const std::string delta_dir_path = _machine_dir_path + "-delta";
+    char *err_msg{};
+    int error_code = cm_store_delta(_machine, delta_dir_path.c_str(), _machine_dir_path.c_str(), &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_RUNTIME_ERROR);
+    cm_delete_cstring(err_msg);
+    err_msg = nullptr;
+    error_code = cm_store(_machine, _machine_dir_path.c_str(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    const auto page = make_test_page(11, 3);
+    write_page(_machine, 0x80000000 + 2 * page.size(), page);
+    error_code = cm_store_delta(_machine, delta_dir_path.c_str(), _machine_dir_path.c_str(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+
+    // The delta holds only the page that changed, instead of an image of the whole range
+    const std::string delta_name = delta_dir_path + "/0000000080000000-100000.delta";
+    BOOST_CHECK(!std::filesystem::exists(delta_dir_path + "/0000000080000000-100000.bin"));
+    BOOST_REQUIRE(std::filesystem::exists(delta_name));
+    BOOST_CHECK_GT(std::filesystem::file_size(delta_name), page.size());
+    BOOST_CHECK_LT(std::filesystem::file_size(delta_name), 2 * page.size());
+
+    // The base of the next delta must be the delta just stored
+    const std::string other_dir_path = _machine_dir_path + "-other";
+    error_code = cm_store_delta(_machine, other_dir_path.c_str(), _machine_dir_path.c_str(), &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+    cm_delete_cstring(err_msg);
+    err_msg = nullptr;
+
+    cm_machine *restored_machine = load_and_compare(_machine, delta_dir_path, _runtime_config);
+    check_page(restored_machine, 0x80000000 + 2 * page.size(), page);
+    cm_delete_machine(restored_machine);
+    std::filesystem::remove_all(delta_dir_path);
+    std::filesystem::remove_all(other_dir_path);
+}
+
+/// \brief Reads the whole contents of a file
+static std::vector<char> read_file_contents(const std::string &name) {
+    std::ifstream f(name, std::ios::binary);
+    BOOST_REQUIRE(f.good());
+    return std::vector<char>{std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>()};
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(load_image_copy_on_write_test, ordinary_machine_fixture) {
+    // Images are mapped copy-on-write, so changes to a loaded machine must not reach the stored images
+    const auto page = make_test_page(7, 1);
+    write_page(_machine, 0x80000000, page);
+    write_page(_machine, 0x80000000 + page.size(), page);
+    char *err_msg{};
+    const int error_code = cm_store(_machine, _machine_dir_path.c_str(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    const std::string ram_image_name = _machine_dir_path + "/0000000080000000-100000.bin";
+    const auto ram_image = read_file_contents(ram_image_name);
+
+    std::array<unsigned char, 4096> other_page{};
+    other_page.fill(0xa5);
+    for (auto prefault : {CM_IMAGE_PREFAULT_NONE, CM_IMAGE_PREFAULT_WILLNEED, CM_IMAGE_PREFAULT_POPULATE}) {
+        cm_machine_runtime_config runtime_config = _runtime_config;
+        runtime_config.image_prefault = prefault;
+        cm_machine *restored_machine = load_and_compare(_machine, _machine_dir_path, runtime_config);
+        write_page(restored_machine, 0x80000000, other_page);
+        write_page(restored_machine, 0x80000000 + 3 * other_page.size(), other_page);
+        cm_delete_machine(restored_machine);
+        BOOST_CHECK(read_file_contents(ram_image_name) == ram_image);
+    }
+
+    // An image shorter than its range, ending in the middle of a page, must read as zeros past its end
+    const uint64_t short_length = page.size() + 100;
+    std::filesystem::resize_file(ram_image_name, short_length);
+    std::array<unsigned char, 4096> short_page = page;
+    std::fill(short_page.begin() + static_cast<std::ptrdiff_t>(short_length - page.size()), short_page.end(), 0);
+    write_page(_machine, 0x80000000 + page.size(), short_page);
+    for (auto prefault : {CM_IMAGE_PREFAULT_NONE, CM_IMAGE_PREFAULT_WILLNEED, CM_IMAGE_PREFAULT_POPULATE}) {
+        cm_machine_runtime_config runtime_config = _runtime_config;
+        runtime_config.image_prefault = prefault;
+        runtime_config.skip_root_hash_check = true;
+        cm_machine *restored_machine = load_and_compare(_machine, _machine_dir_path, runtime_config);
+        check_page(restored_machine, 0x80000000, page);
+        check_page(restored_machine, 0x80000000 + page.size(), short_page);
+        check_page(restored_machine, 0x80000000 + 2 * page.size(), std::array<unsigned char, 4096>{});
+        cm_delete_machine(restored_machine);
+    }
+}
+
 BOOST_AUTO_TEST_CASE_NOLINT(get_root_hash_null_machine_test) {
     cm_hash restored_hash;
     int error_code = cm_get_root_hash(nullptr, &restored_hash, nullptr);
@@ -795,6 +1203,52 @@ BOOST_FIXTURE_TEST_CASE_NOLINT(get_proof_machine_hash_test, ordinary_machine_fix
     cm_delete_merkle_tree_proof(p);
 }
 
+BOOST_FIXTURE_TEST_CASE_NOLINT(get_proofs_empty_targets_test, ordinary_machine_fixture) {
+    char *err_msg{};
+    cm_merkle_tree_multiproof *mp{};
+    int error_code = cm_get_proofs(_machine, nullptr, 0, &mp, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+
+    std::string result = err_msg;
+    std::string origin("no proof targets");
+    BOOST_CHECK_EQUAL(origin, result);
+
+    cm_delete_cstring(err_msg);
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(get_proofs_machine_hash_test, ordinary_machine_fixture) {
+    char *err_msg{};
+    const std::array<cm_merkle_tree_target, 3> targets{{{0, 12}, {0x1000, 12}, {0x80000000, 12}}};
+
+    cm_merkle_tree_multiproof *mp{};
+    int error_code = cm_get_proofs(_machine, targets.data(), targets.size(), &mp, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK_EQUAL(err_msg, nullptr);
+    BOOST_REQUIRE_EQUAL(mp->targets.count, targets.size());
+    BOOST_CHECK_EQUAL(mp->log2_root_size, static_cast<size_t>(64));
+
+    // Each target matches the hash reported by an individual proof
+    size_t sibling_count = 0;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        cm_merkle_tree_proof *p{};
+        error_code = cm_get_proof(_machine, targets[i].address, targets[i].log2_size, &p, &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        BOOST_CHECK_EQUAL(mp->targets.entry[i].address, targets[i].address);
+        BOOST_CHECK_EQUAL(mp->targets.entry[i].log2_size, targets[i].log2_size);
+        BOOST_CHECK_EQUAL_COLLECTIONS(mp->targets.entry[i].hash, mp->targets.entry[i].hash + sizeof(cm_hash),
+            p->target_hash, p->target_hash + sizeof(cm_hash));
+        BOOST_CHECK_EQUAL_COLLECTIONS(mp->root_hash, mp->root_hash + sizeof(cm_hash), p->root_hash,
+            p->root_hash + sizeof(cm_hash));
+        sibling_count += p->sibling_hashes.count;
+        cm_delete_merkle_tree_proof(p);
+    }
+
+    // Shared siblings are listed only once, and adjacent targets prove each other
+    BOOST_CHECK_LT(mp->siblings.count, sibling_count);
+
+    cm_delete_merkle_tree_multiproof(mp);
+}
+
 BOOST_AUTO_TEST_CASE_NOLINT(read_word_null_machine_test) {
     uint64_t word_value = 0;
     int error_code = cm_read_word(nullptr, 0x100, &word_value, nullptr);
@@ -1461,6 +1915,22 @@ BOOST_FIXTURE_TEST_CASE_NOLINT(verify_dirty_page_maps_success_test, ordinary_mac
     BOOST_CHECK(result);
 }
 
+BOOST_AUTO_TEST_CASE_NOLINT(get_page_hash_cache_stats_null_machine_test) {
+    uint64_t hits{};
+    uint64_t misses{};
+    int error_code = cm_get_page_hash_cache_stats(nullptr, &hits, &misses, nullptr);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+}
+
+BOOST_FIXTURE_TEST_CASE_NOLINT(get_page_hash_cache_stats_null_output_test, ordinary_machine_fixture) {
+    uint64_t hits{};
+    uint64_t misses{};
+    int error_code = cm_get_page_hash_cache_stats(_machine, &hits, nullptr, nullptr);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+    error_code = cm_get_page_hash_cache_stats(_machine, nullptr, &misses, nullptr);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
+}
+
 BOOST_FIXTURE_TEST_CASE_NOLINT(replace_memory_range_null_flash_config_test, ordinary_machine_fixture) {
     char *err_msg{};
     int error_code = cm_replace_memory_range(_machine, nullptr, &err_msg);
@@ -1646,6 +2116,39 @@ BOOST_FIXTURE_TEST_CASE_NOLINT(replace_memory_range_basic_test, flash_drive_mach
     BOOST_CHECK_EQUAL(_flash_data, read_string);
 }
 
+BOOST_FIXTURE_TEST_CASE_NOLINT(replace_memory_range_rollback_test, flash_drive_machine_fixture) {
+    char *err_msg{};
+    cm_hash snapshot_hash{};
+    int error_code = cm_get_root_hash(_machine, &snapshot_hash, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    error_code = cm_snapshot(_machine, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+
+    // Replace the range twice, so the second replacement starts from the first one
+    for (int i = 0; i < 2; ++i) {
+        error_code = cm_replace_memory_range(_machine, &_flash_config, &err_msg);
+        BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+        BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    }
+    // The replacement must still be a writable memory range
+    std::array<uint8_t, 4> data{1, 2, 3, 4};
+    error_code = cm_write_memory(_machine, _flash_config.start + 0x1000, data.data(), data.size(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+
+    error_code = cm_rollback(_machine, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    // The original flash drive image starts with "aaaa"
+    std::array<uint8_t, 4> read_data{};
+    error_code = cm_read_memory(_machine, _flash_config.start, read_data.data(), read_data.size(), &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK(std::all_of(read_data.begin(), read_data.end(), [](uint8_t b) { return b == 'a'; }));
+    cm_hash restored_hash{};
+    error_code = cm_get_root_hash(_machine, &restored_hash, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK_EQUAL(0, memcmp(snapshot_hash, restored_hash, sizeof(cm_hash)));
+}
+
 BOOST_AUTO_TEST_CASE_NOLINT(destroy_null_machine_test) {
     int error_code = cm_destroy(nullptr, nullptr);
     BOOST_CHECK_EQUAL(error_code, CM_ERROR_INVALID_ARGUMENT);
@@ -1666,11 +2169,8 @@ BOOST_AUTO_TEST_CASE_NOLINT(snapshot_null_machine_test) {
 BOOST_FIXTURE_TEST_CASE_NOLINT(snapshot_basic_test, ordinary_machine_fixture) {
     char *err_msg = nullptr;
     int error_code = cm_snapshot(_machine, &err_msg);
-    std::string result = err_msg;
-    std::string origin("snapshot is not supported");
-    BOOST_CHECK_EQUAL(error_code, CM_ERROR_RUNTIME_ERROR);
-    BOOST_CHECK_EQUAL(origin, result);
-    cm_delete_cstring(err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK_EQUAL(err_msg, nullptr);
 }
 
 BOOST_AUTO_TEST_CASE_NOLINT(rollback_null_machine_test) {
@@ -1682,12 +2182,53 @@ BOOST_FIXTURE_TEST_CASE_NOLINT(rollback_basic_test, ordinary_machine_fixture) {
     char *err_msg = nullptr;
     int error_code = cm_rollback(_machine, &err_msg);
     std::string result = err_msg;
-    std::string origin("rollback is not supported");
+    std::string origin("no snapshot to roll back to");
     BOOST_CHECK_EQUAL(error_code, CM_ERROR_RUNTIME_ERROR);
     BOOST_CHECK_EQUAL(origin, result);
     cm_delete_cstring(err_msg);
 }
 
+BOOST_FIXTURE_TEST_CASE_NOLINT(rollback_restore_test, ordinary_machine_fixture) {
+    // Changes to memory and registers after a snapshot must be undone by the rollback, including the root hash
+    char *err_msg = nullptr;
+    const auto page = make_test_page(7, 1);
+    write_page(_machine, 0x80000000, page);
+    cm_hash snapshot_hash{};
+    int error_code = cm_get_root_hash(_machine, &snapshot_hash, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    error_code = cm_snapshot(_machine, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+
+    std::array<unsigned char, 4096> other_page{};
+    other_page.fill(0xa5);
+    write_page(_machine, 0x80000000, other_page);
+    write_page(_machine, 0x80000000 + 9 * other_page.size(), other_page);
+    error_code = cm_write_x(_machine, 5, 0x1234, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    cm_hash changed_hash{};
+    error_code = cm_get_root_hash(_machine, &changed_hash, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK_NE(0, memcmp(snapshot_hash, changed_hash, sizeof(cm_hash)));
+
+    error_code = cm_rollback(_machine, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_REQUIRE_EQUAL(err_msg, nullptr);
+    check_page(_machine, 0x80000000, page);
+    uint64_t x5 = 0;
+    error_code = cm_read_x(_machine, 5, &x5, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK_EQUAL(x5, 0);
+    cm_hash restored_hash{};
+    error_code = cm_get_root_hash(_machine, &restored_hash, &err_msg);
+    BOOST_REQUIRE_EQUAL(error_code, CM_ERROR_OK);
+    BOOST_CHECK_EQUAL(0, memcmp(snapshot_hash, restored_hash, sizeof(cm_hash)));
+
+    // The rollback discards the snapshot
+    error_code = cm_rollback(_machine, &err_msg);
+    BOOST_CHECK_EQUAL(error_code, CM_ERROR_RUNTIME_ERROR);
+    cm_delete_cstring(err_msg);
+}
+
 BOOST_AUTO_TEST_CASE_NOLINT(read_x_null_machine_test) {
     uint64_t val{};
     int error_code = cm_read_x(nullptr, 4, &val, nullptr);
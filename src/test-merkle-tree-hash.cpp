@@ -14,6 +14,7 @@
 // with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
 //
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cinttypes>
@@ -23,13 +24,17 @@
 #include <cstdlib>
 #include <cstring>
 #include <optional>
+#include <thread>
+#include <vector>
 
 #include "back-merkle-tree.h"
 #include "complete-merkle-tree.h"
 #include "cryptopp-keccak-256-hasher.h"
 #include "full-merkle-tree.h"
+#include "keccak-256-batch.h"
 #include "merkle-tree-proof.h"
 #include "pristine-merkle-tree.h"
+#include "thread-pool.h"
 #include "unique-c-ptr.h"
 
 using namespace cartesi;
@@ -157,6 +162,58 @@ static hash_type get_leaf_hash(int log2_word_size, const unsigned char *leaf_dat
     return get_leaf_hash(h, log2_word_size, leaf_data, log2_leaf_size);
 }
 
+/// \brief Checks that hashing messages in batches matches hashing them one at a time
+/// \details Covers every multi-buffer Keccak-256 implementation supported by the host, all message lengths
+/// up to twice the Keccak-256 rate, and batch sizes that leave lanes partially filled.
+static void check_hash_batch(void) {
+    constexpr size_t max_length = 2 * (KECCAK_256_BATCH_MAX_LENGTH + 1);
+    constexpr size_t max_count = 2 * KECCAK_256_BATCH_LANES + 1;
+    std::vector<unsigned char> data(max_length * max_count);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<unsigned char>(i * 131 + 7);
+    }
+    // The last entry is a canary that must not be written
+    const hash_type canary{0xde, 0xad, 0xbe, 0xef};
+    std::vector<hash_type> expected(max_count);
+    std::vector<hash_type> hashes(max_count + 1);
+    hasher_type h;
+    for (auto backend : {keccak_256_batch_backend::generic, keccak_256_batch_backend::simd,
+             keccak_256_batch_backend::avx2, keccak_256_batch_backend::automatic}) {
+        if (!keccak_256_batch_backend_is_supported(backend)) {
+            std::cerr << "skipping unsupported hasher backend " << static_cast<uint64_t>(backend) << '\n';
+            continue;
+        }
+        keccak_256_set_batch_backend(backend);
+        for (size_t length = 0; length <= max_length; ++length) {
+            for (size_t i = 0; i < max_count; ++i) {
+                h.begin();
+                h.add_data(data.data() + i * length, length);
+                h.end(expected[i]);
+            }
+            for (size_t count = 0; count <= max_count; ++count) {
+                if (length <= KECCAK_256_BATCH_MAX_LENGTH) {
+                    std::fill(hashes.begin(), hashes.end(), canary);
+                    keccak_256_hash_batch(data.data(), length, count, hashes[0].data());
+                    if (!std::equal(expected.begin(), expected.begin() + count, hashes.begin()) ||
+                        hashes[count] != canary) {
+                        error("mismatch in batch hash for backend %" PRIu64 ", length %zu and count %zu\n",
+                            static_cast<uint64_t>(backend), length, count);
+                    }
+                }
+                // Longer messages must fall back to hashing one at a time
+                std::fill(hashes.begin(), hashes.end(), canary);
+                h.hash_batch(data.data(), length, count, hashes.data());
+                if (!std::equal(expected.begin(), expected.begin() + count, hashes.begin()) ||
+                    hashes[count] != canary) {
+                    error("mismatch in hasher batch hash for backend %" PRIu64 ", length %zu and count %zu\n",
+                        static_cast<uint64_t>(backend), length, count);
+                }
+            }
+        }
+    }
+    keccak_256_set_batch_backend(keccak_256_batch_backend::automatic);
+}
+
 /// \brief Prints help message
 static void help(const char *name) {
     (void) fprintf(stderr,
@@ -197,6 +254,9 @@ int main(int argc, char *argv[]) try {
             log2_root_size);
         return 1;
     }
+    std::cerr << "checking batch hashes\n";
+    check_hash_batch();
+
     // Read from stdin if no input name was given
     auto input_file = unique_file_ptr{stdin};
     if (input_name) {
@@ -304,6 +364,54 @@ int main(int argc, char *argv[]) try {
         }
         ++leaf_count;
     }
+    // Appending all leaf hashes in bulk must produce the same trees as
+    // appending them one at a time, both serially and using a thread pool.
+    // Split the leaves in two ranges, so the second range starts in the
+    // middle of subtrees that are already partially filled.
+    std::cerr << "appending leaf ranges\n";
+    thread_pool pool{std::max(UINT64_C(1), static_cast<uint64_t>(std::thread::hardware_concurrency()))};
+    const auto middle = leaf_hashes.begin() + static_cast<std::ptrdiff_t>(leaf_count / 3);
+    const std::vector<hash_type> first_range(leaf_hashes.begin(), middle);
+    const std::vector<hash_type> second_range(middle, leaf_hashes.end());
+    for (auto *range_pool : {static_cast<thread_pool *>(nullptr), &pool}) {
+        back_merkle_tree back_range_tree{log2_root_size, log2_leaf_size, log2_word_size};
+        complete_merkle_tree complete_range_tree{log2_root_size, log2_leaf_size, log2_word_size};
+        for (const auto *range : {&first_range, &second_range}) {
+            if (range_pool != nullptr) {
+                back_range_tree.push_back_range(*range, *range_pool);
+                complete_range_tree.push_back_range(*range, *range_pool);
+            } else {
+                back_range_tree.push_back_range(*range);
+                complete_range_tree.push_back_range(*range);
+            }
+        }
+        if (back_range_tree.get_root_hash() != back_tree.get_root_hash()) {
+            error("mismatch in root hash for back tree built from ranges\n");
+            return 1;
+        }
+        if (complete_range_tree.get_root_hash() != complete_tree.get_root_hash()) {
+            error("mismatch in root hash for complete tree built from ranges\n");
+            return 1;
+        }
+        if (leaf_count < max_leaves &&
+            back_range_tree.get_next_leaf_proof() != back_tree.get_next_leaf_proof()) {
+            error("mismatch in next leaf proof for back tree built from ranges\n");
+            return 1;
+        }
+        for (uint64_t i = 0; i < leaf_count; ++i) {
+            if (complete_range_tree.get_proof(i << log2_leaf_size, log2_leaf_size) !=
+                complete_tree.get_proof(i << log2_leaf_size, log2_leaf_size)) {
+                error("mismatch in leaf proofs for complete tree built from ranges\n");
+                return 1;
+            }
+        }
+    }
+    // Building the full tree using a thread pool must produce the same tree
+    const full_merkle_tree parallel_tree(log2_root_size, log2_leaf_size, log2_word_size, leaf_hashes, pool);
+    if (parallel_tree.get_root_hash() != back_tree.get_root_hash()) {
+        error("mismatch in root hash for back tree and tree built in parallel\n");
+        return 1;
+    }
     (void) fprintf(stderr, "passed test\n");
     print_hash(back_tree.get_root_hash(), stdout);
     return 0;
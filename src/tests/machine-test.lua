@@ -459,6 +459,115 @@ do_test("dirty page maps should be consistent", function(machine)
     assert(machine:verify_dirty_page_maps(), "error verifying dirty page maps")
 end)
 
+print("\n\n check code written to ram memory while machine runs")
+do_test("machine should execute the code last written", function(machine)
+    local ram_address_start = 0x80000000
+    -- addi a0, a0, 1; j -4
+    machine:write_memory(ram_address_start, string.pack("<I4I4", 0x00150513, 0xffdff06f))
+    machine:write_pc(ram_address_start)
+    machine:run(100)
+    assert(machine:read_x(10) == 50, "wrong a0 value before code is overwritten")
+    -- addi a0, a0, 2
+    machine:write_memory(ram_address_start, string.pack("<I4", 0x00250513))
+    machine:run(200)
+    assert(machine:read_x(10) == 150, "wrong a0 value after code is overwritten")
+end)
+
+do_test("machine should retire fused instructions one at a time", function(machine)
+    local ram_address_start = 0x80000000
+    -- lui a0, 0x12345; addi a0, a0, 0x678; j 0
+    machine:write_memory(ram_address_start, string.pack("<I4I4I4", 0x12345537, 0x67850513, 0x0000006f))
+    machine:write_pc(ram_address_start)
+    machine:run(1)
+    assert(machine:read_mcycle() == 1, "wrong mcycle value after first instruction")
+    assert(machine:read_pc() == ram_address_start + 4, "wrong pc value after first instruction")
+    assert(machine:read_x(10) == 0x12345000, "wrong a0 value after first instruction")
+    machine:run(2)
+    assert(machine:read_pc() == ram_address_start + 8, "wrong pc value after second instruction")
+    assert(machine:read_x(10) == 0x12345678, "wrong a0 value after second instruction")
+end)
+
+do_test("machine should execute page table entries updated by address translation", function(machine)
+    local ram_address_start = 0x80000000
+    -- auipc t0, 0; addi t0, t0, 256; j 504 (to the page table entry at offset 0x200)
+    machine:write_memory(ram_address_start, string.pack("<I4I4I4", 0x00000297, 0x10028293, 0x1f80006f))
+    -- The code page is also the last level page table, mapping virtual page 0x40000 to physical page 0x800a0000.
+    -- Its entry (V, R, W, G, A) decodes as jr 512(t0). Once the D bit is set, it decodes as jalr 512(t0).
+    machine:write_memory(ram_address_start + 0x200, string.pack("<I8", 0x20028067))
+    -- Root and intermediate page tables
+    machine:write_memory(ram_address_start + 0x2000, string.pack("<I8", 0x20000c01))
+    machine:write_memory(ram_address_start + 0x3000, string.pack("<I8", 0x20000001))
+    -- addi s0, s0, 1; li t1, 2; beq s0, t1, 60 (to j 0)
+    -- li t2, 8; slli t2, t2, 60; lui t3, 128; addi t3, t3, 2; or t2, t2, t3; csrw satp, t2
+    -- lui t5, 1; csrc mstatus, t5; lui t4, 33; addi t4, t4, -2048; csrs mstatus, t4 (MPRV with MPP = S)
+    -- lui t6, 64; sd zero, 0(t6) (sets the D bit); j -320 (back to the page table entry); j 0
+    machine:write_memory(
+        ram_address_start + 0x300,
+        string.pack(
+            "<I4I4I4I4I4I4I4I4I4I4I4I4I4I4I4I4I4I4",
+            0x00140413,
+            0x00200313,
+            0x02640e63,
+            0x00800393,
+            0x03c39393,
+            0x00080e37,
+            0x002e0e13,
+            0x01c3e3b3,
+            0x18039073,
+            0x00001f37,
+            0x300f3073,
+            0x00021eb7,
+            0x800e8e93,
+            0x300ea073,
+            0x00040fb7,
+            0x000fb023,
+            0xec1ff06f,
+            0x0000006f
+        )
+    )
+    machine:write_pc(ram_address_start)
+    machine:run(100)
+    assert(machine:read_pc() == ram_address_start + 0x344, "wrong pc value after page table entry is updated")
+    assert(
+        string.unpack("<I8", machine:read_memory(ram_address_start + 0x200, 8)) == 0x200280e7,
+        "D bit not set in page table entry"
+    )
+    assert(machine:read_x(1) == ram_address_start + 0x204, "stale instruction executed from page table entry")
+end)
+
+do_test("root hash should follow pages written back through a flushed write TLB entry", function(machine)
+    local ram_address_start = 0x80000000
+    local data_address = ram_address_start + 0x1000
+    -- auipc t0, 1; li t1, 1; sd t1, 0(t0); li t2, 2; sd t2, 0(t0); sfence.vma; sd t1, 0(t0); j 0
+    machine:write_memory(
+        ram_address_start,
+        string.pack(
+            "<I4I4I4I4I4I4I4I4",
+            0x00001297,
+            0x00100313,
+            0x0062b023,
+            0x00200393,
+            0x0072b023,
+            0x12000073,
+            0x0062b023,
+            0x0000006f
+        )
+    )
+    machine:write_pc(ram_address_start)
+    -- Hash the page after it is written through the TLB, after it is changed and its entry is flushed,
+    -- and after the entry maps it again to write back the first contents
+    for _, mcycle in ipairs({ 3, 6, 7 }) do
+        machine:run(mcycle)
+        machine:get_root_hash()
+    end
+    local page_proof = machine:get_proof(data_address, 12)
+    local calculated_hash = test_util.calculate_root_hash(machine:read_memory(data_address, 2 ^ 12), 12)
+    assert(
+        test_util.tohex(page_proof.target_hash) == test_util.tohex(calculated_hash),
+        "page hash does not match page contents"
+    )
+end)
+
 print("\n\n check replace flash drives")
 test_util.make_do_test(build_machine, machine_type, {
     processor = {},
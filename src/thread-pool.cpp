@@ -0,0 +1,163 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#include <algorithm>
+#include <utility>
+
+#include "thread-pool.h"
+
+namespace cartesi {
+
+thread_pool::thread_pool(uint64_t concurrency) :
+    m_concurrency{std::max<uint64_t>(concurrency, 1)},
+    m_shares{std::make_unique<share[]>(m_concurrency)} {
+    m_threads.reserve(m_concurrency - 1);
+    for (uint64_t worker = 1; worker < m_concurrency; ++worker) {
+        m_threads.emplace_back([this, worker]() { run_thread(worker); });
+    }
+}
+
+thread_pool::~thread_pool() {
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto &t : m_threads) {
+        t.join();
+    }
+}
+
+void thread_pool::parallel_for(uint64_t count, uint64_t chunk, const chunk_function &f) {
+    chunk = std::max<uint64_t>(chunk, 1);
+    // Waking up threads is not worth it if there is a single chunk
+    if (m_concurrency == 1 || count <= chunk) {
+        if (count > 0) {
+            f(0, 0, count);
+        }
+        return;
+    }
+    // Split items evenly among workers
+    for (uint64_t worker = 0; worker < m_concurrency; ++worker) {
+        share &s = m_shares[worker];
+        const std::lock_guard<std::mutex> lock(s.mutex);
+        s.begin = count * worker / m_concurrency;
+        s.end = count * (worker + 1) / m_concurrency;
+    }
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        m_f = &f;
+        m_chunk = chunk;
+        m_exception = nullptr;
+        m_active = m_concurrency - 1;
+        ++m_generation;
+    }
+    m_wake.notify_all();
+    // The calling thread is worker 0
+    work(0);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_active == 0; });
+    m_f = nullptr;
+    if (m_exception) {
+        std::rethrow_exception(std::exchange(m_exception, nullptr));
+    }
+}
+
+void thread_pool::work(uint64_t worker) {
+    uint64_t begin = 0;
+    uint64_t end = 0;
+    while (take_chunk(worker, begin, end)) {
+        try {
+            (*m_f)(worker, begin, end);
+        } catch (...) {
+            const std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_exception) {
+                m_exception = std::current_exception();
+            }
+            // Give up on the remaining items of this worker, other workers will run out soon
+            const std::lock_guard<std::mutex> share_lock(m_shares[worker].mutex);
+            m_shares[worker].begin = m_shares[worker].end;
+        }
+    }
+}
+
+bool thread_pool::take_chunk(uint64_t worker, uint64_t &begin, uint64_t &end) {
+    share &own = m_shares[worker];
+    for (;;) {
+        {
+            const std::lock_guard<std::mutex> lock(own.mutex);
+            if (own.begin < own.end) {
+                begin = own.begin;
+                end = std::min(own.end, begin + m_chunk);
+                own.begin = end;
+                return true;
+            }
+        }
+        // Own share is exhausted, so steal the second half of the largest remaining share
+        uint64_t victim = worker;
+        uint64_t victim_remaining = 0;
+        for (uint64_t i = 1; i < m_concurrency; ++i) {
+            const uint64_t other = (worker + i) % m_concurrency;
+            share &s = m_shares[other];
+            const std::lock_guard<std::mutex> lock(s.mutex);
+            if (s.end - s.begin > victim_remaining) {
+                victim = other;
+                victim_remaining = s.end - s.begin;
+            }
+        }
+        if (victim_remaining == 0) {
+            return false;
+        }
+        uint64_t stolen_begin = 0;
+        uint64_t stolen_end = 0;
+        {
+            share &s = m_shares[victim];
+            const std::lock_guard<std::mutex> lock(s.mutex);
+            // The victim may have made progress since we looked
+            if (s.begin >= s.end) {
+                continue;
+            }
+            stolen_end = s.end;
+            stolen_begin = s.begin + (s.end - s.begin) / 2;
+            s.end = stolen_begin;
+        }
+        const std::lock_guard<std::mutex> lock(own.mutex);
+        own.begin = stolen_begin;
+        own.end = stolen_end;
+    }
+}
+
+void thread_pool::run_thread(uint64_t worker) {
+    uint64_t generation = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this, generation]() { return m_stop || m_generation != generation; });
+            if (m_stop) {
+                return;
+            }
+            generation = m_generation;
+        }
+        work(worker);
+        {
+            const std::lock_guard<std::mutex> lock(m_mutex);
+            --m_active;
+        }
+        m_done.notify_one();
+    }
+}
+
+} // namespace cartesi
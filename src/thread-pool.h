@@ -0,0 +1,111 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+/// \file
+/// \brief Work-stealing thread pool.
+/// \details The pool keeps its threads alive between jobs, so jobs that run often (e.g., updating the Merkle
+/// tree after every few million cycles) do not pay for thread creation.
+/// Each job is a range of items, initially split evenly among the workers. Workers process their own share in
+/// chunks, and steal half of the remaining share of another worker when they run out.
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cartesi {
+
+/// \class thread_pool
+/// \brief Persistent pool of threads that process ranges of items in parallel.
+class thread_pool final {
+public:
+    /// \brief Function called for each chunk of items.
+    /// \details Receives the index of the worker processing the chunk, which is less than get_concurrency(),
+    /// and the range [begin, end) of items in the chunk. Chunks given to the same worker never run concurrently.
+    using chunk_function = std::function<void(uint64_t worker, uint64_t begin, uint64_t end)>;
+
+    /// \brief Constructor
+    /// \param concurrency Number of workers, including the thread that calls parallel_for().
+    explicit thread_pool(uint64_t concurrency);
+
+    /// \brief No copy constructor
+    thread_pool(const thread_pool &) = delete;
+    /// \brief No copy assignment
+    thread_pool &operator=(const thread_pool &) = delete;
+    /// \brief No move constructor
+    thread_pool(thread_pool &&) = delete;
+    /// \brief No move assignment
+    thread_pool &operator=(thread_pool &&) = delete;
+    /// \brief Destructor waits for all threads to exit
+    ~thread_pool();
+
+    /// \brief Returns the number of workers, including the thread that calls parallel_for().
+    uint64_t get_concurrency(void) const {
+        return m_concurrency;
+    }
+
+    /// \brief Processes a range of items in parallel, returning when all items are done.
+    /// \param count Number of items.
+    /// \param chunk Maximum number of items given to a worker at a time.
+    /// \param f Function called for each chunk.
+    /// \details If \p f throws, remaining items may be skipped and the first exception is rethrown.
+    /// Must not be called concurrently, or from within \p f.
+    void parallel_for(uint64_t count, uint64_t chunk, const chunk_function &f);
+
+private:
+    /// \brief Items still to be processed by a worker.
+    struct alignas(64) share final {
+        std::mutex mutex; ///< Protects begin and end, which may be changed by other workers stealing
+        uint64_t begin{}; ///< First item
+        uint64_t end{};   ///< One past last item
+    };
+
+    /// \brief Processes items until there are none left in any share.
+    void work(uint64_t worker);
+
+    /// \brief Takes the next chunk of items from the share of a worker, stealing if needed.
+    /// \returns true if a chunk was taken, false if there are no items left.
+    bool take_chunk(uint64_t worker, uint64_t &begin, uint64_t &end);
+
+    /// \brief Loop executed by each thread.
+    void run_thread(uint64_t worker);
+
+    uint64_t m_concurrency;             ///< Number of workers
+    std::unique_ptr<share[]> m_shares;  ///< Share of each worker
+    std::vector<std::thread> m_threads; ///< Threads for all workers but the first
+
+    std::mutex m_mutex;             ///< Protects all fields below
+    std::condition_variable m_wake; ///< Signals threads that a job started or that the pool is stopping
+    std::condition_variable m_done; ///< Signals parallel_for() that a thread finished its part of the job
+    uint64_t m_generation{0};       ///< Incremented when a job starts
+    uint64_t m_active{0};           ///< Number of threads still working on current job
+    bool m_stop{false};             ///< Set when threads must exit
+
+    const chunk_function *m_f{nullptr}; ///< Function of current job
+    uint64_t m_chunk{1};                ///< Chunk size of current job
+    std::exception_ptr m_exception;     ///< First exception thrown by current job
+};
+
+} // namespace cartesi
+
+#endif
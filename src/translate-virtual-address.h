@@ -62,10 +62,16 @@ static inline bool write_ram_uint64(STATE_ACCESS &a, uint64_t paddr, uint64_t va
     const uint64_t paddr_page = paddr & ~PAGE_OFFSET_MASK;
     unsigned char *hpage = a.get_host_memory(pma) + (paddr_page - pma.get_start());
     const uint64_t hoffset = paddr - paddr_page;
+    // save page in case of a rollback, before it is modified
+    pma.save_page_for_rollback(paddr_page - pma.get_start());
     // log writes to memory
     a.write_memory_word(paddr, hpage, hoffset, val);
     // mark page as dirty so we know to update the Merkle tree
     pma.mark_dirty_page(paddr - pma.get_start());
+#ifndef MICROARCHITECTURE
+    // the write did not go through the TLB, so instructions decoded from the page may now be stale
+    a.get_naked_machine().get_decode_cache().invalidate_page(paddr_page);
+#endif
     return true;
 }
 
@@ -88,18 +94,29 @@ static inline bool read_ram_uint64(STATE_ACCESS &a, uint64_t paddr, uint64_t *pv
     return true;
 }
 
+/// \brief Page table entry visitor that ignores all entries.
+struct null_pte_visitor final {
+    void operator()(uint64_t pte_addr, uint64_t pte) const {
+        (void) pte_addr;
+        (void) pte;
+    }
+};
+
 /// \brief Walk the page table and translate a virtual address to the corresponding physical address
 /// \tparam STATE_ACCESS Class of machine state accessor object.
 /// \tparam UPDATE_PTE Whether PTE entries can be modified during the translation.
+/// \tparam PTE_VISITOR Type of page table entry visitor.
 /// \param a Machine state accessor object.
 /// \param vaddr Virtual address
 /// \param ppaddr Pointer to physical address.
 /// \param xwr_shift Encodes the access mode by the shift to the XWR triad (PTE_XWR_R_SHIFT,
 ///  PTE_XWR_R_SHIFT, or PTE_XWR_R_SHIFT)
-/// \details This function is outlined to minimize host CPU code cache pressure.
+/// \param visit_pte Called with the physical address and value of each page table entry in a successful walk.
+/// The value passed for the leaf entry already includes any access bits set by the walk.
 /// \returns True if succeeded, false otherwise.
-template <typename STATE_ACCESS, bool UPDATE_PTE = true>
-static NO_INLINE bool translate_virtual_address(STATE_ACCESS &a, uint64_t *ppaddr, uint64_t vaddr, int xwr_shift) {
+template <typename STATE_ACCESS, bool UPDATE_PTE, typename PTE_VISITOR>
+static FORCE_INLINE bool walk_page_table(STATE_ACCESS &a, uint64_t *ppaddr, uint64_t vaddr, int xwr_shift,
+    PTE_VISITOR &&visit_pte) {
     auto priv = a.read_iflags_PRV();
     const uint64_t mstatus = a.read_mstatus();
 
@@ -231,18 +248,36 @@ static NO_INLINE bool translate_virtual_address(STATE_ACCESS &a, uint64_t *ppadd
                 if (pte != update_pte) {
                     write_ram_uint64(a, pte_addr, update_pte); // Can't fail since read succeeded earlier
                 }
+                pte = update_pte;
             }
+            visit_pte(pte_addr, pte);
             // Add page offset in vaddr to ppn to form physical address
             *ppaddr = (vaddr & vaddr_mask) | (ppn & ~vaddr_mask);
             return true;
             // xwr == 0 means we have a pointer to the start of the next page table
         } else {
+            visit_pte(pte_addr, pte);
             pte_addr = ppn;
         }
     }
     return false;
 }
 
+/// \brief Walk the page table and translate a virtual address to the corresponding physical address
+/// \tparam STATE_ACCESS Class of machine state accessor object.
+/// \tparam UPDATE_PTE Whether PTE entries can be modified during the translation.
+/// \param a Machine state accessor object.
+/// \param vaddr Virtual address
+/// \param ppaddr Pointer to physical address.
+/// \param xwr_shift Encodes the access mode by the shift to the XWR triad (PTE_XWR_R_SHIFT,
+///  PTE_XWR_R_SHIFT, or PTE_XWR_R_SHIFT)
+/// \details This function is outlined to minimize host CPU code cache pressure.
+/// \returns True if succeeded, false otherwise.
+template <typename STATE_ACCESS, bool UPDATE_PTE = true>
+static NO_INLINE bool translate_virtual_address(STATE_ACCESS &a, uint64_t *ppaddr, uint64_t vaddr, int xwr_shift) {
+    return walk_page_table<STATE_ACCESS, UPDATE_PTE>(a, ppaddr, vaddr, xwr_shift, null_pte_visitor{});
+}
+
 } // namespace cartesi
 
 #endif /* end of include guard: TRANSLATE_VIRTUAL_ADDRESS_H */
@@ -319,7 +319,8 @@ private:
         auto old_data = aliased_aligned_read<uint64_t>(hdata);
         // Log the write access
         log_before_write(paddr, old_data, data, "memory");
-        // Actually modify the state
+        // Save the page in case of a rollback, then actually modify the state
+        pma.save_page_for_rollback(hoffset);
         aliased_aligned_write<uint64_t>(hdata, data);
 
         // Finally, update Merkle tree or mark the page dirty, depending on whether proofs are being requested or not
@@ -166,6 +166,7 @@ private:
         // Found a writable memory range. Access host memory accordingly.
         const uint64_t hoffset = paddr - pma.get_start();
         unsigned char *hmem = pma.get_memory().get_host_memory() + hoffset;
+        pma.save_page_for_rollback(hoffset);
         aliased_aligned_write(hmem, data);
         const uint64_t paddr_page = paddr & ~PAGE_OFFSET_MASK;
         pma.mark_dirty_page(paddr_page - pma.get_start());
@@ -32,6 +32,10 @@ void virtual_machine::do_store(const std::string &dir) {
     m_machine->store(dir);
 }
 
+void virtual_machine::do_store_delta(const std::string &dir, const std::string &base_dir) {
+    m_machine->store_delta(dir, base_dir);
+}
+
 interpreter_break_reason virtual_machine::do_run(uint64_t mcycle_end) {
     return m_machine->run(mcycle_end);
 }
@@ -44,6 +48,11 @@ machine_merkle_tree::proof_type virtual_machine::do_get_proof(uint64_t address,
     return m_machine->get_proof(address, log2_size);
 }
 
+machine_merkle_tree::multiproof_type virtual_machine::do_get_proofs(
+    const std::vector<machine_merkle_tree::multiproof_type::target_type> &targets) const {
+    return m_machine->get_proofs(targets);
+}
+
 void virtual_machine::do_get_root_hash(hash_type &hash) const {
     m_machine->get_root_hash(hash);
 }
@@ -432,6 +441,12 @@ bool virtual_machine::do_verify_dirty_page_maps(void) const {
     return m_machine->verify_dirty_page_maps();
 }
 
+void virtual_machine::do_get_page_hash_cache_stats(uint64_t &hits, uint64_t &misses) const {
+    const auto &cache = m_machine->get_page_hash_cache();
+    hits = cache.get_hits();
+    misses = cache.get_misses();
+}
+
 machine_config virtual_machine::do_get_initial_config(void) const {
     return m_machine->get_initial_config();
 }
@@ -441,11 +456,11 @@ void virtual_machine::do_destroy() {
 }
 
 void virtual_machine::do_snapshot(void) {
-    throw std::runtime_error("snapshot is not supported");
+    m_machine->snapshot();
 }
 
 void virtual_machine::do_rollback(void) {
-    throw std::runtime_error("rollback is not supported");
+    m_machine->rollback();
 }
 
 uint64_t virtual_machine::do_read_uarch_x(int i) const {
@@ -41,9 +41,12 @@ public:
 
 private:
     void do_store(const std::string &dir) override;
+    void do_store_delta(const std::string &dir, const std::string &base_dir) override;
     interpreter_break_reason do_run(uint64_t mcycle_end) override;
     access_log do_step_uarch(const access_log::type &log_type, bool one_based = false) override;
     machine_merkle_tree::proof_type do_get_proof(uint64_t address, int log2_size) const override;
+    machine_merkle_tree::multiproof_type do_get_proofs(
+        const std::vector<machine_merkle_tree::multiproof_type::target_type> &targets) const override;
     void do_get_root_hash(hash_type &hash) const override;
     bool do_verify_merkle_tree(void) const override;
     uint64_t do_read_csr(csr r) const override;
@@ -141,6 +144,7 @@ private:
     void do_dump_pmas(void) const override;
     uint64_t do_read_word(uint64_t address) const override;
     bool do_verify_dirty_page_maps(void) const override;
+    void do_get_page_hash_cache_stats(uint64_t &hits, uint64_t &misses) const override;
     machine_config do_get_initial_config(void) const override;
     void do_snapshot() override;
     void do_destroy() override;
@@ -0,0 +1,121 @@
+// Copyright Cartesi and individual authors (see AUTHORS)
+// SPDX-License-Identifier: LGPL-3.0-or-later
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+// PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along
+// with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+//
+
+#ifndef WRITE_TLB_SNAPSHOT_H
+#define WRITE_TLB_SNAPSHOT_H
+
+/// \file
+/// \brief Snapshot of pages mapped by the write TLB.
+/// \details Stores that hit the write TLB do not mark their pages dirty, so every page mapped by the write TLB
+/// must be assumed dirty when the Merkle tree is updated. Pages that stay in the write TLB across many updates
+/// would then be hashed again each time, even if they were not modified in between.
+/// The snapshot keeps a copy of each page mapped by the write TLB, taken right after the Merkle tree is updated.
+/// A page that still matches its copy at the next update has the same hash, so it does not have to be marked dirty.
+/// Copies are valid only while the Merkle tree holds the hashes of their contents, so the copy of an entry that is
+/// no longer valid is dropped: its page can be hashed with other contents and then be written back through the entry.
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "pma-constants.h"
+#include "shadow-tlb.h"
+
+namespace cartesi {
+
+/// \class write_tlb_snapshot
+/// \brief Copies of the pages mapped by each write TLB entry.
+class write_tlb_snapshot final {
+public:
+    write_tlb_snapshot() {
+        clear();
+    }
+
+    /// \brief No copy constructor
+    write_tlb_snapshot(const write_tlb_snapshot &) = delete;
+    /// \brief No copy assignment
+    write_tlb_snapshot &operator=(const write_tlb_snapshot &) = delete;
+    /// \brief No move constructor
+    write_tlb_snapshot(write_tlb_snapshot &&) = delete;
+    /// \brief No move assignment
+    write_tlb_snapshot &operator=(write_tlb_snapshot &&) = delete;
+    /// \brief Default destructor
+    ~write_tlb_snapshot() = default;
+
+    /// \brief Tells if the page mapped by a write TLB entry still matches its copy.
+    /// \param eidx Index of write TLB entry.
+    /// \param paddr_page Target physical address of page mapped by the entry.
+    /// \param page_data Host pointer to page contents.
+    /// \returns true if the copy is valid and matches the page, false otherwise.
+    bool is_unchanged(uint64_t eidx, uint64_t paddr_page, const unsigned char *page_data) const {
+        return m_paddr_pages[eidx] == paddr_page && memcmp(get_copy(eidx), page_data, PMA_PAGE_SIZE) == 0;
+    }
+
+    /// \brief Copies the page mapped by a write TLB entry.
+    /// \param eidx Index of write TLB entry.
+    /// \param paddr_page Target physical address of page mapped by the entry.
+    /// \param page_data Host pointer to page contents.
+    /// \details Must only be called when the Merkle tree holds the hash of the page contents.
+    void take(uint64_t eidx, uint64_t paddr_page, const unsigned char *page_data) {
+        // Allocate copies only for machines that actually update their Merkle trees
+        if (m_copies.empty()) {
+            m_copies.resize(PMA_TLB_SIZE * PMA_PAGE_SIZE);
+        }
+        memcpy(get_copy(eidx), page_data, PMA_PAGE_SIZE);
+        m_paddr_pages[eidx] = paddr_page;
+    }
+
+    /// \brief Invalidates the copy of the page mapped by a write TLB entry.
+    /// \param eidx Index of write TLB entry.
+    void invalidate_entry(uint64_t eidx) {
+        m_paddr_pages[eidx] = TLB_INVALID_PAGE;
+    }
+
+    /// \brief Invalidates the copies of a physical page.
+    /// \param paddr_page Target physical address of page start.
+    /// \details Must be called whenever the Merkle tree receives the hash of the page by other means.
+    void invalidate_page(uint64_t paddr_page) {
+        for (auto &p : m_paddr_pages) {
+            if (p == paddr_page) {
+                p = TLB_INVALID_PAGE;
+            }
+        }
+    }
+
+    /// \brief Invalidates all copies.
+    void clear(void) {
+        m_paddr_pages.fill(TLB_INVALID_PAGE);
+    }
+
+private:
+    /// \brief Returns the copy of the page mapped by a write TLB entry.
+    unsigned char *get_copy(uint64_t eidx) {
+        return m_copies.data() + eidx * PMA_PAGE_SIZE;
+    }
+
+    /// \brief Returns the copy of the page mapped by a write TLB entry.
+    const unsigned char *get_copy(uint64_t eidx) const {
+        return m_copies.data() + eidx * PMA_PAGE_SIZE;
+    }
+
+    std::array<uint64_t, PMA_TLB_SIZE> m_paddr_pages{}; ///< Page copied for each entry, or TLB_INVALID_PAGE
+    std::vector<unsigned char> m_copies;                ///< One page copy for each entry
+};
+
+} // namespace cartesi
+
+#endif
@@ -0,0 +1,136 @@
+#!/usr/bin/env lua5.4
+
+-- Copyright Cartesi and individual authors (see AUTHORS)
+-- SPDX-License-Identifier: LGPL-3.0-or-later
+--
+-- This program is free software: you can redistribute it and/or modify it under
+-- the terms of the GNU Lesser General Public License as published by the Free
+-- Software Foundation, either version 3 of the License, or (at your option) any
+-- later version.
+--
+-- This program is distributed in the hope that it will be useful, but WITHOUT ANY
+-- WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+-- PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+--
+-- You should have received a copy of the GNU Lesser General Public License along
+-- with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+--
+
+-- Compares hasher backends on hashing 4 KiB pages.
+-- Usage: page-hash.lua [<backend>...]
+-- Each argument is a hasher backend (auto, generic, simd, or avx2). By default, all of them are compared.
+-- Hashing runs in a single thread, so the results measure the backend rather than the thread pool.
+
+local socket = require("socket")
+local cartesi = require("cartesi")
+
+-- Number of times each benchmark is measured
+local N_RUNS = 5
+
+local PRINT_STDDEV = true
+
+local PAGE_SIZE = 4096
+
+local PMA_RAM_START = 0x80000000
+
+-- Number of pages modified before each measurement
+local PAGES = 4096
+
+local BACKENDS = {}
+for _, arg_value in ipairs(arg) do
+    table.insert(BACKENDS, arg_value)
+end
+if #BACKENDS == 0 then BACKENDS = { "auto", "generic", "simd", "avx2" } end
+
+local function build_machine()
+    local config = {
+        processor = {
+            -- Request automatic default values for versioning CSRs
+            mimpid = -1,
+            marchid = -1,
+            mvendorid = -1,
+        },
+        ram = {
+            length = PAGES * PAGE_SIZE,
+        },
+    }
+    local runtime = {
+        concurrency = {
+            update_merkle_tree = 1,
+        },
+    }
+    return cartesi.machine(config, runtime)
+end
+
+-- Fills a page with bytes that differ from run to run, so no page is pristine
+local function page_data(run, page)
+    local words = {}
+    for i = 1, PAGE_SIZE // 8 do
+        words[i] = string.pack("<I8", (run << 48) | (page << 16) | i)
+    end
+    return table.concat(words)
+end
+
+local function measure(backend)
+    local results = {}
+    -- Backends the host does not support cannot be selected
+    if not pcall(cartesi.set_hasher_backend, backend) then return nil end
+    local machine <close> = build_machine()
+    for run = 1, N_RUNS do
+        machine:get_root_hash()
+        for page = 0, PAGES - 1 do
+            machine:write_memory(PMA_RAM_START + page * PAGE_SIZE, page_data(run, page))
+        end
+        local start = socket.gettime()
+        machine:get_root_hash()
+        local elapsed = socket.gettime() - start
+        table.insert(results, elapsed)
+    end
+    return results
+end
+
+local function measure_all()
+    local results = {}
+    for _, backend in ipairs(BACKENDS) do
+        table.insert(results, {
+            backend = backend,
+            times = measure(backend),
+        })
+    end
+    return results
+end
+
+local function average(arr)
+    local avg = 0.0
+    for _, value in ipairs(arr) do
+        avg = avg + value
+    end
+    return avg / #arr
+end
+
+local function stddev(arr)
+    local std2 = 0.0
+    local avg = average(arr)
+    for _, value in ipairs(arr) do
+        std2 = std2 + (value - avg) ^ 2
+    end
+    return math.sqrt(std2 / #arr)
+end
+
+local function print_results(results)
+    io.write("|backend|time per page (us)|\n")
+    for _, result in ipairs(results) do
+        io.write("|")
+        io.write(string.format("%7s", result.backend))
+        io.write("|")
+        if result.times then
+            io.write(string.format("%10.3f", average(result.times) * 1000000 / PAGES))
+            if PRINT_STDDEV then io.write(string.format(" +-%9.3f", stddev(result.times) * 1000000 / PAGES)) end
+        else
+            io.write(string.format("%22s", "unsupported"))
+        end
+        io.write("|\n")
+    end
+end
+
+print_results(measure_all())
@@ -0,0 +1,129 @@
+#!/usr/bin/env lua5.4
+
+-- Copyright Cartesi and individual authors (see AUTHORS)
+-- SPDX-License-Identifier: LGPL-3.0-or-later
+--
+-- This program is free software: you can redistribute it and/or modify it under
+-- the terms of the GNU Lesser General Public License as published by the Free
+-- Software Foundation, either version 3 of the License, or (at your option) any
+-- later version.
+--
+-- This program is distributed in the hope that it will be useful, but WITHOUT ANY
+-- WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+-- PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+--
+-- You should have received a copy of the GNU Lesser General Public License along
+-- with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+--
+
+-- Measures how long get_root_hash takes after a number of RAM pages are modified.
+-- Usage: root-hash-latency.lua [<threads>...]
+-- Each argument is a value for the update_merkle_tree concurrency runtime config (0 means all hardware threads).
+
+local socket = require("socket")
+local cartesi = require("cartesi")
+
+-- Number of times each benchmark is measured
+local N_RUNS = 5
+
+local PRINT_STDDEV = true
+
+local PAGE_SIZE = 4096
+
+local PMA_RAM_START = 0x80000000
+
+local RAM_LENGTH = 1 << 30
+
+local DIRTY_PAGES = { 1, 16, 256, 4096, 65536, 262144 }
+
+local THREADS = {}
+for _, arg_value in ipairs(arg) do
+    table.insert(THREADS, assert(math.tointeger(tonumber(arg_value)), "invalid number of threads"))
+end
+if #THREADS == 0 then THREADS = { 1, 0 } end
+
+local function build_machine(threads)
+    local config = {
+        processor = {
+            -- Request automatic default values for versioning CSRs
+            mimpid = -1,
+            marchid = -1,
+            mvendorid = -1,
+        },
+        ram = {
+            length = RAM_LENGTH,
+        },
+    }
+    local runtime = {
+        concurrency = {
+            update_merkle_tree = threads,
+        },
+    }
+    return cartesi.machine(config, runtime)
+end
+
+local function measure(threads, dirty_pages)
+    local results = {}
+    local machine <close> = build_machine(threads)
+    -- Spread the dirty pages evenly over RAM, so they share as few inner nodes as possible
+    local stride = RAM_LENGTH // dirty_pages
+    for run = 1, N_RUNS do
+        machine:get_root_hash()
+        local data = string.pack("<I8", run)
+        for i = 0, dirty_pages - 1 do
+            machine:write_memory(PMA_RAM_START + i * stride + (run % (stride // PAGE_SIZE)) * PAGE_SIZE, data)
+        end
+        local start = socket.gettime()
+        machine:get_root_hash()
+        local elapsed = socket.gettime() - start
+        table.insert(results, elapsed)
+    end
+    return results
+end
+
+local function measure_all()
+    local results = {}
+    for _, threads in ipairs(THREADS) do
+        for _, dirty_pages in ipairs(DIRTY_PAGES) do
+            table.insert(results, {
+                threads = threads,
+                dirty_pages = dirty_pages,
+                times = measure(threads, dirty_pages),
+            })
+        end
+    end
+    return results
+end
+
+local function average(arr)
+    local avg = 0.0
+    for _, value in ipairs(arr) do
+        avg = avg + value
+    end
+    return avg / #arr
+end
+
+local function stddev(arr)
+    local std2 = 0.0
+    local avg = average(arr)
+    for _, value in ipairs(arr) do
+        std2 = std2 + (value - avg) ^ 2
+    end
+    return math.sqrt(std2 / #arr)
+end
+
+local function print_results(results)
+    io.write("|threads|dirty pages|root hash latency (ms)|\n")
+    for _, result in ipairs(results) do
+        io.write("|")
+        io.write(string.format("%7d", result.threads))
+        io.write("|")
+        io.write(string.format("%11d", result.dirty_pages))
+        io.write("|")
+        io.write(string.format("%10.3f", average(result.times) * 1000))
+        if PRINT_STDDEV then io.write(string.format(" +-%9.3f", stddev(result.times) * 1000)) end
+        io.write("|\n")
+    end
+end
+
+print_results(measure_all())
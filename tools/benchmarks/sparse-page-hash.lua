@@ -0,0 +1,138 @@
+#!/usr/bin/env lua5.4
+
+-- Copyright Cartesi and individual authors (see AUTHORS)
+-- SPDX-License-Identifier: LGPL-3.0-or-later
+--
+-- This program is free software: you can redistribute it and/or modify it under
+-- the terms of the GNU Lesser General Public License as published by the Free
+-- Software Foundation, either version 3 of the License, or (at your option) any
+-- later version.
+--
+-- This program is distributed in the hope that it will be useful, but WITHOUT ANY
+-- WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+-- PARTICULAR PURPOSE. See the GNU Lesser General Public License for more details.
+--
+-- You should have received a copy of the GNU Lesser General Public License along
+-- with this program (see COPYING). If not, see <https://www.gnu.org/licenses/>.
+--
+
+-- Measures how long hashing 4 KiB pages takes depending on how many of their 8-byte words are non-zero.
+-- Usage: sparse-page-hash.lua
+-- Pages are rewritten with the same density on every run, so they are always dirty. Pages that end up all
+-- zeros exercise pristine page detection; sparse pages exercise the pristine subtree shortcut in page hashing.
+-- Hashing runs in a single thread, so the results measure hashing rather than the thread pool.
+
+local socket = require("socket")
+local cartesi = require("cartesi")
+
+-- Number of times each benchmark is measured
+local N_RUNS = 5
+
+local PRINT_STDDEV = true
+
+local PAGE_SIZE = 4096
+
+local WORDS_PER_PAGE = PAGE_SIZE // 8
+
+local PMA_RAM_START = 0x80000000
+
+-- Number of pages modified before each measurement
+local PAGES = 4096
+
+-- Number of non-zero words in each page
+local NONZERO_WORDS = { 0, 1, 8, 64, 256, 512 }
+
+local function build_machine()
+    local config = {
+        processor = {
+            -- Request automatic default values for versioning CSRs
+            mimpid = -1,
+            marchid = -1,
+            mvendorid = -1,
+        },
+        ram = {
+            length = PAGES * PAGE_SIZE,
+        },
+    }
+    local runtime = {
+        concurrency = {
+            update_merkle_tree = 1,
+        },
+    }
+    return cartesi.machine(config, runtime)
+end
+
+-- Builds a page with non-zero words spread evenly over it, with values that differ from run to run
+local function page_data(run, page, nonzero_words)
+    local words = {}
+    local stride = nonzero_words > 0 and WORDS_PER_PAGE // nonzero_words or WORDS_PER_PAGE + 1
+    for i = 0, WORDS_PER_PAGE - 1 do
+        local value = 0
+        if i % stride == 0 then value = (run << 48) | (page << 16) | (i + 1) end
+        words[i + 1] = string.pack("<I8", value)
+    end
+    return table.concat(words)
+end
+
+local function measure(nonzero_words)
+    local results = {}
+    local machine <close> = build_machine()
+    for run = 1, N_RUNS do
+        machine:get_root_hash()
+        -- Make sure pages are dirty even when they stay all zeros
+        for page = 0, PAGES - 1 do
+            machine:write_memory(PMA_RAM_START + page * PAGE_SIZE, string.pack("<I8", run))
+        end
+        machine:get_root_hash()
+        for page = 0, PAGES - 1 do
+            machine:write_memory(PMA_RAM_START + page * PAGE_SIZE, page_data(run, page, nonzero_words))
+        end
+        local start = socket.gettime()
+        machine:get_root_hash()
+        local elapsed = socket.gettime() - start
+        table.insert(results, elapsed)
+    end
+    return results
+end
+
+local function measure_all()
+    local results = {}
+    for _, nonzero_words in ipairs(NONZERO_WORDS) do
+        table.insert(results, {
+            nonzero_words = nonzero_words,
+            times = measure(nonzero_words),
+        })
+    end
+    return results
+end
+
+local function average(arr)
+    local avg = 0.0
+    for _, value in ipairs(arr) do
+        avg = avg + value
+    end
+    return avg / #arr
+end
+
+local function stddev(arr)
+    local std2 = 0.0
+    local avg = average(arr)
+    for _, value in ipairs(arr) do
+        std2 = std2 + (value - avg) ^ 2
+    end
+    return math.sqrt(std2 / #arr)
+end
+
+local function print_results(results)
+    io.write("|non-zero words|time per page (us)|\n")
+    for _, result in ipairs(results) do
+        io.write("|")
+        io.write(string.format("%14d", result.nonzero_words))
+        io.write("|")
+        io.write(string.format("%10.3f", average(result.times) * 1000000 / PAGES))
+        if PRINT_STDDEV then io.write(string.format(" +-%9.3f", stddev(result.times) * 1000000 / PAGES)) end
+        io.write("|\n")
+    end
+end
+
+print_results(measure_all())
@@ -140,6 +140,12 @@ public:
         // This runs in microarchitecture.
         // The Host pages affected by writes will be marked dirty by uarch_bridge.
     }
+
+    void save_page_for_rollback(uint64_t address_in_range) {
+        // Dummy implementation here.
+        // This runs in microarchitecture.
+        // The Host pages affected by writes will be saved before they are modified by the host.
+    }
 };
 
 // Provides access to the state of the big emulator from microcode